@@ -450,6 +450,32 @@ optional<variant<terminal::Key, char32_t>> parseKeyOrChar(string const& _name)
     return nullopt;
 }
 
+/// Parses a single codepoint (e.g. "U+E0B0") or a range of codepoints (e.g. "U+2500..U+259F").
+optional<terminal::renderer::CodepointRange> parseCodepointRange(string const& _text)
+{
+    auto const parseCodepoint = [](string_view _value) -> optional<char32_t> {
+        if (_value.size() < 3 || toupper(_value[0]) != 'U' || _value[1] != '+')
+            return nullopt;
+
+        auto const digits = string(_value.substr(2));
+        char* end = nullptr;
+        auto const codepoint = strtoul(digits.c_str(), &end, 16);
+        if (*end != '\0' || codepoint > 0x10FFFF)
+            return nullopt;
+
+        return static_cast<char32_t>(codepoint);
+    };
+
+    auto const text = string_view(_text);
+    auto const separator = text.find("..");
+    auto const first = parseCodepoint(text.substr(0, separator));
+    auto const last = separator != string_view::npos ? parseCodepoint(text.substr(separator + 2)) : first;
+    if (!first.has_value() || !last.has_value() || last.value() < first.value())
+        return nullopt;
+
+    return terminal::renderer::CodepointRange{first.value(), last.value()};
+}
+
 void parseInputMapping(Config& _config, YAML::Node const& _mapping)
 {
 	using namespace terminal;
@@ -1000,6 +1026,14 @@ TerminalProfile loadTerminalProfile(YAML::Node const& _node,
                 profile.maxHistoryLineCount = limit.as<size_t>();
         }
 
+        if (auto residentLimit = history["resident_limit"]; residentLimit)
+        {
+            if (residentLimit.as<int>() < 0)
+                profile.maxResidentHistoryLineCount = nullopt;
+            else
+                profile.maxResidentHistoryLineCount = residentLimit.as<int>();
+        }
+
         softLoadValue(history, "auto_scroll_on_update", profile.autoScrollOnUpdate);
         softLoadValue(history, "scroll_multiplier", profile.historyScrollMultiplier);
     }
@@ -1051,6 +1085,30 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
 
     softLoadValue(doc, "word_delimiters", _config.wordDelimiters);
 
+    if (auto renderer = doc["renderer"]; renderer)
+    {
+        softLoadValue(renderer, "grid_texture", _config.gridRendering);
+
+        auto atlasMemoryBudget = _config.atlasMemoryBudget / (1024 * 1024);
+        softLoadValue(renderer, "atlas_memory_budget", atlasMemoryBudget);
+        if (atlasMemoryBudget > 0)
+            _config.atlasMemoryBudget = atlasMemoryBudget * 1024 * 1024;
+
+        softLoadValue(renderer, "async_rasterization", _config.asyncRasterization);
+
+        if (auto prewarm = renderer["prewarm_glyphs"]; prewarm && prewarm.IsSequence())
+        {
+            _config.prewarmRanges.clear();
+            for (auto const& range : prewarm)
+            {
+                if (auto const parsed = parseCodepointRange(range.as<string>()); parsed.has_value())
+                    _config.prewarmRanges.push_back(parsed.value());
+                else
+                    debuglog(ConfigTag).write("Invalid codepoint range \"{}\" in renderer.prewarm_glyphs.", range.as<string>());
+            }
+        }
+    }
+
     if (auto images = doc["images"]; images)
     {
         softLoadValue(images, "sixel_scrolling", _config.sixelScrolling);
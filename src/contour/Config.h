@@ -37,6 +37,7 @@
 #include <string>
 #include <variant>
 #include <unordered_map>
+#include <vector>
 
 namespace contour::config {
 
@@ -62,6 +63,7 @@ struct TerminalProfile {
     terminal::Size terminalSize;
 
     std::optional<int> maxHistoryLineCount;
+    std::optional<int> maxResidentHistoryLineCount;
     int historyScrollMultiplier;
     bool autoScrollOnUpdate;
 
@@ -120,6 +122,19 @@ struct Config {
     ShaderConfig backgroundShader = terminal::renderer::opengl::defaultShaderConfig(ShaderClass::Background);
     ShaderConfig textShader = terminal::renderer::opengl::defaultShaderConfig(ShaderClass::Text);
 
+    bool gridRendering = false;
+    size_t atlasMemoryBudget = 64 * 1024 * 1024; // video memory (in bytes) each texture atlas may use
+    bool asyncRasterization = true;
+
+    // codepoints whose glyphs are rasterized in the background whenever fonts are loaded:
+    // printable ASCII, Latin-1 Supplement, box drawing and block elements, and powerline symbols
+    std::vector<terminal::renderer::CodepointRange> prewarmRanges = {
+        {0x0021, 0x007E},
+        {0x00A1, 0x00FF},
+        {0x2500, 0x259F},
+        {0xE0A0, 0xE0D4},
+    };
+
     bool sixelScrolling = false;
     bool sixelCursorConformance = true;
     terminal::Size maxImageSize = {2000, 2000};
@@ -572,6 +572,12 @@ void TerminalWidget::onFrameSwapped()
             case State::CleanIdle:
                 renderingPressure_ = false;
                 STATS_ZERO(consecutiveRenderCount);
+                if (terminalView_->renderer().rasterizing())
+                {
+                    // Keep rendering until the glyphs being rasterized in the background have arrived.
+                    update();
+                    return;
+                }
                 if (profile().cursorDisplay == terminal::CursorDisplay::Blink
                         && terminalView_->terminal().cursorVisibility())
                     updateTimer_.start(terminalView_->terminal().nextRender(steady_clock::now()));
@@ -668,16 +674,23 @@ void TerminalWidget::initializeGL()
         make_unique<terminal::renderer::opengl::OpenGLRenderer>(
             *config::Config::loadShaderConfig(config::ShaderClass::Text),
             *config::Config::loadShaderConfig(config::ShaderClass::Background),
+            *config::Config::loadShaderConfig(config::ShaderClass::Grid),
             width(),
             height(),
             0, // TODO left margin
-            0 // TODO bottom margin
+            0, // TODO bottom margin
+            config_.atlasMemoryBudget
         )
     );
 
+    terminalView_->renderer().setGridRendering(config_.gridRendering);
+    terminalView_->renderer().setAsyncRasterization(config_.asyncRasterization);
+    terminalView_->renderer().setPrewarmRanges(config_.prewarmRanges);
+
     terminal::Screen& screen = terminalView_->terminal().screen();
 
     screen.setTabWidth(profile().tabWidth);
+    screen.setMaxResidentHistoryLineCount(profile().maxResidentHistoryLineCount);
 
     // Sixel-scrolling default is *only* loaded during startup and NOT reloading during config file
     // hot reloading, because this value may have changed manually by an application already.
@@ -835,6 +848,11 @@ bool TerminalWidget::reloadConfigValues(config::Config _newConfig, string const&
     terminalView_->terminal().screen().setMaxImageColorRegisters(config_.maxImageColorRegisters);
     terminalView_->terminal().screen().setSixelCursorConformance(config_.sixelCursorConformance);
 
+    terminalView_->renderer().setGridRendering(_newConfig.gridRendering);
+    terminalView_->renderer().setAsyncRasterization(_newConfig.asyncRasterization);
+    terminalView_->renderer().setAtlasMemoryBudget(_newConfig.atlasMemoryBudget);
+    terminalView_->renderer().setPrewarmRanges(_newConfig.prewarmRanges);
+
     config_ = std::move(_newConfig);
     if (config::TerminalProfile *profile = config_.profile(_profileName); profile != nullptr)
         activateProfile(_profileName, *profile);
@@ -1412,7 +1430,7 @@ bool TerminalWidget::executeAction(Action const& _action)
             };
             if (terminalView_->terminal().screen().contains(currentMousePosition))
             {
-                if (auto hyperlink = terminalView_->terminal().screen().at(currentMousePositionRel).hyperlink(); hyperlink != nullptr)
+                if (auto hyperlink = terminalView_->terminal().screen().hyperlinkAt(currentMousePositionRel); hyperlink != nullptr)
                 {
                     followHyperlink(*hyperlink);
                     return Result::Silently;
@@ -1495,6 +1513,7 @@ void TerminalWidget::activateProfile(string const& _name, config::TerminalProfil
         terminalView_->setTerminalSize(newScreenSize);
         // TODO: maybe update margin after this call?
     terminalView_->terminal().screen().setMaxHistoryLineCount(newProfile.maxHistoryLineCount);
+    terminalView_->terminal().screen().setMaxResidentHistoryLineCount(newProfile.maxResidentHistoryLineCount);
 
     terminalView_->setColorProfile(newProfile.colors);
 
@@ -1982,6 +2001,11 @@ void TerminalWidget::dumpState()
 {
     // TODO: log this to debuglog(...)?
     terminalView_->terminal().screen().dumpState("Dump screen state.");
+
+    auto const pty = terminalView_->terminal().ptyStatistics();
+    cerr << fmt::format("PTY bytes read       : {}\n", pty.bytesRead);
+    cerr << fmt::format("PTY reader stalls    : {}\n", pty.readerStalls);
+    cerr << fmt::format("screen updates       : {} ({} saturated)\n", pty.screenUpdates, pty.processorSaturations);
     //XXX terminalView_->renderer().dumpState(std::cout);
 }
 // }}}
@@ -0,0 +1,187 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crispy {
+
+/// Cache of a fixed number of entries, keyed by precomputed 64-bit hashes.
+///
+/// Keys are not stored beyond their hash, so the hash is expected to be wide enough for
+/// collisions to be negligible.
+///
+/// Once full, entries are evicted by the CLOCK algorithm, an approximation of LRU:
+/// a hand sweeps over the entries, sparing (and unmarking) those that have been accessed
+/// since it last passed by, and evicting the first one that has not.
+///
+/// Entries live at fixed positions, so that the values of evicted entries are reused in place
+/// (e.g. retaining the capacity of a std::vector), while lookup goes through an open-addressing
+/// index of at least twice as many slots as there are entries.
+template <typename Value>
+class clock_cache {
+  public:
+    explicit clock_cache(size_t _capacity) :
+        entries_(_capacity),
+        index_(roundUpToPowerOfTwo(2 * _capacity)),
+        mask_{index_.size() - 1}
+    {
+        assert(_capacity > 0);
+    }
+
+    size_t capacity() const noexcept { return entries_.size(); }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    uint64_t hits() const noexcept { return hits_; }
+    uint64_t misses() const noexcept { return misses_; }
+    uint64_t evictions() const noexcept { return evictions_; }
+
+    /// @returns the value for the given key, or nullptr if not present.
+    Value* try_get(uint64_t _key) noexcept
+    {
+        if (auto const slot = find(_key); index_[slot] != Empty)
+        {
+            ++hits_;
+            Entry& entry = entries_[index_[slot] - 1];
+            entry.referenced = true;
+            return &entry.value;
+        }
+
+        ++misses_;
+        return nullptr;
+    }
+
+    /// @returns the value for the given key, which is filled in by @p _fill(Value&) if not present.
+    ///
+    /// The value passed to @p _fill may be the one of an evicted entry.
+    /// References to values remain valid until their entry is evicted.
+    template <typename Fill>
+    Value& get_or_emplace(uint64_t _key, Fill&& _fill)
+    {
+        auto const slot = find(_key);
+        if (index_[slot] != Empty)
+        {
+            ++hits_;
+            Entry& entry = entries_[index_[slot] - 1];
+            entry.referenced = true;
+            return entry.value;
+        }
+
+        ++misses_;
+        auto const entryIndex = allocate();
+        Entry& entry = entries_[entryIndex];
+        entry.key = _key;
+        entry.referenced = false;
+        _fill(entry.value);
+
+        // The slot found above may have moved while evicting, so it is looked up again.
+        index_[find(_key)] = static_cast<uint32_t>(entryIndex + 1);
+        return entry.value;
+    }
+
+    /// Removes all entries, keeping the storage of their values.
+    void clear()
+    {
+        std::fill(index_.begin(), index_.end(), Empty);
+        size_ = 0;
+        hand_ = 0;
+    }
+
+  private:
+    struct Entry {
+        uint64_t key = 0;
+        bool referenced = false;
+        Value value{};
+    };
+
+    static constexpr uint32_t Empty = 0; // index slots refer to entries by their position plus one
+
+    static size_t roundUpToPowerOfTwo(size_t _value) noexcept
+    {
+        size_t result = 1;
+        while (result < _value)
+            result <<= 1;
+        return result;
+    }
+
+    size_t home(uint64_t _key) const noexcept { return static_cast<size_t>(_key) & mask_; }
+
+    /// @returns the index slot of the given key, or the empty slot it would be inserted to.
+    size_t find(uint64_t _key) const noexcept
+    {
+        auto slot = home(_key);
+        while (index_[slot] != Empty && entries_[index_[slot] - 1].key != _key)
+            slot = (slot + 1) & mask_;
+        return slot;
+    }
+
+    /// @returns the position of an unused entry, evicting one if all are in use.
+    size_t allocate()
+    {
+        if (size_ < entries_.size())
+            return size_++;
+
+        for (;;)
+        {
+            auto const current = hand_;
+            hand_ = (hand_ + 1) % entries_.size();
+
+            Entry& entry = entries_[current];
+            if (entry.referenced)
+                entry.referenced = false;
+            else
+            {
+                erase(find(entry.key));
+                ++evictions_;
+                return current;
+            }
+        }
+    }
+
+    /// Removes the given index slot, moving subsequent slots of the same probe sequence back
+    /// so that lookups do not stop short at the gap.
+    void erase(size_t _slot) noexcept
+    {
+        auto gap = _slot;
+        for (auto slot = (gap + 1) & mask_; index_[slot] != Empty; slot = (slot + 1) & mask_)
+        {
+            // Distances along the probe sequence, taking wrap-around into account.
+            auto const desired = home(entries_[index_[slot] - 1].key);
+            if (((slot - desired) & mask_) >= ((slot - gap) & mask_))
+            {
+                index_[gap] = index_[slot];
+                gap = slot;
+            }
+        }
+        index_[gap] = Empty;
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> index_;
+    size_t const mask_;
+
+    size_t size_ = 0;           // number of entries in use, filled up front to back before evicting
+    size_t hand_ = 0;           // position of the next entry to be considered for eviction
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // end namespace
@@ -0,0 +1,86 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/clock_cache.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using namespace std;
+
+TEST_CASE("clock_cache.get_or_emplace")
+{
+    auto cache = crispy::clock_cache<string>(4);
+    auto fills = 0;
+    auto const fill = [&](string const& _text) {
+        return [&, _text](string& _value) { ++fills; _value = _text; };
+    };
+
+    CHECK(cache.get_or_emplace(1, fill("one")) == "one");
+    CHECK(cache.get_or_emplace(2, fill("two")) == "two");
+    CHECK(cache.get_or_emplace(1, fill("uno")) == "one");
+    CHECK(fills == 2);
+    CHECK(cache.size() == 2);
+    CHECK(cache.hits() == 1);
+    CHECK(cache.misses() == 2);
+
+    REQUIRE(cache.try_get(2) != nullptr);
+    CHECK(*cache.try_get(2) == "two");
+    CHECK(cache.try_get(3) == nullptr);
+}
+
+TEST_CASE("clock_cache.eviction")
+{
+    auto cache = crispy::clock_cache<int>(3);
+    for (int i = 1; i <= 3; ++i)
+        cache.get_or_emplace(static_cast<uint64_t>(i), [=](int& _value) { _value = i; });
+
+    // Accessed entries are spared by the next sweep.
+    CHECK(cache.try_get(1) != nullptr);
+    CHECK(cache.try_get(3) != nullptr);
+
+    cache.get_or_emplace(4, [](int& _value) { _value = 4; });
+    CHECK(cache.size() == 3);
+    CHECK(cache.evictions() == 1);
+    CHECK(cache.try_get(2) == nullptr);
+    CHECK(cache.try_get(1) != nullptr);
+    CHECK(cache.try_get(3) != nullptr);
+    CHECK(*cache.try_get(4) == 4);
+}
+
+TEST_CASE("clock_cache.colliding_keys")
+{
+    // Keys sharing the same home slot form a probe sequence that must survive evictions.
+    auto cache = crispy::clock_cache<uint64_t>(4);
+
+    for (uint64_t key = 1; key <= 64; ++key)
+    {
+        auto const hashed = key << 32;
+        CHECK(cache.get_or_emplace(hashed, [=](uint64_t& _value) { _value = hashed; }) == hashed);
+        CHECK(cache.size() <= 4);
+    }
+
+    CHECK(cache.evictions() == 60);
+
+    auto found = 0;
+    for (uint64_t key = 1; key <= 64; ++key)
+    {
+        if (auto const value = cache.try_get(key << 32); value)
+        {
+            CHECK(*value == key << 32);
+            ++found;
+        }
+    }
+    CHECK(found == 4);
+}
@@ -40,6 +40,9 @@ struct range
 template <typename Iter>
 range(Iter, Iter) -> range<Iter>;
 
+template <typename Iter> constexpr Iter begin(range<Iter> const& _range) { return _range.begin(); }
+template <typename Iter> constexpr Iter end(range<Iter> const& _range) { return _range.end(); }
+
 template <typename Container>
 auto reversed(Container && _container)
 {
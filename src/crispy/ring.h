@@ -0,0 +1,215 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace crispy {
+
+/// Contiguous ring buffer with a movable zero-index.
+///
+/// All elements are stored in one std::vector. Rotating the ring (e.g. moving
+/// the front element to the back) is O(1) and does neither allocate nor move
+/// any element, which makes it well suited for scrolling line buffers.
+///
+/// Operations that change the number of elements (push_back, erase, resize)
+/// first linearize the storage and are therefore O(n).
+template <typename T>
+class ring {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = T const&;
+
+    template <typename Ring, typename Value> // {{{ basic_iterator
+    class basic_iterator {
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        basic_iterator() = default;
+        basic_iterator(Ring* _ring, difference_type _index) noexcept : ring_{_ring}, index_{_index} {}
+
+        /// Allows implicit conversion from iterator to const_iterator.
+        template <typename R, typename V, std::enable_if_t<std::is_const_v<Value> && !std::is_const_v<V>, int> = 0>
+        basic_iterator(basic_iterator<R, V> const& _other) noexcept : ring_{_other.ring_}, index_{_other.index_} {}
+
+        reference operator*() const noexcept { return (*ring_)[static_cast<size_type>(index_)]; }
+        pointer operator->() const noexcept { return &**this; }
+        reference operator[](difference_type _n) const noexcept { return *(*this + _n); }
+
+        basic_iterator& operator++() noexcept { ++index_; return *this; }
+        basic_iterator& operator--() noexcept { --index_; return *this; }
+        basic_iterator operator++(int) noexcept { auto old = *this; ++index_; return old; }
+        basic_iterator operator--(int) noexcept { auto old = *this; --index_; return old; }
+
+        basic_iterator& operator+=(difference_type _n) noexcept { index_ += _n; return *this; }
+        basic_iterator& operator-=(difference_type _n) noexcept { index_ -= _n; return *this; }
+
+        friend basic_iterator operator+(basic_iterator _i, difference_type _n) noexcept { return _i += _n; }
+        friend basic_iterator operator+(difference_type _n, basic_iterator _i) noexcept { return _i += _n; }
+        friend basic_iterator operator-(basic_iterator _i, difference_type _n) noexcept { return _i -= _n; }
+        friend difference_type operator-(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ - b.index_; }
+
+        friend bool operator==(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ == b.index_; }
+        friend bool operator!=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ != b.index_; }
+        friend bool operator<(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ < b.index_; }
+        friend bool operator<=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ <= b.index_; }
+        friend bool operator>(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ > b.index_; }
+        friend bool operator>=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ >= b.index_; }
+
+      private:
+        template <typename, typename> friend class basic_iterator;
+
+        Ring* ring_ = nullptr;
+        difference_type index_ = 0;
+    };
+    // }}}
+
+    using iterator = basic_iterator<ring, T>;
+    using const_iterator = basic_iterator<ring const, T const>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    ring() = default;
+    ring(size_type _count, T const& _value) : storage_(_count, _value) {}
+
+    ring(ring const&) = default;
+    ring(ring&&) noexcept = default;
+    ring& operator=(ring const&) = default;
+    ring& operator=(ring&&) noexcept = default;
+
+    size_type size() const noexcept { return storage_.size(); }
+    bool empty() const noexcept { return storage_.empty(); }
+
+    T& operator[](size_type _i) noexcept { return storage_[physicalIndex(_i)]; }
+    T const& operator[](size_type _i) const noexcept { return storage_[physicalIndex(_i)]; }
+
+    T& at(size_type _i) { return storage_.at(physicalIndex(_i)); }
+    T const& at(size_type _i) const { return storage_.at(physicalIndex(_i)); }
+
+    T& front() noexcept { return (*this)[0]; }
+    T const& front() const noexcept { return (*this)[0]; }
+    T& back() noexcept { return (*this)[size() - 1]; }
+    T const& back() const noexcept { return (*this)[size() - 1]; }
+
+    iterator begin() noexcept { return iterator{this, 0}; }
+    iterator end() noexcept { return iterator{this, static_cast<difference_type>(size())}; }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+    const_iterator cbegin() const noexcept { return const_iterator{this, 0}; }
+    const_iterator cend() const noexcept { return const_iterator{this, static_cast<difference_type>(size())}; }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{cend()}; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{cbegin()}; }
+
+    /// Logically rotates the ring to the left by @p _count elements,
+    /// i.e. the first @p _count elements become the last ones.
+    void rotate_left(size_type _count) noexcept
+    {
+        if (!empty())
+            zero_ = (zero_ + _count) % size();
+    }
+
+    /// Logically rotates the ring to the right by @p _count elements,
+    /// i.e. the last @p _count elements become the first ones.
+    void rotate_right(size_type _count) noexcept
+    {
+        if (!empty())
+            zero_ = (zero_ + size() - _count % size()) % size();
+    }
+
+    void reserve(size_type _capacity) { storage_.reserve(_capacity); }
+    size_type capacity() const noexcept { return storage_.capacity(); }
+
+    void push_back(T const& _value) { linearize(); storage_.push_back(_value); }
+    void push_back(T&& _value) { linearize(); storage_.push_back(std::move(_value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... _args)
+    {
+        linearize();
+        return storage_.emplace_back(std::forward<Args>(_args)...);
+    }
+
+    void pop_front(size_type _count = 1)
+    {
+        assert(_count <= size());
+        linearize();
+        storage_.erase(storage_.begin(), std::next(storage_.begin(), static_cast<difference_type>(_count)));
+    }
+
+    iterator erase(const_iterator _first, const_iterator _last)
+    {
+        auto const first = _first - cbegin();
+        auto const last = _last - cbegin();
+        linearize();
+        storage_.erase(std::next(storage_.begin(), first), std::next(storage_.begin(), last));
+        return iterator{this, first};
+    }
+
+    void resize(size_type _count)
+    {
+        linearize();
+        storage_.resize(_count);
+    }
+
+    void clear() noexcept
+    {
+        storage_.clear();
+        zero_ = 0;
+    }
+
+  private:
+    size_type physicalIndex(size_type _i) const noexcept
+    {
+        assert(_i < size());
+        auto const i = zero_ + _i;
+        return i < size() ? i : i - size();
+    }
+
+    /// Physically reorders the underlying storage such that the logical first element is stored first.
+    void linearize()
+    {
+        if (zero_ != 0)
+        {
+            std::rotate(storage_.begin(), std::next(storage_.begin(), static_cast<difference_type>(zero_)), storage_.end());
+            zero_ = 0;
+        }
+    }
+
+  private:
+    std::vector<T> storage_;
+    size_type zero_ = 0;
+};
+
+template <typename T> auto begin(ring<T>& _ring) noexcept { return _ring.begin(); }
+template <typename T> auto end(ring<T>& _ring) noexcept { return _ring.end(); }
+template <typename T> auto begin(ring<T> const& _ring) noexcept { return _ring.cbegin(); }
+template <typename T> auto end(ring<T> const& _ring) noexcept { return _ring.cend(); }
+
+} // end namespace
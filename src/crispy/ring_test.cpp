@@ -0,0 +1,95 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ring.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    template <typename T>
+    vector<T> to_vector(crispy::ring<T> const& _ring)
+    {
+        return vector<T>(_ring.begin(), _ring.end());
+    }
+
+    crispy::ring<int> make_ring(int _count)
+    {
+        auto r = crispy::ring<int>{};
+        for (int i = 0; i < _count; ++i)
+            r.push_back(i);
+        return r;
+    }
+}
+
+TEST_CASE("ring.rotate_left")
+{
+    auto r = make_ring(5);
+    r.rotate_left(2);
+    REQUIRE(to_vector(r) == vector{2, 3, 4, 0, 1});
+    CHECK(r.front() == 2);
+    CHECK(r.back() == 1);
+
+    r.rotate_left(3);
+    REQUIRE(to_vector(r) == vector{0, 1, 2, 3, 4});
+}
+
+TEST_CASE("ring.rotate_right")
+{
+    auto r = make_ring(5);
+    r.rotate_right(1);
+    REQUIRE(to_vector(r) == vector{4, 0, 1, 2, 3});
+
+    r.rotate_right(7);
+    REQUIRE(to_vector(r) == vector{2, 3, 4, 0, 1});
+}
+
+TEST_CASE("ring.push_back_after_rotate")
+{
+    auto r = make_ring(4);
+    r.rotate_left(1);
+    r.push_back(9);
+    REQUIRE(to_vector(r) == vector{1, 2, 3, 0, 9});
+}
+
+TEST_CASE("ring.pop_front")
+{
+    auto r = make_ring(5);
+    r.rotate_left(3);
+    r.pop_front(2);
+    REQUIRE(to_vector(r) == vector{0, 1, 2});
+}
+
+TEST_CASE("ring.erase")
+{
+    auto r = make_ring(6);
+    r.rotate_left(2);
+    r.erase(next(r.begin(), 1), next(r.begin(), 3));
+    REQUIRE(to_vector(r) == vector{2, 5, 0, 1});
+}
+
+TEST_CASE("ring.iterator")
+{
+    auto r = make_ring(5);
+    r.rotate_left(4);
+    CHECK(r.end() - r.begin() == 5);
+    CHECK(*next(r.begin(), 2) == 1);
+    CHECK(*r.rbegin() == 3);
+    std::rotate(r.begin(), next(r.begin(), 1), r.end());
+    REQUIRE(to_vector(r) == vector{0, 1, 2, 3, 4});
+}
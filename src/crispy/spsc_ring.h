@@ -0,0 +1,155 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/span.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace crispy {
+
+/// Lock-free single-producer/single-consumer ring buffer of fixed capacity.
+///
+/// Exactly one thread may produce (writable() / commit()) and exactly one other thread may
+/// consume (readable() / consume()) concurrently. Both sides operate in-place on contiguous
+/// regions of the underlying storage, so that bulk I/O can read into and parse out of the ring
+/// without intermediate copies.
+///
+/// The capacity is rounded up to the next power of two.
+template <typename T>
+class spsc_ring {
+  public:
+    static_assert(std::is_trivially_copyable_v<T>, "spsc_ring is meant for plain data only.");
+
+    explicit spsc_ring(size_t _capacity) :
+        capacity_{roundUpToPowerOfTwo(_capacity)},
+        storage_{std::make_unique<T[]>(capacity_)}
+    {}
+
+    spsc_ring(spsc_ring const&) = delete;
+    spsc_ring& operator=(spsc_ring const&) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /// @returns number of elements available for reading. Safe to be called from either side.
+    size_t size() const noexcept
+    {
+        return writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() == capacity_; }
+
+    // {{{ producer side
+    /// @returns the largest contiguous region that can be written to without overwriting unread data.
+    span<T> writable() noexcept
+    {
+        auto const write = writeIndex_.load(std::memory_order_relaxed);
+        auto const read = readIndex_.load(std::memory_order_acquire);
+        auto const offset = write & (capacity_ - 1);
+        auto const count = std::min(capacity_ - (write - read), capacity_ - offset);
+        return span<T>(storage_.get() + offset, count);
+    }
+
+    /// Publishes @p _count elements, previously written into the region returned by writable().
+    void commit(size_t _count) noexcept
+    {
+        assert(_count <= writable().size());
+        writeIndex_.store(writeIndex_.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+    }
+
+    /// Copies as many elements as fit from the given range into the ring.
+    ///
+    /// @returns number of elements written.
+    size_t write(T const* _data, size_t _count) noexcept
+    {
+        size_t written = 0;
+        while (written < _count)
+        {
+            auto target = writable();
+            if (target.empty())
+                break;
+            auto const n = std::min(target.size(), _count - written);
+            std::copy_n(_data + written, n, target.begin());
+            commit(n);
+            written += n;
+        }
+        return written;
+    }
+    // }}}
+
+    // {{{ consumer side
+    /// @returns the largest contiguous region of unread elements.
+    span<T const> readable() const noexcept
+    {
+        auto const read = readIndex_.load(std::memory_order_relaxed);
+        auto const write = writeIndex_.load(std::memory_order_acquire);
+        auto const offset = read & (capacity_ - 1);
+        auto const count = std::min(write - read, capacity_ - offset);
+        return span<T const>(storage_.get() + offset, count);
+    }
+
+    /// Releases the first @p _count unread elements, making their space available to the producer.
+    void consume(size_t _count) noexcept
+    {
+        assert(_count <= size());
+        readIndex_.store(readIndex_.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+    }
+
+    /// Copies up to @p _count unread elements out of the ring.
+    ///
+    /// @returns number of elements read.
+    size_t read(T* _data, size_t _count) noexcept
+    {
+        size_t done = 0;
+        while (done < _count)
+        {
+            auto const source = readable();
+            if (source.empty())
+                break;
+            auto const n = std::min(source.size(), _count - done);
+            std::copy_n(source.begin(), n, _data + done);
+            consume(n);
+            done += n;
+        }
+        return done;
+    }
+    // }}}
+
+  private:
+    static constexpr size_t roundUpToPowerOfTwo(size_t _value) noexcept
+    {
+        size_t result = 1;
+        while (result < _value)
+            result <<= 1;
+        return result;
+    }
+
+    /// Keeps producer and consumer indices on separate cache lines to avoid false sharing.
+    static constexpr size_t CacheLineSize = 64;
+
+    size_t const capacity_;
+    std::unique_ptr<T[]> storage_;
+
+    // Both indices grow monotonically; the physical offset is obtained by masking with (capacity - 1).
+    alignas(CacheLineSize) std::atomic<size_t> writeIndex_{0};
+    alignas(CacheLineSize) std::atomic<size_t> readIndex_{0};
+};
+
+} // end namespace
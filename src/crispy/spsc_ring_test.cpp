@@ -0,0 +1,87 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/spsc_ring.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+
+using namespace std;
+
+TEST_CASE("spsc_ring.capacity")
+{
+    auto r = crispy::spsc_ring<char>(5);
+    CHECK(r.capacity() == 8);
+    CHECK(r.empty());
+    CHECK(r.writable().size() == 8);
+    CHECK(r.readable().empty());
+}
+
+TEST_CASE("spsc_ring.wrap_around")
+{
+    auto r = crispy::spsc_ring<char>(8);
+
+    CHECK(r.write("abcdef", 6) == 6);
+    char out[8]{};
+    CHECK(r.read(out, 4) == 4);
+    CHECK(string(out, 4) == "abcd");
+
+    // Free space is split: 2 elements at the end, 4 at the beginning.
+    CHECK(r.writable().size() == 2);
+    CHECK(r.write("ghijklmn", 8) == 6);
+    CHECK(r.full());
+
+    CHECK(r.readable().size() == 4);
+    CHECK(r.read(out, 8) == 8);
+    CHECK(string(out, 8) == "efghijkl");
+    CHECK(r.empty());
+}
+
+TEST_CASE("spsc_ring.threads")
+{
+    constexpr size_t Total = 1000000;
+    auto r = crispy::spsc_ring<uint8_t>(1024);
+
+    auto producer = thread([&]() {
+        size_t i = 0;
+        while (i < Total)
+        {
+            auto target = r.writable();
+            auto const n = min(target.size(), Total - i);
+            for (size_t k = 0; k < n; ++k)
+                target[k] = static_cast<uint8_t>(i + k);
+            r.commit(n);
+            i += n;
+            if (n == 0)
+                this_thread::yield();
+        }
+    });
+
+    size_t i = 0;
+    bool ordered = true;
+    while (i < Total)
+    {
+        auto const source = r.readable();
+        for (auto const value : source)
+            ordered = ordered && value == static_cast<uint8_t>(i++);
+        r.consume(source.size());
+        if (source.empty())
+            this_thread::yield();
+    }
+
+    producer.join();
+    CHECK(ordered);
+    CHECK(r.empty());
+}
@@ -69,6 +69,13 @@ class CharsetMapping {
 
     constexpr CharsetTable currentTable() const noexcept { return shift_; }
 
+    /// Tests whether US-ASCII is in effect for all subsequently mapped characters,
+    /// i.e. characters are mapped to themselves.
+    bool isUSASCII() const noexcept
+    {
+        return shift_ == selected_ && tables_[static_cast<size_t>(shift_)] == charsetMap(CharsetId::USASCII);
+    }
+
   private:
     CharsetTable shift_ = CharsetTable::G0;
     CharsetTable selected_ = CharsetTable::G0;
@@ -51,7 +51,7 @@ enum class IndexedColor : uint8_t {
 };
 
 //! Bright colors. As introduced by aixterm, bright versions of standard 3bit colors.
-enum class BrightColor {
+enum class BrightColor : uint8_t {
     Black = 0,
     Red = 1,
     Green = 2,
@@ -141,8 +141,14 @@ constexpr bool operator!=(RGBAColor const& a, RGBAColor const& b) noexcept
     return !(a == b);
 }
 
+/// Color as stored in a grid cell.
+///
+/// All alternatives are at most 3 bytes wide and byte-aligned, so that a Color
+/// occupies 4 bytes (including the discriminator) and can be stored inline in every cell.
 using Color = std::variant<UndefinedColor, DefaultColor, IndexedColor, BrightColor, RGBColor>;
 
+static_assert(sizeof(Color) <= 4, "Color is expected to be stored compactly.");
+
 struct ColorProfile {
     using Palette = std::array<RGBColor, 256>;
 
@@ -26,6 +26,7 @@
 #include <array>
 #include <algorithm>
 #include <numeric>
+#include <optional>
 #include <sstream>
 #include <string>
 
@@ -35,6 +36,8 @@ using crispy::for_each;
 using std::accumulate;
 using std::array;
 using std::for_each;
+using std::nullopt;
+using std::optional;
 using std::pair;
 using std::sort;
 using std::string;
@@ -43,27 +46,125 @@ using std::stringstream;
 
 namespace terminal {
 
+namespace // {{{ function index
+{
+    /// Number of distinct leader symbols: none, '<', '=', '>', '?'.
+    constexpr size_t LeaderCount = 5;
+
+    /// Number of distinct final symbols (C0 functions use their control code as final symbol).
+    constexpr size_t FinalCount = 0x80;
+
+    /// OSC codes below this limit are resolved via direct lookup.
+    constexpr size_t OSCCodeLimit = 1024;
+
+    /// Half-open range of indices into functions() sharing the same category, leader and final symbol.
+    struct FunctionRange {
+        uint8_t first = 0;
+        uint8_t last = 0;
+    };
+
+    constexpr uint8_t NoFunction = 0xFF;
+
+    struct FunctionIndex {
+        std::array<FunctionRange, (static_cast<size_t>(FunctionCategory::DCS) + 1) * LeaderCount * FinalCount> sequences{};
+        std::array<uint8_t, OSCCodeLimit> osc{};
+    };
+
+    constexpr optional<size_t> sequenceSlot(FunctionCategory _category, char _leader, char _final) noexcept
+    {
+        auto const final = static_cast<unsigned char>(_final);
+        if (final >= FinalCount)
+            return nullopt;
+
+        size_t leader = 0;
+        if (_leader)
+        {
+            if (_leader < 0x3C || _leader > 0x3F)
+                return nullopt;
+            leader = static_cast<size_t>(_leader - 0x3C + 1);
+        }
+
+        return (static_cast<size_t>(_category) * LeaderCount + leader) * FinalCount + final;
+    }
+
+    template <typename Functions>
+    constexpr FunctionIndex createFunctionIndex(Functions const& _funcs) noexcept
+    {
+        static_assert(std::tuple_size_v<Functions> < NoFunction, "Function index must fit into a byte.");
+
+        auto index = FunctionIndex{};
+        for (size_t i = 0; i < index.osc.size(); ++i)
+            index.osc[i] = NoFunction;
+
+        // Functions are sorted by category, final symbol, and leader,
+        // hence all candidates for one slot are stored consecutively.
+        for (size_t i = 0; i < _funcs.size(); ++i)
+        {
+            auto const& f = _funcs[i];
+            if (f.category == FunctionCategory::OSC)
+            {
+                if (static_cast<size_t>(f.maximumParameters) < OSCCodeLimit)
+                    index.osc[static_cast<size_t>(f.maximumParameters)] = static_cast<uint8_t>(i);
+            }
+            else if (auto const slot = sequenceSlot(f.category, f.leader, f.finalSymbol); slot.has_value())
+            {
+                auto& range = index.sequences[*slot];
+                if (range.first == range.last)
+                    range.first = static_cast<uint8_t>(i);
+                range.last = static_cast<uint8_t>(i + 1);
+            }
+        }
+
+        return index;
+    }
+
+    template <typename Functions>
+    FunctionDefinition const* binarySearch(Functions const& _funcs, FunctionSelector const& _selector) noexcept
+    {
+        int a = 0;
+        int b = static_cast<int>(_funcs.size()) - 1;
+        while (a <= b)
+        {
+            auto const i = (a + b) / 2;
+            auto const& I = _funcs[i];
+            auto const rel = compare(_selector, I);
+            if (rel > 0)
+                a = i + 1;
+            else if (rel < 0)
+                b = i - 1;
+            else
+                return &I;
+        }
+        return nullptr;
+    }
+} // }}}
+
 FunctionDefinition const* select(FunctionSelector const& _selector) noexcept
 {
     auto static const& funcs = functions();
+    auto static const index = createFunctionIndex(funcs);
 
     //std::cout << fmt::format("select: {}\n", _selector);
 
-    int a = 0;
-    int b = static_cast<int>(funcs.size()) - 1;
-    while (a <= b)
+    if (_selector.category == FunctionCategory::OSC)
     {
-        auto const i = (a + b) / 2;
-        auto const& I = funcs[i];
-        auto const rel = compare(_selector, I);
-        //std::cout << fmt::format(" - a:{:>2} b:{:>2} i:{} rel:{} I: {}\n", a, b, i, rel < 0 ? '<' : rel > 0 ? '>' : '=', I);
-        if (rel > 0)
-            a = i + 1;
-        else if (rel < 0)
-            b = i - 1;
-        else
-            return &I;
+        if (_selector.argc < 0 || static_cast<size_t>(_selector.argc) >= OSCCodeLimit)
+            return binarySearch(funcs, _selector);
+
+        auto const i = index.osc[static_cast<size_t>(_selector.argc)];
+        return i != NoFunction ? &funcs[i] : nullptr;
     }
+
+    auto const slot = sequenceSlot(_selector.category, _selector.leader, _selector.finalSymbol);
+    if (!slot.has_value())
+        return nullptr;
+
+    // Usually one, at most a handful of candidates, differing in intermediate or parameter count.
+    auto const range = index.sequences[*slot];
+    for (auto i = range.first; i < range.last; ++i)
+        if (compare(_selector, funcs[i]) == 0)
+            return &funcs[i];
+
     return nullptr;
 }
 
@@ -70,3 +70,19 @@ TEST_CASE("Functions.OSC777", "[Functions]")
     REQUIRE(osc);
     CHECK(*osc == NOTIFY);
 }
+
+TEST_CASE("Functions.select_all", "[Functions]")
+{
+    for (FunctionDefinition const& f: functions())
+    {
+        auto const argc = f.category == FunctionCategory::OSC ? f.maximumParameters : f.minimumParameters;
+        FunctionDefinition const* s = terminal::select({f.category, f.leader, argc, f.intermediate, f.finalSymbol});
+        REQUIRE(s);
+        CHECK(*s == f);
+    }
+
+    CHECK(terminal::selectControl(0, 1, 0, 'u') == nullptr); // ANSISYSSC takes no parameters
+    CHECK(terminal::selectControl('?', 0, 0, 'm') == nullptr);
+    CHECK(terminal::selectControl(0, 0, 0, '\x7F') == nullptr);
+    CHECK(terminal::selectOSCommand(4242) == nullptr);
+}
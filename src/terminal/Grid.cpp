@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <terminal/Grid.h>
+#include <terminal/HistoryPager.h>
 
 #include <crispy/Comparison.h>
 #include <crispy/indexed.h>
@@ -20,7 +21,9 @@
 #include <unicode/convert.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <tuple>
 #include <utility>
@@ -28,10 +31,12 @@
 using crispy::Comparison;
 
 using std::back_inserter;
+using std::clamp;
 using std::fill_n;
 using std::for_each;
 using std::front_inserter;
 using std::generate_n;
+using std::max;
 using std::min;
 using std::move;
 using std::next;
@@ -68,6 +73,67 @@ namespace // {{{ helper
     }
 }
 // }}}
+// {{{ GraphicsRenditionDelta
+void GraphicsRenditionDelta::add(GraphicsRendition _rendition) noexcept
+{
+    auto const setStyle = [this](unsigned _mask) {
+        set = set.mask() | _mask;
+        clear = clear.mask() & ~_mask;
+    };
+    auto const clearStyle = [this](unsigned _mask) {
+        set = set.mask() & ~_mask;
+        clear = clear.mask() | _mask;
+    };
+
+    switch (_rendition)
+    {
+        case GraphicsRendition::Reset:
+            *this = GraphicsRenditionDelta{};
+            reset = true;
+            break;
+        case GraphicsRendition::Bold: setStyle(CharacterStyleMask::Bold); break;
+        case GraphicsRendition::Faint: setStyle(CharacterStyleMask::Faint); break;
+        case GraphicsRendition::Italic: setStyle(CharacterStyleMask::Italic); break;
+        case GraphicsRendition::Underline: setStyle(CharacterStyleMask::Underline); break;
+        case GraphicsRendition::Blinking: setStyle(CharacterStyleMask::Blinking); break;
+        case GraphicsRendition::Inverse: setStyle(CharacterStyleMask::Inverse); break;
+        case GraphicsRendition::Hidden: setStyle(CharacterStyleMask::Hidden); break;
+        case GraphicsRendition::CrossedOut: setStyle(CharacterStyleMask::CrossedOut); break;
+        case GraphicsRendition::DoublyUnderlined: setStyle(CharacterStyleMask::DoublyUnderlined); break;
+        case GraphicsRendition::CurlyUnderlined: setStyle(CharacterStyleMask::CurlyUnderlined); break;
+        case GraphicsRendition::DottedUnderline: setStyle(CharacterStyleMask::DottedUnderline); break;
+        case GraphicsRendition::DashedUnderline: setStyle(CharacterStyleMask::DashedUnderline); break;
+        case GraphicsRendition::Framed: setStyle(CharacterStyleMask::Framed); break;
+        case GraphicsRendition::Overline: setStyle(CharacterStyleMask::Overline); break;
+        case GraphicsRendition::Normal: clearStyle(CharacterStyleMask::Bold | CharacterStyleMask::Faint); break;
+        case GraphicsRendition::NoItalic: clearStyle(CharacterStyleMask::Italic); break;
+        case GraphicsRendition::NoUnderline: clearStyle(CharacterStyleMask::Underline); break;
+        case GraphicsRendition::NoBlinking: clearStyle(CharacterStyleMask::Blinking); break;
+        case GraphicsRendition::NoInverse: clearStyle(CharacterStyleMask::Inverse); break;
+        case GraphicsRendition::NoHidden: clearStyle(CharacterStyleMask::Hidden); break;
+        case GraphicsRendition::NoCrossedOut: clearStyle(CharacterStyleMask::CrossedOut); break;
+        case GraphicsRendition::NoFramed: clearStyle(CharacterStyleMask::Framed); break;
+        case GraphicsRendition::NoOverline: clearStyle(CharacterStyleMask::Overline); break;
+    }
+}
+
+void GraphicsRenditionDelta::applyTo(GraphicsAttributes& _attributes) const noexcept
+{
+    if (reset)
+        _attributes = GraphicsAttributes{};
+
+    _attributes.styles = (_attributes.styles.mask() & ~clear.mask()) | set.mask();
+
+    if (foregroundColor.has_value())
+        _attributes.foregroundColor = *foregroundColor;
+
+    if (backgroundColor.has_value())
+        _attributes.backgroundColor = *backgroundColor;
+
+    if (underlineColor.has_value())
+        _attributes.underlineColor = *underlineColor;
+}
+// }}}
 // {{{ Cell impl
 string Cell::toUtf8() const
 {
@@ -104,9 +170,105 @@ Line::Line(int _numCols, std::string_view const& _s, Flags _flags) :
         buffer_.at(i).setCharacter(ch);
 }
 
+Line::Line(PackedCells _packed, Flags _flags) :
+    packed_{ std::make_unique<PackedCells>(std::move(_packed)) },
+    flags_{ static_cast<unsigned>(_flags) }
+{
+}
+
+// Copies are independent lines that may diverge from their origin, hence they never share its revision.
+Line::Line(Line const& _other) :
+    buffer_{ _other.buffer_ },
+    packed_{ _other.packed_ ? std::make_unique<PackedCells>(*_other.packed_) : nullptr },
+    flags_{ _other.flags_ }
+{
+}
+
+Line::Line(Line&& _other) noexcept :
+    buffer_{ move(_other.buffer_) },
+    packed_{ move(_other.packed_) },
+    flags_{ _other.flags_ },
+    id_{ std::exchange(_other.id_, nextId()) },
+    version_{ std::exchange(_other.version_, 0) }
+{
+}
+
+Line& Line::operator=(Line const& _other)
+{
+    buffer_ = _other.buffer_;
+    packed_ = _other.packed_ ? std::make_unique<PackedCells>(*_other.packed_) : nullptr;
+    flags_ = _other.flags_;
+    id_ = nextId();
+    version_ = 0;
+    return *this;
+}
+
+Line& Line::operator=(Line&& _other) noexcept
+{
+    buffer_ = move(_other.buffer_);
+    packed_ = move(_other.packed_);
+    flags_ = _other.flags_;
+    id_ = std::exchange(_other.id_, nextId());
+    version_ = std::exchange(_other.version_, 0);
+    return *this;
+}
+
+uint64_t Line::nextId() noexcept
+{
+    static std::atomic<uint64_t> lastId = 0;
+    return ++lastId;
+}
+
+void Line::unpackSlow()
+{
+    auto const packed = move(packed_);
+    auto codepoint = packed->codepoints.begin();
+
+    buffer_.clear();
+    buffer_.reserve(packed->codepoints.size());
+    for (AttributeRun const& run : packed->runs)
+        for (int i = 0; i < run.length; ++i)
+            buffer_.emplace_back(*codepoint++, run.attributes);
+}
+
+Cell Line::cellAt(int _index) const
+{
+    // compacted lines may not hold all columns
+    if (_index >= size())
+        return Cell{};
+
+    if (!packed_)
+        return buffer_[static_cast<size_t>(_index)];
+
+    auto runStart = 0;
+    for (AttributeRun const& run : packed_->runs)
+    {
+        if (_index < runStart + run.length)
+            return Cell{packed_->codepoints[static_cast<size_t>(_index)], run.attributes};
+        runStart += run.length;
+    }
+
+    return Cell{};
+}
+
 string Line::toUtf8() const
 {
     string s;
+    if (packed_)
+    {
+        s.resize(packed_->codepoints.size() * 4);
+        auto t = s.data();
+        for (char32_t const codepoint : packed_->codepoints)
+        {
+            if (codepoint)
+                t = unicode::encoder<char>{}(codepoint, t);
+            else
+                *t++ = ' '; // NB: empty cells are represented as space.
+        }
+        s.resize(std::distance(s.data(), t));
+        return s;
+    }
+
     s.resize(size() * 4);
     auto t = s.data();
     for (Cell const& cell : crispy::range(begin(), next(begin(), size())))
@@ -127,21 +289,25 @@ string Line::toUtf8() const
 
 void Line::prepend(Buffer const& _cells)
 {
+    modify();
     buffer_.insert(buffer_.begin(), _cells.begin(), _cells.end());
 }
 
 void Line::append(Buffer const& _cells)
 {
+    modify();
     buffer_.insert(buffer_.end(), _cells.begin(), _cells.end());
 }
 
 void Line::append(int _count, Cell const& _initial)
 {
+    modify();
     fill_n(back_inserter(buffer_), _count, _initial);
 }
 
-crispy::range<Line::const_iterator> Line::trim_blank_right() const
+crispy::range<Line::const_iterator> Line::trim_blank_right()
 {
+    unpack();
     auto i = buffer_.cbegin();
     auto e = buffer_.cend();
 
@@ -153,6 +319,7 @@ crispy::range<Line::const_iterator> Line::trim_blank_right() const
 
 Line::Buffer Line::shift_left(int _count, Cell const& _fill)
 {
+    modify();
     auto const actualShiftCount = min(_count, size());
     auto const from = std::begin(buffer_);
     auto const to = std::next(std::begin(buffer_), actualShiftCount);
@@ -169,6 +336,7 @@ Line::Buffer Line::shift_left(int _count, Cell const& _fill)
 
 Line::Buffer Line::remove(iterator const& _from, iterator const& _to)
 {
+    touch();
     auto removedColumns = Buffer(_from, _to);
     buffer_.erase(_from, _to);
     return removedColumns;
@@ -176,23 +344,95 @@ Line::Buffer Line::remove(iterator const& _from, iterator const& _to)
 
 void Line::setText(std::string_view _u8string)
 {
+    modify();
     for (auto const [i, ch] : crispy::indexed(unicode::convert_to<char32_t>(_u8string)))
         buffer_.at(i).setCharacter(ch);
 }
 
 void Line::resize(int _size)
 {
+    modify();
     if (_size >= 0)
         buffer_.resize(static_cast<int>(_size));
 }
 
+void Line::compact()
+{
+    if (packed_)
+        return;
+
+    auto const isDefaultBlank = [](Cell const& _cell) {
+        return is_blank(_cell) && !_cell.hyperlink() && _cell.attributes() == GraphicsAttributes{};
+    };
+
+    auto e = buffer_.end();
+    while (e != buffer_.begin() && isDefaultBlank(*prev(e)))
+        e = prev(e);
+
+    if (e != buffer_.end())
+    {
+        buffer_.erase(e, buffer_.end());
+        touch();
+    }
+
+    // Cells are packable if they can be reconstructed from their first codepoint and attributes alone.
+    auto const isPackable = [](Cell const& _cell) {
+        if (_cell.codepointCount() > 1 || _cell.hyperlink() || _cell.imageFragment())
+            return false;
+        auto const codepoint = _cell.codepoint(0);
+        auto const expectedWidth = codepoint ? max(unicode::width(codepoint), 1) : 1;
+        return _cell.width() == expectedWidth;
+    };
+
+    if (buffer_.empty() || !std::all_of(buffer_.begin(), buffer_.end(), isPackable))
+    {
+        buffer_.shrink_to_fit();
+        return;
+    }
+
+    auto packed = std::make_unique<PackedCells>();
+    packed->codepoints.reserve(buffer_.size());
+    for (Cell const& cell : buffer_)
+    {
+        packed->codepoints.push_back(cell.codepoint(0));
+        if (!packed->runs.empty() && packed->runs.back().attributes == cell.attributes())
+            packed->runs.back().length++;
+        else
+            packed->runs.emplace_back(AttributeRun{1, cell.attributes()});
+    }
+    packed->runs.shrink_to_fit();
+
+    packed_ = move(packed);
+    buffer_ = Buffer{};
+}
+
+void Line::reset(int _numCols, Cell const& _defaultCell, Flags _flags)
+{
+    touch();
+    packed_.reset();
+    buffer_.assign(static_cast<size_t>(_numCols), _defaultCell);
+    flags_ = static_cast<unsigned>(_flags);
+}
+
+void Line::release()
+{
+    touch();
+    packed_.reset();
+    buffer_ = Buffer{};
+}
+
 bool Line::blank() const noexcept
 {
+    if (packed_)
+        return std::all_of(packed_->codepoints.begin(), packed_->codepoints.end(),
+                           [](char32_t _codepoint) { return _codepoint == 0; });
+
     return std::all_of(cbegin(), cend(), is_blank);
 }
 
 Line::Buffer Line::reflow(int _newColumnCount)
 {
+    modify();
     switch (crispy::strongCompare(_newColumnCount, size()))
     {
         case Comparison::Equal:
@@ -252,6 +492,10 @@ Grid::Grid(Size _screenSize, bool _reflowOnResize, optional<int> _maxHistoryLine
 {
 }
 
+Grid::~Grid() = default;
+Grid::Grid(Grid&&) noexcept = default;
+Grid& Grid::operator=(Grid&&) noexcept = default;
+
 /**
  * Appends logical line by splitting into fixed-width lines.
  *
@@ -297,6 +541,9 @@ void Grid::setMaxHistoryLineCount(optional<int> _maxHistoryLineCount)
 
 Coordinate Grid::resize(Size _newSize, Coordinate _currentCursorPos, bool _wrapPending)
 {
+    // Reflow and line splicing operate on all lines, so bring everything back into memory first.
+    discardHistoryPages();
+
     auto const growLines = [this](int _newHeight) -> Coordinate
     {
         // Grow line count by splicing available lines from history back into buffer, if available,
@@ -374,7 +621,6 @@ Coordinate Grid::resize(Size _newSize, Coordinate _currentCursorPos, bool _wrapP
                      line.toUtf8(),
                      Line(Line::Buffer(logicalLineBuffer), line.flags()).toUtf8(),
                      line.wrapped() ? "WRAPPED" : "");
-                assert(line.size() >= screenSize_.width);
 
                 if (line.wrapped())
                 {
@@ -534,6 +780,16 @@ Coordinate Grid::resize(Size _newSize, Coordinate _currentCursorPos, bool _wrapP
             break;
     }
 
+    // Reflow and column growth did inflate history lines, so compact them again.
+    for (Line& line : crispy::range(lines_.begin(), next(lines_.begin(), max(historyLineCount(), 0))))
+        line.compact();
+
+    for (Line& line : mainPage())
+        if (line.size() < screenSize_.width)
+            line.resize(screenSize_.width);
+
+    pageOut();
+
     return cursorPosition;
 }
 
@@ -543,19 +799,49 @@ void Grid::appendNewLines(int _count, GraphicsAttributes _attr)
 
     if (auto const n = min(_count, screenSize_.height); n > 0)
     {
+        // Lines that would be dropped off the top of the scrollback anyway are rotated
+        // to the bottom and reused in-place, so that scrolling a full history does not allocate.
+        auto const recycleCount = maxHistoryLineCount_.has_value()
+            ? clamp(historyLineCount() + n - maxHistoryLineCount_.value(), 0, n)
+            : 0;
+
+        if (recycleCount > 0)
+        {
+            lines_.rotate_left(static_cast<size_t>(recycleCount));
+            dropHistoryLines(recycleCount);
+
+            for (Line& line : lines(static_cast<int>(lines_.size()) - recycleCount, static_cast<int>(lines_.size())))
+                line.reset(screenSize_.width, Cell{{}, _attr}, wrappableFlag);
+
+            // any line that moves into history is using the default Wrappable flag.
+            auto const historyStart = max(0, historyLineCount() - recycleCount);
+            for (Line& line : lines(historyStart, historyLineCount()))
+                line.setFlag(Line::Flags::Wrappable, true);
+        }
+
         generate_n(
             back_inserter(lines_),
-            n,
+            n - recycleCount,
             [&]() { return Line(screenSize_.width, Cell{{}, _attr}, wrappableFlag); }
         );
+
+        // Lines that just moved into history do not need to keep their trailing blank cells.
+        auto const historyEnd = historyLineCount();
+        for (Line& line : crispy::range(next(lines_.begin(), max(historyEnd - n, 0)), next(lines_.begin(), max(historyEnd, 0))))
+            line.compact();
+
         clampHistory();
+        pageOut();
     }
 }
 
 void Grid::clearHistory()
 {
-    if (historyLineCount())
-        lines_.erase(begin(lines_), next(begin(lines_), historyLineCount()));
+    if (auto const count = historyLineCount(); count > 0)
+    {
+        lines_.pop_front(static_cast<size_t>(count));
+        dropHistoryLines(count);
+    }
 }
 
 void Grid::clampHistory()
@@ -582,7 +868,8 @@ void Grid::clampHistory()
         line.setFlag(Line::Flags::Wrappable, wrappable);
     }
 
-    lines_.erase(begin(lines_), next(begin(lines_), diff));
+    lines_.pop_front(static_cast<size_t>(diff));
+    dropHistoryLines(diff);
 }
 
 void Grid::scrollUp(int _n, GraphicsAttributes const& _defaultAttributes, Margin const& _margin)
@@ -622,7 +909,7 @@ void Grid::scrollUp(int _n, GraphicsAttributes const& _defaultAttributes, Margin
             );
         }
 #else
-        for_each(
+        std::for_each(
             topLine,
             bottomLine,
             [&](Line& line) {
@@ -656,7 +943,7 @@ void Grid::scrollUp(int _n, GraphicsAttributes const& _defaultAttributes, Margin
             );
         }
 
-        for_each(
+        std::for_each(
             LIBTERMINAL_EXECUTION_COMMA(par)
             next(begin(mainPage()), _margin.vertical.to - n),
             next(begin(mainPage()), _margin.vertical.to),
@@ -698,7 +985,7 @@ void Grid::scrollDown(int v_n, GraphicsAttributes const& _defaultAttributes, Mar
                 next(begin(*targetLine), _margin.horizontal.from - 1)
             );
 
-            for_each(
+            std::for_each(
                 next(begin(mainPage()), _margin.vertical.from - 1),
                 next(begin(mainPage()), _margin.vertical.from - 1 + n),
                 [&](Line& line) {
@@ -713,7 +1000,7 @@ void Grid::scrollDown(int v_n, GraphicsAttributes const& _defaultAttributes, Mar
         else
         {
             // clear everything in margin
-            for_each(
+            std::for_each(
                 next(begin(mainPage()), _margin.vertical.from - 1),
                 next(begin(mainPage()), _margin.vertical.to),
                 [&](Line& line) {
@@ -734,7 +1021,7 @@ void Grid::scrollDown(int v_n, GraphicsAttributes const& _defaultAttributes, Mar
             end(mainPage())
         );
 
-        for_each(
+        std::for_each(
             begin(mainPage()),
             next(begin(mainPage()), n),
             [&](Line& line) {
@@ -755,7 +1042,7 @@ void Grid::scrollDown(int v_n, GraphicsAttributes const& _defaultAttributes, Mar
             next(begin(mainPage()), _margin.vertical.to)
         );
 
-        for_each(
+        std::for_each(
             next(begin(mainPage()), _margin.vertical.from - 1),
             next(begin(mainPage()), _margin.vertical.from - 1 + n),
             [&](Line& line) {
@@ -769,6 +1056,193 @@ void Grid::scrollDown(int v_n, GraphicsAttributes const& _defaultAttributes, Mar
     }
 }
 
+void Grid::markHyperlinks(std::vector<bool>& _used) const
+{
+    for (Line const& line : lines_)
+    {
+        if (line.packed())
+            continue;
+
+        for (Cell const& cell : line)
+        {
+            if (auto const id = cell.hyperlink(); id != HyperlinkStorage::None)
+            {
+                if (id >= _used.size())
+                    _used.resize(id + 1u);
+                _used[id] = true;
+            }
+        }
+    }
+}
+
+// {{{ history paging
+void Grid::setMaxResidentHistoryLineCount(optional<int> _count)
+{
+    maxResidentHistoryLineCount_ = _count;
+
+    if (maxResidentHistoryLineCount_.has_value())
+        pageOut();
+    else
+        discardHistoryPages();
+}
+
+std::pair<int, int> Grid::historyLinesOfPage(PageId _page) const noexcept
+{
+    auto const first = static_cast<int>(_page * LinesPerHistoryPage - droppedLineCount_);
+    auto const last = first + LinesPerHistoryPage;
+    return {max(first, 0), min(last, historyLineCount())};
+}
+
+void Grid::pageInSlow(int _start, int _end)
+{
+    _start = max(_start, 0);
+    _end = min(_end, historyLineCount());
+    if (_start >= _end)
+        return;
+
+    for (auto page = pageOf(_start); page <= pageOf(_end - 1); ++page)
+    {
+        pageAccessTime_[page] = ++pageAccessTick_;
+
+        if (!pagedOutPages_.erase(page))
+            continue;
+
+        auto const [first, last] = historyLinesOfPage(page);
+        auto const skip = first - static_cast<int>(page * LinesPerHistoryPage - droppedLineCount_);
+        auto const pageLines = crispy::range(next(lines_.begin(), first), next(lines_.begin(), last));
+
+        if (!historyPager_->load(page, skip, pageLines))
+        {
+            // The paged data is not available anymore. Do not leave the lines in an invalid state.
+            for (Line& line : pageLines)
+                line.reset(screenSize_.width, Cell{}, Line::Flags::Wrappable);
+        }
+        else
+        {
+            for (Line& line : pageLines)
+                line.compact();
+            pagedInPages_[page] = pageStateOf(first, last);
+        }
+    }
+}
+
+Grid::PageState Grid::pageStateOf(int _first, int _last) const
+{
+    PageState state;
+    state.reserve(static_cast<size_t>(_last - _first));
+    for (int i = _first; i < _last; ++i)
+    {
+        Line const& line = lines_[static_cast<size_t>(i)];
+        state.emplace_back(line.revision(), line.flags());
+    }
+    return state;
+}
+
+void Grid::pageOut()
+{
+    if (!maxResidentHistoryLineCount_.has_value() || historyLineCount() <= 0)
+        return;
+
+    // Only pages with all of their lines present in history are paged out.
+    auto const firstPage = pageOf(0);
+    auto const firstCompletePage = droppedLineCount_ % LinesPerHistoryPage == 0 ? firstPage : firstPage + 1;
+    auto const lastCompletePage = pageOf(historyLineCount()) - 1;
+    auto const totalPageCount = pageOf(historyLineCount() - 1) - firstPage + 1;
+    auto const maxResidentPageCount = (max(maxResidentHistoryLineCount_.value(), 0) + LinesPerHistoryPage - 1)
+                                    / LinesPerHistoryPage;
+    auto residentPageCount = totalPageCount - static_cast<PageId>(pagedOutPages_.size());
+
+    while (residentPageCount > maxResidentPageCount)
+    {
+        // Find least recently used page that is fully in history.
+        optional<PageId> victim;
+        auto victimAccessTime = std::numeric_limits<uint64_t>::max();
+        for (auto page = firstCompletePage; page <= lastCompletePage; ++page)
+        {
+            if (pagedOutPages_.count(page) || unpageablePages_.count(page))
+                continue;
+
+            auto const accessTime = [&]() -> uint64_t {
+                auto const i = pageAccessTime_.find(page);
+                return i != pageAccessTime_.end() ? i->second : 0;
+            }();
+
+            if (accessTime < victimAccessTime)
+            {
+                victim = page;
+                victimAccessTime = accessTime;
+                if (accessTime == 0)
+                    break;
+            }
+        }
+
+        if (!victim.has_value())
+            break;
+
+        if (!historyPager_)
+            historyPager_ = std::make_unique<HistoryPager>();
+
+        auto const [first, last] = historyLinesOfPage(*victim);
+        auto const pageLines = crispy::range(next(lines_.begin(), first), next(lines_.begin(), last));
+
+        // A page that has been paged in before does not need to be rewritten, unless it got modified since.
+        auto const unmodified = [&, first = first, last = last]() {
+            auto const i = pagedInPages_.find(*victim);
+            return i != pagedInPages_.end()
+                && historyPager_->contains(*victim)
+                && i->second == pageStateOf(first, last);
+        }();
+        pagedInPages_.erase(*victim);
+
+        if (!unmodified
+                && !historyPager_->store(*victim, crispy::range<Lines::const_iterator>(pageLines.begin(), pageLines.end())))
+        {
+            historyPager_->erase(*victim);
+            unpageablePages_.insert(*victim);
+            continue;
+        }
+
+        for (Line& line : pageLines)
+            line.release();
+
+        pagedOutPages_.insert(*victim);
+        pageAccessTime_.erase(*victim);
+        --residentPageCount;
+    }
+}
+
+void Grid::dropHistoryLines(int _count)
+{
+    droppedLineCount_ += _count;
+
+    if (!historyPager_)
+        return;
+
+    auto const firstPage = pageOf(0);
+    auto const eraseBefore = [&](auto& _container) {
+        _container.erase(_container.begin(), _container.lower_bound(firstPage));
+    };
+    eraseBefore(pagedOutPages_);
+    eraseBefore(unpageablePages_);
+    eraseBefore(pageAccessTime_);
+    eraseBefore(pagedInPages_);
+    historyPager_->eraseBefore(firstPage);
+}
+
+void Grid::discardHistoryPages()
+{
+    if (!historyPager_)
+        return;
+
+    pageInSlow(0, historyLineCount());
+    pagedOutPages_.clear();
+    unpageablePages_.clear();
+    pageAccessTime_.clear();
+    pagedInPages_.clear();
+    historyPager_->clear();
+}
+// }}}
+
 string Grid::renderTextLineAbsolute(int row) const
 {
     string line;
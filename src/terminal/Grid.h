@@ -23,6 +23,7 @@
 #include <crispy/range.h>
 #include <crispy/span.h>
 #include <crispy/indexed.h>
+#include <crispy/ring.h>
 #include <crispy/times.h>
 #include <crispy/utils.h>
 
@@ -34,6 +35,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <list>
@@ -90,7 +92,7 @@ class CharacterStyleMask {
 
 	constexpr CharacterStyleMask() : mask_{} {}
 	constexpr CharacterStyleMask(Mask m) : mask_{m} {}
-	constexpr CharacterStyleMask(unsigned m) : mask_{m} {}
+	constexpr CharacterStyleMask(unsigned m) : mask_{static_cast<uint16_t>(m)} {}
 	constexpr CharacterStyleMask(CharacterStyleMask const& _other) noexcept : mask_{_other.mask_} {}
 
 	constexpr CharacterStyleMask& operator=(CharacterStyleMask const& _other) noexcept
@@ -104,7 +106,7 @@ class CharacterStyleMask {
 	constexpr operator unsigned () const noexcept { return mask_; }
 
   private:
-	unsigned mask_;
+	uint16_t mask_;
 };
 
 std::string to_string(CharacterStyleMask _mask);
@@ -177,6 +179,25 @@ struct GraphicsAttributes {
     }
 };
 
+/// Accumulated effect of one or more SGR parameters on the current graphics attributes.
+///
+/// A whole SGR sequence is folded into a single delta, which is then applied
+/// to the cursor's graphics rendition at once.
+struct GraphicsRenditionDelta {
+    /// Start over from the default attributes before applying the remaining changes.
+    bool reset = false;
+    CharacterStyleMask set{};
+    CharacterStyleMask clear{};
+    std::optional<Color> foregroundColor;
+    std::optional<Color> backgroundColor;
+    std::optional<Color> underlineColor;
+
+    /// Folds the given rendition into this delta, as if applied after all previously folded ones.
+    void add(GraphicsRendition _rendition) noexcept;
+
+    void applyTo(GraphicsAttributes& _attributes) const noexcept;
+};
+
 constexpr bool operator==(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
 {
     return a.backgroundColor == b.backgroundColor
@@ -192,83 +213,151 @@ constexpr bool operator!=(GraphicsAttributes const& a, GraphicsAttributes const&
 // }}}
 
 // {{{ Cell
+/// Rarely used cell properties, stored out of line.
+///
+/// Only cells that carry a grapheme cluster of more than one codepoint
+/// or an image fragment do allocate one of these.
+struct CellExtra {
+    /// All codepoints of the grapheme cluster (including the first one)
+    /// if the cell holds more than one codepoint, empty otherwise.
+    std::u32string codepoints{};
+
+    /// Image fragment to be rendered in this cell.
+    std::optional<ImageFragment> imageFragment{};
+
+    bool empty() const noexcept { return codepoints.empty() && !imageFragment; }
+};
+
 /// Grid cell with character and graphics rendition information.
+///
+/// The cell itself only stores what almost every cell needs: the first codepoint,
+/// the graphics attributes, the cell width and the ID of the hyperlink (see HyperlinkStorage).
+/// Everything else lives in a lazily allocated CellExtra, keeping the common case small
+/// and cache friendly.
 class Cell {
   public:
     static size_t constexpr MaxCodepoints = 9;
 
     Cell(char32_t _ch, GraphicsAttributes _attrib) noexcept :
-        codepoints_{},
+        codepoint_{0},
         attributes_{std::move(_attrib)},
         width_{1},
-        codepointCount_{0}
+        codepointCount_{0},
+        hyperlink_{HyperlinkStorage::None}
     {
         setCharacter(_ch);
     }
 
-    constexpr Cell() noexcept :
-        codepoints_{},
+    Cell() noexcept :
+        codepoint_{0},
         attributes_{},
         width_{1},
-        codepointCount_{0}
+        codepointCount_{0},
+        hyperlink_{HyperlinkStorage::None}
     {}
 
     void reset() noexcept
     {
         attributes_ = {};
+        codepoint_ = 0;
         codepointCount_ = 0;
         width_ = 1;
-        hyperlink_ = nullptr;
-        imageFragment_.reset();
+        hyperlink_ = HyperlinkStorage::None;
+        extra_.reset();
     }
 
-    void reset(GraphicsAttributes _attribs, HyperlinkRef const& _hyperlink) noexcept
+    void reset(GraphicsAttributes _attribs, HyperlinkId _hyperlink) noexcept
     {
         attributes_ = std::move(_attribs);
+        codepoint_ = 0;
         codepointCount_ = 0;
         width_ = 1;
         hyperlink_ = _hyperlink;
-        imageFragment_.reset();
+        extra_.reset();
+    }
+
+    Cell(Cell const& _other) :
+        codepoint_{_other.codepoint_},
+        attributes_{_other.attributes_},
+        width_{_other.width_},
+        codepointCount_{_other.codepointCount_},
+        hyperlink_{_other.hyperlink_},
+        extra_{_other.extra_ ? std::make_unique<CellExtra>(*_other.extra_) : nullptr}
+    {}
+
+    Cell& operator=(Cell const& _other)
+    {
+        codepoint_ = _other.codepoint_;
+        attributes_ = _other.attributes_;
+        width_ = _other.width_;
+        codepointCount_ = _other.codepointCount_;
+        hyperlink_ = _other.hyperlink_;
+        if (_other.extra_)
+            extra_ = std::make_unique<CellExtra>(*_other.extra_);
+        else
+            extra_.reset();
+        return *this;
     }
 
-    Cell(Cell const&) = default;
     Cell(Cell&&) noexcept = default;
-    Cell& operator=(Cell const&) = default;
     Cell& operator=(Cell&&) noexcept = default;
 
-    constexpr std::u32string_view codepoints() const noexcept
+    std::u32string_view codepoints() const noexcept
+    {
+        if (codepointCount_ > 1)
+            return extra_->codepoints;
+        else
+            return std::u32string_view{&codepoint_, codepointCount_};
+    }
+
+    char32_t codepoint(size_t i) const noexcept
     {
-        return std::u32string_view{codepoints_.data(), codepointCount_};
+        if (i == 0)
+            return codepoint_;
+        else if (i < codepointCount_)
+            return extra_->codepoints[i];
+        else
+            return 0;
     }
 
-    constexpr char32_t codepoint(size_t i) const noexcept { return codepoints_[i]; }
     constexpr int codepointCount() const noexcept { return codepointCount_; }
 
-    constexpr bool empty() const noexcept { return codepointCount_ == 0 && !imageFragment_; }
+    bool empty() const noexcept { return codepointCount_ == 0 && !imageFragment(); }
 
     constexpr int width() const noexcept { return width_; }
 
     constexpr GraphicsAttributes const& attributes() const noexcept { return attributes_; }
     constexpr GraphicsAttributes& attributes() noexcept { return attributes_; }
 
-    std::optional<ImageFragment> const& imageFragment() const noexcept { return imageFragment_; }
+    std::optional<ImageFragment> const& imageFragment() const noexcept
+    {
+        static std::optional<ImageFragment> const noImageFragment = std::nullopt;
+        return extra_ ? extra_->imageFragment : noImageFragment;
+    }
 
-    void setImage(ImageFragment _imageFragment, HyperlinkRef _hyperlink)
+    void setImage(ImageFragment _imageFragment, HyperlinkId _hyperlink)
     {
-        imageFragment_.emplace(std::move(_imageFragment));
-        hyperlink_ = std::move(_hyperlink);
+        auto& ext = extra();
+        ext.codepoints.clear();
+        ext.imageFragment.emplace(std::move(_imageFragment));
+        hyperlink_ = _hyperlink;
+        codepoint_ = 0;
         width_ = 1;
         codepointCount_ = 0;
     }
 
     void setCharacter(char32_t _codepoint) noexcept
     {
-        imageFragment_.reset();
-        codepoints_[0] = _codepoint;
+        if (extra_)
+        {
+            extra_->codepoints.clear();
+            extra_->imageFragment.reset();
+        }
+        codepoint_ = _codepoint;
         if (_codepoint)
         {
             codepointCount_ = 1;
-            width_ = std::max(unicode::width(_codepoint), 1);
+            width_ = _codepoint < 0x80 ? 1 : std::max(unicode::width(_codepoint), 1);
         }
         else
         {
@@ -282,12 +371,22 @@ class Cell {
         width_ = _width;
     }
 
-    int appendCharacter(char32_t _codepoint) noexcept
+    int appendCharacter(char32_t _codepoint)
     {
-        imageFragment_.reset();
+        // The first codepoint is always stored inline.
+        if (codepointCount_ == 0)
+        {
+            setCharacter(_codepoint);
+            return 0;
+        }
+
         if (codepointCount_ < MaxCodepoints)
         {
-            codepoints_[codepointCount_] = _codepoint;
+            auto& ext = extra();
+            ext.imageFragment.reset();
+            if (codepointCount_ == 1)
+                ext.codepoints.assign(&codepoint_, 1);
+            ext.codepoints.push_back(_codepoint);
             codepointCount_++;
 
             constexpr bool AllowWidthChange = false; // TODO: make configurable
@@ -311,17 +410,27 @@ class Cell {
                 return diff;
             }
         }
+        else if (extra_)
+            extra_->imageFragment.reset();
         return 0;
     }
 
     std::string toUtf8() const;
 
-    HyperlinkRef hyperlink() const noexcept { return hyperlink_; }
-    void setHyperlink(HyperlinkRef const& _hyperlink) { hyperlink_ = _hyperlink; }
+    /// @returns ID of the hyperlink this cell belongs to, or HyperlinkStorage::None.
+    constexpr HyperlinkId hyperlink() const noexcept { return hyperlink_; }
+    constexpr void setHyperlink(HyperlinkId _hyperlink) noexcept { hyperlink_ = _hyperlink; }
 
   private:
-    /// Unicode codepoint to be displayed.
-    std::array<char32_t, MaxCodepoints> codepoints_;
+    CellExtra& extra()
+    {
+        if (!extra_)
+            extra_ = std::make_unique<CellExtra>();
+        return *extra_;
+    }
+
+    /// First (and usually only) Unicode codepoint to be displayed.
+    char32_t codepoint_;
 
     /// Graphics renditions, such as foreground/background color or other grpahics attributes.
     GraphicsAttributes attributes_;
@@ -332,13 +441,14 @@ class Cell {
     /// Number of combined codepoints stored in this cell.
     uint8_t codepointCount_;
 
-    HyperlinkRef hyperlink_ = nullptr;
+    /// ID of the hyperlink in the owning screen's HyperlinkStorage.
+    HyperlinkId hyperlink_;
 
-    /// Image fragment to be rendered in this cell.
-    std::optional<ImageFragment> imageFragment_;
+    /// Out-of-line storage for combining codepoints and image fragment.
+    std::unique_ptr<CellExtra> extra_;
 };
 
-constexpr bool operator==(Cell const& a, Cell const& b) noexcept
+inline bool operator==(Cell const& a, Cell const& b) noexcept
 {
     if (a.codepointCount() != b.codepointCount())
         return false;
@@ -364,7 +474,23 @@ class Line { // {{{
         Marked    = 0x0004,
     };
 
-    using Buffer = std::deque<Cell>;
+    using Buffer = std::vector<Cell>;
+
+    /// Run of consecutive cells sharing the same graphics attributes.
+    struct AttributeRun {
+        int length;
+        GraphicsAttributes attributes;
+    };
+
+    /// Run-length encoded cell storage, used for lines in scrollback history.
+    ///
+    /// Holds one codepoint per cell (0 for empty cells) and stores the graphics
+    /// attributes only once per run of cells with identical attributes.
+    struct PackedCells {
+        std::u32string codepoints;
+        std::vector<AttributeRun> runs;
+    };
+
     using iterator = Buffer::iterator;
     using const_iterator = Buffer::const_iterator;
     using reverse_iterator = Buffer::reverse_iterator;
@@ -380,18 +506,37 @@ class Line { // {{{
     Line(int _numCols, Buffer&& _init, Flags _flags);
     Line(int _numCols, std::string_view const& _s, Flags _flags);
 
-    Buffer& buffer() noexcept { return buffer_; }
+    /// Constructs a packed line, e.g. when loading paged out history lines.
+    Line(PackedCells _packed, Flags _flags);
+
+    Buffer& buffer() noexcept { modify(); return buffer_; }
 
     Line() = default;
-    Line(Line const&) = default;
-    Line(Line&&) = default;
-    Line& operator=(Line const&) = default;
-    Line& operator=(Line&&) = default;
+    Line(Line const& _other);
+    Line(Line&& _other) noexcept;
+    Line& operator=(Line const& _other);
+    Line& operator=(Line&& _other) noexcept;
 
-    Buffer* operator->() noexcept { return &buffer_; }
-    Buffer const* operator->()  const noexcept { return &buffer_; }
-    auto& operator[](std::size_t _index) { return buffer_[_index]; }
-    auto const& operator[](std::size_t _index) const { return buffer_[_index]; }
+    // NB: The const cell accessors below must not be used on packed lines.
+    // Use cellAt() or visitCells() to read lines that may be packed.
+
+    Buffer* operator->() noexcept { modify(); return &buffer_; }
+    Buffer const* operator->()  const noexcept { assert(!packed_); return &buffer_; }
+    auto& operator[](std::size_t _index) { modify(); return buffer_[_index]; }
+    auto const& operator[](std::size_t _index) const { assert(!packed_); return buffer_[_index]; }
+
+    /// @returns a copy of the cell at the given zero-based index, decoding it from the
+    ///          attribute runs if this line is packed.
+    ///
+    /// Cells beyond the end of a compacted line are returned as default blank cells.
+    Cell cellAt(int _index) const;
+
+    /// Passes every cell in column range [_fromColumn, _toColumn] (1-based, inclusive) that is
+    /// held by this line to @p _visit, along with its column number.
+    ///
+    /// Packed lines are decoded run by run into a single cell, without unpacking the line.
+    template <typename Visitor>
+    void visitCells(int _fromColumn, int _toColumn, Visitor&& _visit) const;
 
     void prepend(Buffer const&);
     void append(Buffer const&);
@@ -404,9 +549,12 @@ class Line { // {{{
     /// @returns sequence of cells that have been shifted out.
     Buffer shift_left(int _count, Cell const& _fill);
 
-    crispy::range<const_iterator> trim_blank_right() const;
+    crispy::range<const_iterator> trim_blank_right();
 
-    int size() const noexcept { return static_cast<int>(buffer_.size()); }
+    int size() const noexcept
+    {
+        return static_cast<int>(packed_ ? packed_->codepoints.size() : buffer_.size());
+    }
 
     bool blank() const noexcept;
 
@@ -415,14 +563,62 @@ class Line { // {{{
     void resize(int _size);
     [[nodiscard]] Buffer reflow(int _column);
 
-    iterator begin() { return buffer_.begin(); }
-    iterator end() { return buffer_.end(); }
-    const_iterator begin() const { return buffer_.begin(); }
-    const_iterator end() const { return buffer_.end(); }
-    reverse_iterator rbegin() { return buffer_.rbegin(); }
-    reverse_iterator rend() { return buffer_.rend(); }
-    const_iterator cbegin() const { return buffer_.cbegin(); }
-    const_iterator cend() const { return buffer_.cend(); }
+    /// Drops trailing blank cells that carry no graphics attributes and, if all remaining
+    /// cells can be represented that way, packs the line into run-length encoded form
+    /// (see PackedCells).
+    ///
+    /// This is used for lines that scroll into history. Such lines are transparently
+    /// unpacked and grown back to full width when accessed for modification.
+    void compact();
+
+    /// Reinitializes this line in-place to @p _numCols cells of @p _defaultCell,
+    /// reusing the already allocated cell storage.
+    void reset(int _numCols, Cell const& _defaultCell, Flags _flags);
+
+    /// Releases all cell storage, leaving this line with no cells.
+    void release();
+
+    /// @returns the run-length encoded cells if this line is currently packed, nullptr otherwise.
+    ///
+    PackedCells const* packedCells() const noexcept { return packed_.get(); }
+
+    bool packed() const noexcept { return packed_ != nullptr; }
+
+    /// Identifies the contents of a line.
+    ///
+    /// Every line object carries a unique id, and its version is incremented upon any
+    /// mutable access to its cells. Equal revisions therefore imply equal contents,
+    /// which allows detecting unchanged lines, even when they have been moved around
+    /// due to scrolling, without comparing any cells.
+    struct Revision {
+        uint64_t id = 0;
+        uint64_t version = 0;
+
+        constexpr bool operator==(Revision const& _rhs) const noexcept { return id == _rhs.id && version == _rhs.version; }
+        constexpr bool operator!=(Revision const& _rhs) const noexcept { return !(*this == _rhs); }
+    };
+
+    Revision revision() const noexcept { return Revision{id_, version_}; }
+
+    /// Marks this line as modified.
+    ///
+    /// This must be called when modifying cells through iterators or references
+    /// that have been obtained before.
+    void touch() noexcept { ++version_; }
+
+    iterator begin() { modify(); return buffer_.begin(); }
+    iterator end() { modify(); return buffer_.end(); }
+    const_iterator begin() const { assert(!packed_); return buffer_.begin(); }
+    const_iterator end() const { assert(!packed_); return buffer_.end(); }
+    reverse_iterator rbegin() { modify(); return buffer_.rbegin(); }
+    reverse_iterator rend() { modify(); return buffer_.rend(); }
+    const_iterator cbegin() const { assert(!packed_); return buffer_.cbegin(); }
+    const_iterator cend() const { assert(!packed_); return buffer_.cend(); }
+
+    /// @returns an iterator to the first cell, without marking this line as modified.
+    ///
+    /// Modifications made through it must be announced via touch().
+    iterator beginUntouched() { unpack(); return buffer_.begin(); }
 
     bool marked() const noexcept { return isFlagEnabled(Flags::Marked); }
     void setMarked(bool _enable) { setFlag(Flags::Marked, _enable); }
@@ -460,10 +656,62 @@ class Line { // {{{
     bool isFlagEnabled(Flags _flag) const noexcept { return (flags_ & static_cast<unsigned>(_flag)) != 0; }
 
   private:
+    void unpack()
+    {
+        if (packed_)
+            unpackSlow();
+    }
+
+    void unpackSlow();
+
+    void modify()
+    {
+        unpack();
+        touch();
+    }
+
+    static uint64_t nextId() noexcept;
+
     Buffer buffer_;
+    std::unique_ptr<PackedCells> packed_;
     unsigned flags_;
+    uint64_t id_ = nextId();
+    uint64_t version_ = 0;
 };
 
+template <typename Visitor>
+inline void Line::visitCells(int _fromColumn, int _toColumn, Visitor&& _visit) const
+{
+    auto const lastColumn = std::min(_toColumn, size());
+
+    if (!packed_)
+    {
+        for (int column = std::max(_fromColumn, 1); column <= lastColumn; ++column)
+            _visit(column, buffer_[static_cast<size_t>(column - 1)]);
+        return;
+    }
+
+    auto cell = Cell{};
+    auto runStart = 1;
+    for (AttributeRun const& run : packed_->runs)
+    {
+        if (runStart > lastColumn)
+            break;
+
+        auto const runEnd = runStart + run.length - 1;
+        if (runEnd >= _fromColumn)
+        {
+            cell.attributes() = run.attributes;
+            for (int column = std::max(runStart, _fromColumn); column <= std::min(runEnd, lastColumn); ++column)
+            {
+                cell.setCharacter(packed_->codepoints[static_cast<size_t>(column - 1)]);
+                _visit(column, static_cast<Cell const&>(cell));
+            }
+        }
+        runStart = runEnd + 1;
+    }
+}
+
 constexpr Line::Flags operator|(Line::Flags a, Line::Flags b) noexcept
 {
     return Line::Flags(unsigned(a) | unsigned(b));
@@ -475,7 +723,7 @@ constexpr bool operator&(Line::Flags a, Line::Flags b) noexcept
 }
 // }}}
 
-using Lines = std::deque<Line>;
+using Lines = crispy::ring<Line>;
 using ColumnIterator = Line::iterator;
 using LineIterator = Lines::iterator;
 
@@ -486,6 +734,8 @@ inline auto end(Line const& _line) { return _line.cend(); }
 inline Line::const_iterator cbegin(Line const& _line) { return _line.cbegin(); }
 inline Line::const_iterator cend(Line const& _line) { return _line.cend(); }
 
+class HistoryPager;
+
 /**
  * Manages the screen grid buffer (main screen + scrollback history).
  *
@@ -493,9 +743,26 @@ inline Line::const_iterator cend(Line const& _line) { return _line.cend(); }
  *
  * <ul>
  *   <li>manages text reflow upon resize
- *   <li>manages underlying disk storage for very old scrollback history lines.
  * </ul>
  *
+ * <h3>History paging</h3>
+ *
+ * When a maximum number of resident history lines is set, scrollback history lines
+ * are grouped into pages of LinesPerHistoryPage lines, and the least recently used pages
+ * exceeding that budget are moved into a HistoryPager (on-disk storage).
+ * Such pages are transparently paged back in as soon as any of their lines is accessed
+ * for modification, or explicitly via pageIn().
+ *
+ * <h3>Compact history lines</h3>
+ *
+ * Lines that scroll into history are compacted (see Line::compact()), i.e. they may hold
+ * fewer cells than the screen width. Read-only accessors and render() treat missing cells
+ * as default blank cells, whereas mutable accessors grow such lines back to full width first.
+ *
+ * Where possible, such lines are also stored run-length encoded (see Line::PackedCells),
+ * keeping graphics attributes only once per run. Read-only accessors decode these runs
+ * on the fly (see Line::visitCells()), whereas mutable accessors unpack the line.
+ *
  * <h3>Layout</h3>
  *
  * <pre>
@@ -519,6 +786,13 @@ class Grid {
     Grid(Size _screenSize, bool _reflowOnResize, std::optional<int> _maxHistoryLineCount);
 
     Grid() : Grid(Size{80, 25}, false, 0) {}
+    ~Grid();
+
+    Grid(Grid&&) noexcept;
+    Grid& operator=(Grid&&) noexcept;
+
+    /// Number of history lines grouped into one page when paging out history lines.
+    static constexpr int LinesPerHistoryPage = 256;
 
     Size screenSize() const noexcept { return screenSize_; }
 
@@ -534,6 +808,35 @@ class Grid {
     std::optional<int> maxHistoryLineCount() const noexcept { return maxHistoryLineCount_; }
     void setMaxHistoryLineCount(std::optional<int> _maxHistoryLineCount);
 
+    /// @returns maximum number of history lines to keep in memory, or std::nullopt if unlimited.
+    std::optional<int> maxResidentHistoryLineCount() const noexcept { return maxResidentHistoryLineCount_; }
+
+    /// Sets the maximum number of history lines to keep in memory.
+    ///
+    /// Any history lines exceeding that number will be paged out to disk.
+    void setMaxResidentHistoryLineCount(std::optional<int> _count);
+
+    /// @returns number of history pages currently paged out.
+    size_t pagedOutHistoryPageCount() const noexcept { return pagedOutPages_.size(); }
+
+    /// Ensures that the history lines in absolute range [_start, _end) are resident in memory,
+    /// reading them back from disk if they have been paged out.
+    ///
+    /// Read-only accessors never page in, as that blocks on file I/O. They read paged out
+    /// lines as blank lines instead, hence lines about to be read must be paged in up front,
+    /// e.g. when scrolling the viewport.
+    void pageIn(int _start, int _end)
+    {
+        if (!pagedOutPages_.empty())
+            pageInSlow(_start, _end);
+    }
+
+    /// Flags the IDs of all hyperlinks referenced by any cell of this grid in @p _used
+    /// (indexed by HyperlinkId), growing it as needed.
+    ///
+    /// Packed and paged out history lines never carry hyperlinks and are therefore skipped.
+    void markHyperlinks(std::vector<bool>& _used) const;
+
     bool reflowOnResize() const noexcept { return reflowOnResize_; }
     void setReflowOnResize(bool _enabled) { reflowOnResize_ = _enabled; }
 
@@ -543,6 +846,12 @@ class Grid {
     template <typename RendererT>
     void render(RendererT && _render, std::optional<int> _scrollOffset = std::nullopt) const;
 
+    /// Renders a single line of the given page row by passing every grid cell to the callback.
+    ///
+    /// Lines shorter than the page width are padded with empty cells.
+    template <typename RendererT>
+    void renderLine(RendererT && _render, int _rowNumber, Line const& _line) const;
+
     Line& absoluteLineAt(int _line) noexcept;
     Line const& absoluteLineAt(int _line) const noexcept;
 
@@ -556,8 +865,10 @@ class Grid {
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
     Cell& at(Coordinate const& _coord) noexcept;
 
-    /// Gets a reference to the cell relative to screen origin (top left, 1:1).
-    Cell const& at(Coordinate const& _coord) const noexcept;
+    /// Gets a copy of the cell relative to screen origin (top left, 1:1).
+    ///
+    /// The cell is returned by value, as packed lines do not hold any Cell objects.
+    Cell at(Coordinate const& _coord) const;
 
     crispy::range<Lines::const_iterator> lines(int _start, int _count) const;
     crispy::range<Lines::iterator> lines(int _start, int _count);
@@ -602,11 +913,51 @@ class Grid {
     void clampHistory();
     void appendNewLines(int _count, GraphicsAttributes _attr);
 
+    // {{{ history paging
+    using PageId = int64_t;
+
+    PageId pageOf(int _absoluteLine) const noexcept
+    {
+        return (droppedLineCount_ + _absoluteLine) / LinesPerHistoryPage;
+    }
+
+    /// @returns the absolute line range [first, last) of the given page that is present in history.
+    std::pair<int, int> historyLinesOfPage(PageId _page) const noexcept;
+
+    void pageInSlow(int _start, int _end);
+
+    /// Pages out least recently used history pages exceeding the resident history line budget.
+    void pageOut();
+
+    /// State of the lines of a page, used to detect modifications since it has been paged in.
+    using PageState = std::vector<std::pair<Line::Revision, Line::Flags>>;
+
+    /// @returns the current state of the lines in absolute range [_first, _last).
+    PageState pageStateOf(int _first, int _last) const;
+
+    /// Accounts for @p _count lines having been removed from the top of the history.
+    void dropHistoryLines(int _count);
+
+    /// Pages in all history lines and discards any paged data.
+    void discardHistoryPages();
+    // }}}
+
   private:
     Size screenSize_;
     bool reflowOnResize_;
     std::optional<int> maxHistoryLineCount_;
     Lines lines_;
+
+    // {{{ history paging
+    std::optional<int> maxResidentHistoryLineCount_;
+    std::unique_ptr<HistoryPager> historyPager_;
+    int64_t droppedLineCount_ = 0;       // total number of lines ever removed from the top
+    std::set<PageId> pagedOutPages_;      // pages whose lines are currently only stored in historyPager_
+    std::set<PageId> unpageablePages_;    // pages that cannot be paged out (e.g. containing images)
+    std::map<PageId, uint64_t> pageAccessTime_;
+    std::map<PageId, PageState> pagedInPages_; // state of paged in pages that are still stored in historyPager_
+    uint64_t pageAccessTick_ = 0;
+    // }}}
 };
 
 // {{{ inlines
@@ -614,24 +965,35 @@ template <typename RendererT>
 inline void Grid::render(RendererT && _render, std::optional<int> _scrollOffset) const
 {
     for (auto const && [rowNumber, line] : crispy::indexed(pageAtScrollOffset(_scrollOffset), 1))
-    {
-        for (auto const && [colNumber, column] : crispy::indexed(line, 1))
-            _render({rowNumber, colNumber}, column);
+        renderLine(_render, rowNumber, line);
+}
 
-        for (auto const colNumber : crispy::times(line.size() + 1, std::max(0, screenSize_.width - line.size())))
-            _render({rowNumber, colNumber}, Cell{});
-    }
+template <typename RendererT>
+inline void Grid::renderLine(RendererT && _render, int _rowNumber, Line const& _line) const
+{
+    _line.visitCells(1, _line.size(), [&](int _colNumber, Cell const& _cell) {
+        _render({_rowNumber, _colNumber}, _cell);
+    });
+
+    for (auto const colNumber : crispy::times(_line.size() + 1, std::max(0, screenSize_.width - _line.size())))
+        _render({_rowNumber, colNumber}, Cell{});
 }
 
 inline Line& Grid::absoluteLineAt(int _line) noexcept
 {
     assert(crispy::ascending(0, _line, static_cast<int>(lines_.size()) - 1));
-    return *next(lines_.begin(), _line);
+    pageIn(_line, _line + 1);
+
+    Line& line = lines_[static_cast<size_t>(_line)];
+    if (line.size() < screenSize_.width)
+        line.resize(screenSize_.width);
+    return line;
 }
 
 inline Line const& Grid::absoluteLineAt(int _line) const noexcept
 {
-    return const_cast<Grid&>(*this).absoluteLineAt(_line);
+    assert(crispy::ascending(0, _line, static_cast<int>(lines_.size()) - 1));
+    return lines_[static_cast<size_t>(_line)];
 }
 
 inline Line& Grid::lineAt(int _line) noexcept
@@ -639,14 +1001,19 @@ inline Line& Grid::lineAt(int _line) noexcept
     assert(crispy::ascending(1 - historyLineCount(), _line, screenSize_.height));
 
     if (_line > 0)
-        return *next(lines_.begin(), historyLineCount() + _line - 1);
+        return *std::next(lines_.begin(), historyLineCount() + _line - 1);
     else
-        return *next(lines_.begin(), -_line);
+        return absoluteLineAt(-_line);
 }
 
 inline Line const& Grid::lineAt(int _line) const noexcept
 {
-    return const_cast<Grid&>(*this).lineAt(_line);
+    assert(crispy::ascending(1 - historyLineCount(), _line, screenSize_.height));
+
+    if (_line > 0)
+        return *std::next(lines_.begin(), historyLineCount() + _line - 1);
+    else
+        return absoluteLineAt(-_line);
 }
 
 inline int Grid::toAbsoluteLine(int _relativeLine) const noexcept
@@ -660,14 +1027,20 @@ inline Cell& Grid::at(Coordinate const& _coord) noexcept
     assert(crispy::ascending(1, _coord.column, screenSize_.width));
 
     if (_coord.row > 0)
-        return (*next(lines_.rbegin(), screenSize_.height - _coord.row))[_coord.column - 1];
+        return (*std::next(lines_.rbegin(), screenSize_.height - _coord.row))[_coord.column - 1];
     else
-        return (*next(lines_.begin(), historyLineCount() + _coord.row - 1))[_coord.column - 1];
+        return absoluteLineAt(historyLineCount() + _coord.row - 1)[_coord.column - 1];
 }
 
-inline Cell const& Grid::at(Coordinate const& _coord) const noexcept
+inline Cell Grid::at(Coordinate const& _coord) const
 {
-    return const_cast<Grid&>(*this).at(_coord);
+    assert(crispy::ascending(1 - historyLineCount(), _coord.row, screenSize_.height));
+    assert(crispy::ascending(1, _coord.column, screenSize_.width));
+
+    if (_coord.row > 0)
+        return std::next(lines_.rbegin(), screenSize_.height - _coord.row)->cellAt(_coord.column - 1);
+
+    return absoluteLineAt(historyLineCount() + _coord.row - 1).cellAt(_coord.column - 1);
 }
 
 inline crispy::range<Lines::const_iterator> Grid::lines(int _start, int _end) const
@@ -676,8 +1049,8 @@ inline crispy::range<Lines::const_iterator> Grid::lines(int _start, int _end) co
     assert(crispy::ascending(_start, _end, int(lines_.size()) - 1) && "Absolute scroll offset must not be negative or overflowing.");
 
     return crispy::range<Lines::const_iterator>(
-        next(lines_.cbegin(), _start),
-        next(lines_.cbegin(), _end)
+        std::next(lines_.cbegin(), _start),
+        std::next(lines_.cbegin(), _end)
     );
 }
 
@@ -686,9 +1059,11 @@ inline crispy::range<Lines::iterator> Grid::lines(int _start, int _end)
     assert(crispy::ascending(0, _start, int(lines_.size())) && "Absolute scroll offset must not be negative or overflowing.");
     assert(crispy::ascending(_start, _end, int(lines_.size())) && "Absolute scroll offset must not be negative or overflowing.");
 
+    pageIn(_start, _end);
+
     return crispy::range<Lines::iterator>(
-        next(lines_.begin(), _start),
-        next(lines_.begin(), _end)
+        std::next(lines_.begin(), _start),
+        std::next(lines_.begin(), _end)
     );
 }
 
@@ -707,6 +1082,9 @@ inline crispy::range<Lines::iterator> Grid::pageAtScrollOffset(std::optional<int
 {
     assert(crispy::ascending(0, _scrollOffset.value_or(0), historyLineCount()) && "Absolute scroll offset must not be negative or overflowing.");
 
+    if (_scrollOffset.has_value())
+        pageIn(_scrollOffset.value(), historyLineCount());
+
     return crispy::range<Lines::iterator>(
         std::next(
             lines_.begin(),
@@ -57,6 +57,42 @@ namespace // {{{ helper
     }
 } // }}}
 
+TEST_CASE("Cell.compact", "[grid]")
+{
+    // The hot part of a cell must stay small; rarely used properties live out of line.
+    CHECK(sizeof(Cell) <= 32);
+
+    auto cell = Cell{U'a', GraphicsAttributes{}};
+    CHECK(cell.codepointCount() == 1);
+    CHECK(cell.codepoints() == U"a"sv);
+    CHECK(cell.hyperlink() == HyperlinkStorage::None);
+    CHECK(!cell.imageFragment().has_value());
+
+    cell.appendCharacter(0x0308);
+    cell.appendCharacter(0x0301);
+    CHECK(cell.codepointCount() == 3);
+    CHECK(cell.codepoint(0) == U'a');
+    CHECK(cell.codepoint(2) == 0x0301);
+    CHECK(cell.codepoints() == U"a\u0308\u0301"sv);
+
+    auto const copy = cell;
+    CHECK(copy == cell);
+    CHECK(copy.codepoints() == cell.codepoints());
+
+    cell.setCharacter(U'b');
+    CHECK(cell.codepoints() == U"b"sv);
+    CHECK(copy.codepointCount() == 3);
+
+    // Appending to an empty cell stores the codepoint inline.
+    auto empty = Cell{};
+    empty.appendCharacter(U'c');
+    CHECK(empty.codepointCount() == 1);
+    CHECK(empty.codepoint(0) == U'c');
+    CHECK(empty.codepoints() == U"c"sv);
+    empty.appendCharacter(0x0308);
+    CHECK(empty.codepoints() == U"c\u0308"sv);
+}
+
 TEST_CASE("Line.reflow.unwrappable", "[grid]")
 {
     auto line = Line(5, "ABCDE"sv, Line::Flags::None);
@@ -439,3 +475,243 @@ TEST_CASE("Grid.reflow.tripple", "[grid]")
         // }}}
     }
 }
+
+TEST_CASE("Grid.scrollUp.recycle_full_history", "[grid]")
+{
+    auto grid = Grid(Size{3, 2}, false, 2);
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 3}};
+
+    for (auto const text : {"ABC", "DEF", "GHI", "JKL", "MNO"})
+    {
+        grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+        grid.lineAt(2).setText(text);
+    }
+    logGridText(grid, "after scrolling 5 lines");
+
+    REQUIRE(grid.historyLineCount() == 2);
+    CHECK(grid.renderTextLineAbsolute(0) == "DEF");
+    CHECK(grid.renderTextLineAbsolute(1) == "GHI");
+    CHECK(grid.renderTextLine(1) == "JKL");
+    CHECK(grid.renderTextLine(2) == "MNO");
+
+    // Scrolling a full history must leave fresh, blank lines at the bottom.
+    grid.scrollUp(2, GraphicsAttributes{}, fullMargin);
+    REQUIRE(grid.historyLineCount() == 2);
+    CHECK(grid.renderTextLineAbsolute(0) == "JKL");
+    CHECK(grid.renderTextLineAbsolute(1) == "MNO");
+    CHECK(grid.renderTextLine(1) == "   ");
+    CHECK(grid.renderTextLine(2) == "   ");
+}
+
+TEST_CASE("Grid.history_paging", "[grid]")
+{
+    auto grid = Grid(Size{6, 1}, false, std::nullopt);
+    auto const fullMargin = Margin{Margin::Range{1, 1}, Margin::Range{1, 6}};
+    auto const pageSize = Grid::LinesPerHistoryPage;
+    auto const lineCount = 4 * pageSize;
+
+    auto bold = GraphicsAttributes{};
+    bold.styles |= CharacterStyleMask::Bold;
+
+    for (int i = 0; i < lineCount; ++i)
+    {
+        grid.lineAt(1).setText(fmt::format("{:06}", i));
+        if (i % 7 == 0)
+            grid.lineAt(1)[0].attributes() = bold;
+        grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+    }
+
+    auto const historyLineCount = grid.historyLineCount();
+    REQUIRE(historyLineCount == lineCount);
+
+    grid.setMaxResidentHistoryLineCount(pageSize);
+    CHECK(grid.historyLineCount() == historyLineCount);
+    CHECK(grid.pagedOutHistoryPageCount() == 3);
+
+    // Read-only access does not page in, paged out lines read as blank.
+    CHECK(grid.renderTextLineAbsolute(0) == "      ");
+    CHECK(grid.pagedOutHistoryPageCount() == 3);
+
+    // Packed lines are paged in in packed form.
+    grid.pageIn(0, historyLineCount);
+    CHECK(grid.pagedOutHistoryPageCount() == 0);
+    auto const& constGrid = grid;
+    CHECK(constGrid.absoluteLineAt(0).packed());
+    CHECK(constGrid.absoluteLineAt(0).size() == 6);
+
+    for (int i = 0; i < historyLineCount; ++i)
+    {
+        INFO(fmt::format("line {}", i));
+        REQUIRE(grid.renderTextLineAbsolute(i) == fmt::format("{:06}", i));
+        REQUIRE((constGrid.at({i - historyLineCount + 1, 1}).attributes() == bold) == (i % 7 == 0));
+    }
+
+    // Mutable access transparently pages in again.
+    grid.setMaxResidentHistoryLineCount(pageSize);
+    REQUIRE(grid.pagedOutHistoryPageCount() == 3);
+    CHECK((grid.absoluteLineAt(7)[0].attributes() == bold));
+    CHECK(grid.pagedOutHistoryPageCount() == 2);
+
+    // Scrolling further keeps the number of resident lines bounded.
+    for (int i = lineCount; i < lineCount + pageSize; ++i)
+    {
+        grid.lineAt(1).setText(fmt::format("{:06}", i));
+        grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+    }
+    CHECK(grid.pagedOutHistoryPageCount() == 4);
+    grid.pageIn(0, 1);
+    CHECK(grid.renderTextLineAbsolute(0) == "000000");
+    CHECK(grid.renderTextLineAbsolute(lineCount + pageSize - 1) == fmt::format("{:06}", lineCount + pageSize - 1));
+
+    grid.setMaxResidentHistoryLineCount(std::nullopt);
+    CHECK(grid.pagedOutHistoryPageCount() == 0);
+    CHECK(grid.renderTextLineAbsolute(pageSize + 1) == fmt::format("{:06}", pageSize + 1));
+}
+
+TEST_CASE("Grid.history_paging.modified_after_page_in", "[grid]")
+{
+    auto grid = Grid(Size{6, 1}, false, std::nullopt);
+    auto const fullMargin = Margin{Margin::Range{1, 1}, Margin::Range{1, 6}};
+    auto const pageSize = Grid::LinesPerHistoryPage;
+    auto const lineCount = 4 * pageSize;
+
+    for (int i = 0; i < lineCount; ++i)
+    {
+        grid.lineAt(1).setText(fmt::format("{:06}", i));
+        grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+    }
+
+    grid.setMaxResidentHistoryLineCount(pageSize);
+    REQUIRE(grid.pagedOutHistoryPageCount() == 3);
+
+    // Page in the first page and modify it.
+    grid.absoluteLineAt(1).setText("AAAAAA");
+
+    // Access all other pages, so that the first page becomes the least recently used one again.
+    grid.pageIn(pageSize, lineCount);
+    grid.setMaxResidentHistoryLineCount(pageSize);
+    REQUIRE(grid.pagedOutHistoryPageCount() == 3);
+
+    grid.pageIn(0, 3);
+    CHECK(grid.renderTextLineAbsolute(0) == "000000");
+    CHECK(grid.renderTextLineAbsolute(1) == "AAAAAA");
+    CHECK(grid.renderTextLineAbsolute(2) == "000002");
+}
+
+TEST_CASE("Grid.history_paging.clamped", "[grid]")
+{
+    auto const pageSize = Grid::LinesPerHistoryPage;
+    auto grid = Grid(Size{6, 1}, false, 3 * pageSize - 5);
+    auto const fullMargin = Margin{Margin::Range{1, 1}, Margin::Range{1, 6}};
+    grid.setMaxResidentHistoryLineCount(pageSize);
+
+    auto const lineCount = 5 * pageSize + 3;
+    for (int i = 0; i < lineCount; ++i)
+    {
+        grid.lineAt(1).setText(fmt::format("{:06}", i));
+        grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+    }
+
+    REQUIRE(grid.historyLineCount() == 3 * pageSize - 5);
+    CHECK(grid.pagedOutHistoryPageCount() > 0);
+
+    auto const firstLine = lineCount - grid.historyLineCount();
+    grid.pageIn(0, grid.historyLineCount());
+    for (int i = 0; i < grid.historyLineCount(); ++i)
+    {
+        INFO(fmt::format("line {}", i));
+        REQUIRE(grid.renderTextLineAbsolute(i) == fmt::format("{:06}", firstLine + i));
+    }
+}
+
+TEST_CASE("Grid.history_lines_compacted", "[grid]")
+{
+    auto grid = Grid(Size{10, 2}, true, std::nullopt);
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 10}};
+
+    auto colored = GraphicsAttributes{};
+    colored.backgroundColor = IndexedColor::Blue;
+
+    grid.lineAt(1).setText("ab");
+    grid.lineAt(2).setText("abc");
+    grid.lineAt(2)[5].attributes() = colored;
+    grid.scrollUp(2, GraphicsAttributes{}, fullMargin);
+
+    REQUIRE(grid.historyLineCount() == 2);
+    auto const& constGrid = grid;
+    CHECK(constGrid.absoluteLineAt(0).size() == 2);
+    CHECK(constGrid.absoluteLineAt(1).size() == 6); // cells with non-default attributes are kept.
+    CHECK(constGrid.at({-1, 10}).empty());
+    CHECK(grid.renderTextLineAbsolute(0) == "ab        ");
+    CHECK(grid.renderTextLineAbsolute(1) == "abc       ");
+
+    // Mutable access grows the line back to full width.
+    CHECK(grid.absoluteLineAt(0).size() == 10);
+
+    // Reflow keeps history compact.
+    grid.resize(Size{12, 2}, Coordinate{1, 1}, false);
+    CHECK(constGrid.absoluteLineAt(0).size() == 2);
+    CHECK(grid.renderTextLineAbsolute(0) == "ab          ");
+    CHECK(grid.renderTextLineAbsolute(1) == "abc         ");
+}
+
+TEST_CASE("Grid.history_lines_packed", "[grid]")
+{
+    auto grid = Grid(Size{5, 1}, false, std::nullopt);
+    auto const fullMargin = Margin{Margin::Range{1, 1}, Margin::Range{1, 5}};
+
+    auto red = GraphicsAttributes{};
+    red.foregroundColor = IndexedColor::Red;
+
+    grid.lineAt(1).setText("abcd");
+    grid.lineAt(1)[1].attributes() = red;
+    grid.lineAt(1)[2].attributes() = red;
+    grid.scrollUp(1, GraphicsAttributes{}, fullMargin);
+
+    REQUIRE(grid.historyLineCount() == 1);
+    auto const& constGrid = grid;
+    Line::PackedCells const* packed = constGrid.absoluteLineAt(0).packedCells();
+    REQUIRE(packed != nullptr);
+    CHECK(packed->codepoints == U"abcd");
+    REQUIRE(packed->runs.size() == 3);
+    CHECK(packed->runs[0].length == 1);
+    CHECK(packed->runs[1].length == 2);
+    CHECK(packed->runs[1].attributes == red);
+    CHECK(packed->runs[2].length == 1);
+
+    // Rendering walks the attribute runs without unpacking the line.
+    auto rendered = std::string{};
+    auto redCount = 0;
+    grid.render([&](Coordinate const& _pos, Cell const& _cell) {
+        if (_pos.row != 1)
+            return;
+        rendered += _cell.toUtf8();
+        if (_cell.attributes() == red)
+            ++redCount;
+    }, 0);
+    CHECK(rendered == "abcd ");
+    CHECK(redCount == 2);
+    CHECK(constGrid.absoluteLineAt(0).packed());
+    CHECK(constGrid.absoluteLineAt(0).toUtf8() == "abcd");
+
+    // Read-only cell access decodes the runs and keeps the line packed.
+    CHECK(constGrid.at({0, 2}).attributes() == red);
+    CHECK(constGrid.at({0, 2}).codepoints() == U"b");
+    CHECK(constGrid.at({0, 5}).empty());
+    CHECK(grid.renderTextLineAbsolute(0) == "abcd ");
+    CHECK(constGrid.absoluteLineAt(0).packed());
+
+    auto visited = std::u32string{};
+    constGrid.absoluteLineAt(0).visitCells(2, 5, [&](int _column, Cell const& _cell) {
+        CHECK((_cell.attributes() == red) == (_column == 2 || _column == 3));
+        visited += _cell.codepoint(0);
+    });
+    CHECK(visited == U"bcd");
+    CHECK(constGrid.absoluteLineAt(0).packed());
+
+    // Mutable cell access unpacks the line.
+    grid.absoluteLineAt(0)[0].setCharacter('A');
+    CHECK_FALSE(constGrid.absoluteLineAt(0).packed());
+    CHECK(constGrid.absoluteLineAt(0).size() == 5);
+    CHECK(grid.renderTextLineAbsolute(0) == "Abcd ");
+}
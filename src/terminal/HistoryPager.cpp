@@ -0,0 +1,415 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/HistoryPager.h>
+
+#include <algorithm>
+#include <optional>
+
+using std::find_if;
+using std::nullopt;
+using std::optional;
+using std::vector;
+
+namespace terminal {
+
+namespace // {{{ serialization helper
+{
+    using Bytes = vector<uint8_t>;
+
+    enum LineFormat : uint8_t {
+        CellLine = 0,   // cell by cell, with attributes whenever they change
+        PackedLine = 1, // attribute runs, see Line::PackedCells
+    };
+
+    enum CellHeader : uint8_t {
+        AttributesFollow = 0x01,
+    };
+
+    class Writer {
+      public:
+        explicit Writer(Bytes& _out) : out_{_out} {}
+
+        void u8(uint8_t _value) { out_.push_back(_value); }
+
+        void u16(uint16_t _value)
+        {
+            u8(static_cast<uint8_t>(_value & 0xFF));
+            u8(static_cast<uint8_t>((_value >> 8) & 0xFF));
+        }
+
+        void u32(uint32_t _value)
+        {
+            u16(static_cast<uint16_t>(_value & 0xFFFF));
+            u16(static_cast<uint16_t>((_value >> 16) & 0xFFFF));
+        }
+
+        void color(Color const& _color)
+        {
+            u8(static_cast<uint8_t>(_color.index()));
+            if (auto const indexed = std::get_if<IndexedColor>(&_color))
+                u8(static_cast<uint8_t>(*indexed));
+            else if (auto const bright = std::get_if<BrightColor>(&_color))
+                u8(static_cast<uint8_t>(*bright));
+            else if (auto const rgb = std::get_if<RGBColor>(&_color))
+            {
+                u8(rgb->red);
+                u8(rgb->green);
+                u8(rgb->blue);
+            }
+        }
+
+        void attributes(GraphicsAttributes const& _attributes)
+        {
+            color(_attributes.foregroundColor);
+            color(_attributes.backgroundColor);
+            color(_attributes.underlineColor);
+            u16(static_cast<uint16_t>(_attributes.styles.mask()));
+        }
+
+      private:
+        Bytes& out_;
+    };
+
+    class Reader {
+      public:
+        Reader(uint8_t const* _begin, uint8_t const* _end) : current_{_begin}, end_{_end} {}
+
+        bool good() const noexcept { return good_; }
+
+        uint8_t u8() noexcept
+        {
+            if (current_ == end_)
+            {
+                good_ = false;
+                return 0;
+            }
+            return *current_++;
+        }
+
+        uint16_t u16() noexcept
+        {
+            auto const low = u8();
+            auto const high = u8();
+            return static_cast<uint16_t>(low | (high << 8));
+        }
+
+        uint32_t u32() noexcept
+        {
+            auto const low = u16();
+            auto const high = u16();
+            return static_cast<uint32_t>(low) | (static_cast<uint32_t>(high) << 16);
+        }
+
+        Color color() noexcept
+        {
+            switch (u8())
+            {
+                case 0: return UndefinedColor{};
+                case 1: return DefaultColor{};
+                case 2: return static_cast<IndexedColor>(u8());
+                case 3: return static_cast<BrightColor>(u8());
+                case 4:
+                {
+                    auto const r = u8();
+                    auto const g = u8();
+                    auto const b = u8();
+                    return RGBColor{r, g, b};
+                }
+                default:
+                    good_ = false;
+                    return DefaultColor{};
+            }
+        }
+
+        GraphicsAttributes attributes() noexcept
+        {
+            GraphicsAttributes attributes;
+            attributes.foregroundColor = color();
+            attributes.backgroundColor = color();
+            attributes.underlineColor = color();
+            attributes.styles = CharacterStyleMask(u16());
+            return attributes;
+        }
+
+      private:
+        uint8_t const* current_;
+        uint8_t const* end_;
+        bool good_ = true;
+    };
+
+    bool isRepresentable(Cell const& _cell) noexcept
+    {
+        return !_cell.hyperlink() && !_cell.imageFragment().has_value();
+    }
+
+    void serializePacked(Line const& _line, GraphicsAttributes& _currentAttributes, Writer& _out)
+    {
+        Line::PackedCells const& packed = *_line.packedCells();
+
+        _out.u8(PackedLine);
+        _out.u8(static_cast<uint8_t>(_line.flags()));
+        _out.u16(static_cast<uint16_t>(packed.runs.size()));
+
+        auto codepoint = packed.codepoints.begin();
+        for (Line::AttributeRun const& run : packed.runs)
+        {
+            bool const attributesChanged = run.attributes != _currentAttributes;
+
+            _out.u8(attributesChanged ? AttributesFollow : 0);
+            _out.u16(static_cast<uint16_t>(run.length));
+            if (attributesChanged)
+            {
+                _out.attributes(run.attributes);
+                _currentAttributes = run.attributes;
+            }
+
+            for (int i = 0; i < run.length; ++i)
+                _out.u32(static_cast<uint32_t>(*codepoint++));
+        }
+    }
+
+    bool serialize(Line const& _line, GraphicsAttributes& _currentAttributes, Writer& _out)
+    {
+        if (_line.packed())
+        {
+            serializePacked(_line, _currentAttributes, _out);
+            return true;
+        }
+
+        if (!std::all_of(_line.begin(), _line.end(), isRepresentable))
+            return false;
+
+        auto const blankCell = Cell{};
+        auto used = _line.size();
+        while (used > 0 && _line[static_cast<size_t>(used - 1)] == blankCell)
+            --used;
+
+        _out.u8(CellLine);
+        _out.u8(static_cast<uint8_t>(_line.flags()));
+        _out.u16(static_cast<uint16_t>(_line.size()));
+        _out.u16(static_cast<uint16_t>(used));
+
+        for (int i = 0; i < used; ++i)
+        {
+            Cell const& cell = _line[static_cast<size_t>(i)];
+            bool const attributesChanged = cell.attributes() != _currentAttributes;
+
+            _out.u8(attributesChanged ? AttributesFollow : 0);
+            _out.u8(static_cast<uint8_t>(cell.codepointCount()));
+            _out.u8(static_cast<uint8_t>(cell.width()));
+            for (char32_t const codepoint : cell.codepoints())
+                _out.u32(static_cast<uint32_t>(codepoint));
+
+            if (attributesChanged)
+            {
+                _out.attributes(cell.attributes());
+                _currentAttributes = cell.attributes();
+            }
+        }
+
+        return true;
+    }
+
+    optional<Line> deserializePacked(GraphicsAttributes& _currentAttributes, Reader& _in)
+    {
+        auto const flags = static_cast<Line::Flags>(_in.u8());
+        auto const runCount = _in.u16();
+
+        auto packed = Line::PackedCells{};
+        packed.runs.reserve(runCount);
+        for (int k = 0; k < runCount && _in.good(); ++k)
+        {
+            auto const header = _in.u8();
+            auto const length = _in.u16();
+            if (header & AttributesFollow)
+                _currentAttributes = _in.attributes();
+
+            packed.runs.emplace_back(Line::AttributeRun{length, _currentAttributes});
+            for (int i = 0; i < length; ++i)
+                packed.codepoints.push_back(static_cast<char32_t>(_in.u32()));
+        }
+
+        if (!_in.good() || packed.codepoints.empty())
+            return nullopt;
+
+        return Line(std::move(packed), flags);
+    }
+
+    optional<Line> deserialize(GraphicsAttributes& _currentAttributes, Reader& _in)
+    {
+        switch (_in.u8())
+        {
+            case CellLine:
+                break;
+            case PackedLine:
+                return deserializePacked(_currentAttributes, _in);
+            default:
+                return nullopt;
+        }
+
+        auto const flags = static_cast<Line::Flags>(_in.u8());
+        auto const width = _in.u16();
+        auto const used = _in.u16();
+        if (!_in.good() || used > width)
+            return nullopt;
+
+        auto line = Line(width, Cell{}, flags);
+        for (size_t i = 0; i < used; ++i)
+        {
+            Cell& cell = line[i];
+            auto const header = _in.u8();
+            auto const codepointCount = _in.u8();
+            auto const cellWidth = _in.u8();
+
+            for (int k = 0; k < codepointCount; ++k)
+            {
+                auto const codepoint = static_cast<char32_t>(_in.u32());
+                if (k == 0)
+                    cell.setCharacter(codepoint);
+                else
+                    cell.appendCharacter(codepoint);
+            }
+            cell.setWidth(cellWidth);
+
+            if (header & AttributesFollow)
+                _currentAttributes = _in.attributes();
+
+            cell.attributes() = _currentAttributes;
+        }
+
+        if (!_in.good())
+            return nullopt;
+
+        return {std::move(line)};
+    }
+} // }}}
+
+HistoryPager::Extent HistoryPager::allocate(size_t _size)
+{
+    // First-fit reuse of previously released file space.
+    auto i = find_if(freeExtents_.begin(), freeExtents_.end(),
+                     [=](Extent const& _extent) { return _extent.size >= _size; });
+    if (i != freeExtents_.end())
+    {
+        auto const extent = Extent{i->offset, _size};
+        if (i->size == _size)
+            freeExtents_.erase(i);
+        else
+        {
+            i->offset += static_cast<long>(_size);
+            i->size -= _size;
+        }
+        return extent;
+    }
+
+    auto const extent = Extent{fileSize_, _size};
+    fileSize_ += static_cast<long>(_size);
+    return extent;
+}
+
+bool HistoryPager::store(PageId _page, crispy::range<Lines::const_iterator> _lines)
+{
+    Bytes data;
+    auto out = Writer{data};
+    auto currentAttributes = GraphicsAttributes{};
+
+    out.u16(static_cast<uint16_t>(_lines.size()));
+    for (Line const& line : _lines)
+        if (!serialize(line, currentAttributes, out))
+            return false;
+
+    if (!file_)
+    {
+        file_.reset(std::tmpfile());
+        if (!file_)
+            return false;
+    }
+
+    erase(_page);
+
+    auto const extent = allocate(data.size());
+    if (std::fseek(file_.get(), extent.offset, SEEK_SET) != 0
+            || std::fwrite(data.data(), 1, data.size(), file_.get()) != data.size())
+    {
+        freeExtents_.emplace_back(extent);
+        return false;
+    }
+
+    pages_[_page] = extent;
+    storedBytes_ += extent.size;
+    return true;
+}
+
+bool HistoryPager::load(PageId _page, int _skip, crispy::range<Lines::iterator> _lines) const
+{
+    auto const i = pages_.find(_page);
+    if (i == pages_.end())
+        return false;
+
+    auto const extent = i->second;
+    auto data = Bytes(extent.size);
+    if (std::fseek(file_.get(), extent.offset, SEEK_SET) != 0
+            || std::fread(data.data(), 1, data.size(), file_.get()) != data.size())
+        return false;
+
+    auto in = Reader{data.data(), data.data() + data.size()};
+    auto currentAttributes = GraphicsAttributes{};
+    auto const count = static_cast<int>(in.u16());
+    auto output = _lines.begin();
+
+    for (int k = 0; k < count && output != _lines.end(); ++k)
+    {
+        auto line = deserialize(currentAttributes, in);
+        if (!line.has_value())
+            return false;
+
+        if (k >= _skip)
+            *output++ = std::move(*line);
+    }
+
+    return true;
+}
+
+void HistoryPager::erase(PageId _page)
+{
+    if (auto const i = pages_.find(_page); i != pages_.end())
+    {
+        storedBytes_ -= i->second.size;
+        freeExtents_.emplace_back(i->second);
+        pages_.erase(i);
+    }
+
+    if (pages_.empty())
+    {
+        // Nothing is referencing the file anymore, start over from the beginning.
+        freeExtents_.clear();
+        fileSize_ = 0;
+    }
+}
+
+void HistoryPager::eraseBefore(PageId _page)
+{
+    while (!pages_.empty() && pages_.begin()->first < _page)
+        erase(pages_.begin()->first);
+}
+
+void HistoryPager::clear()
+{
+    pages_.clear();
+    freeExtents_.clear();
+    storedBytes_ = 0;
+    fileSize_ = 0;
+}
+
+} // end namespace
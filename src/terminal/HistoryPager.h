@@ -0,0 +1,101 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Grid.h>
+
+#include <crispy/range.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace terminal {
+
+/**
+ * Off-memory storage for pages of scrollback history lines.
+ *
+ * Each page holds a group of consecutive lines, which are serialized into a compact
+ * form (trailing blank cells are dropped and graphics attributes are only stored
+ * when they change from one cell to the next) and written into an anonymous
+ * temporary file that is deleted automatically when the pager is destroyed.
+ * Packed lines (see Line::PackedCells) are stored run by run and loaded back in
+ * packed form.
+ *
+ * Cells carrying hyperlinks or image fragments cannot be represented and
+ * render the whole page unstorable.
+ */
+class HistoryPager {
+  public:
+    using PageId = int64_t;
+
+    HistoryPager() = default;
+    HistoryPager(HistoryPager const&) = delete;
+    HistoryPager& operator=(HistoryPager const&) = delete;
+    HistoryPager(HistoryPager&&) = default;
+    HistoryPager& operator=(HistoryPager&&) = default;
+
+    /// Tests whether or not the given page has been stored.
+    bool contains(PageId _page) const noexcept { return pages_.count(_page) != 0; }
+
+    /// Serializes and stores the given lines as page @p _page.
+    ///
+    /// @retval true  the page has been stored.
+    /// @retval false the lines cannot be represented in paged form or an I/O error occured.
+    bool store(PageId _page, crispy::range<Lines::const_iterator> _lines);
+
+    /// Loads the lines of page @p _page, skipping the first @p _skip lines of the page,
+    /// into the given range of lines.
+    ///
+    /// @retval true  lines have been loaded.
+    /// @retval false the page is not available.
+    bool load(PageId _page, int _skip, crispy::range<Lines::iterator> _lines) const;
+
+    /// Discards the given page, making its file space available for reuse.
+    void erase(PageId _page);
+
+    /// Discards all pages with an ID less than @p _page.
+    void eraseBefore(PageId _page);
+
+    /// Discards all pages.
+    void clear();
+
+    /// @returns number of pages currently stored.
+    size_t pageCount() const noexcept { return pages_.size(); }
+
+    /// @returns number of bytes used in the backing file for stored pages.
+    size_t storedBytes() const noexcept { return storedBytes_; }
+
+  private:
+    struct Extent {
+        long offset;
+        size_t size;
+    };
+
+    struct FileCloser {
+        void operator()(std::FILE* _file) const noexcept { std::fclose(_file); }
+    };
+
+    Extent allocate(size_t _size);
+
+    std::unique_ptr<std::FILE, FileCloser> file_;
+    long fileSize_ = 0;
+    size_t storedBytes_ = 0;
+    std::map<PageId, Extent> pages_;
+    std::vector<Extent> freeExtents_;
+};
+
+} // end namespace
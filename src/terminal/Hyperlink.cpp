@@ -0,0 +1,89 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+using std::string;
+using std::vector;
+
+namespace terminal {
+
+HyperlinkId HyperlinkStorage::intern(string const& _userId, URI const& _uri)
+{
+    if (!_userId.empty())
+        if (auto const i = userIds_.find(_userId); i != userIds_.end())
+            return i->second;
+
+    HyperlinkId id = None;
+    if (!freeIds_.empty())
+    {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    }
+    else if (entries_.size() <= MaxEntries)
+    {
+        id = static_cast<HyperlinkId>(entries_.size());
+        entries_.emplace_back();
+    }
+    else
+        return None;
+
+    entries_[id].emplace(HyperlinkInfo{_userId, _uri});
+    ++size_;
+
+    if (!_userId.empty())
+        userIds_[_userId] = id;
+
+    return id;
+}
+
+void HyperlinkStorage::collectGarbage(vector<bool> const& _used)
+{
+    for (size_t id = 1; id < entries_.size(); ++id)
+    {
+        if (!entries_[id].has_value() || (id < _used.size() && _used[id]))
+            continue;
+
+        if (auto const i = userIds_.find(entries_[id]->id); i != userIds_.end() && i->second == id)
+            userIds_.erase(i);
+
+        entries_[id].reset();
+        freeIds_.push_back(static_cast<HyperlinkId>(id));
+        --size_;
+    }
+
+    // Trim released IDs at the end, so that idLimit() stays tight.
+    while (entries_.size() > 1 && !entries_.back().has_value())
+        entries_.pop_back();
+    freeIds_.erase(std::remove_if(freeIds_.begin(), freeIds_.end(),
+                                  [&](HyperlinkId _id) { return _id >= entries_.size(); }),
+                   freeIds_.end());
+
+    // Capped, so that a collection is still due once all IDs are in use.
+    collectionThreshold_ = min(max(MinCollectionThreshold, 2 * size_), MaxEntries);
+}
+
+void HyperlinkStorage::clear()
+{
+    entries_.resize(1);
+    freeIds_.clear();
+    userIds_.clear();
+    size_ = 0;
+    collectionThreshold_ = MinCollectionThreshold;
+}
+
+} // end namespace
@@ -13,10 +13,13 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <list>
 #include <memory>
+#include <vector>
 
 namespace terminal {
 
@@ -70,7 +73,69 @@ struct HyperlinkInfo { // TODO: rename to Hyperlink
     }
 };
 
-using HyperlinkRef = std::shared_ptr<HyperlinkInfo>;
+/// Small integer handle to a hyperlink in a HyperlinkStorage, as stored in grid cells.
+///
+/// The value 0 denotes the absence of a hyperlink.
+using HyperlinkId = uint16_t;
+
+/**
+ * Registry of all hyperlinks referenced by the cells of a screen.
+ *
+ * Cells only store a HyperlinkId, which maps in O(1) to its HyperlinkInfo.
+ * Entries are not reference counted. Instead, the owner periodically runs
+ * collectGarbage() with the set of IDs still referenced by any cell, releasing
+ * all other entries for reuse. A collection is considered due whenever the
+ * number of entries has doubled since the previous collection, which keeps
+ * the amortized cost per registered hyperlink constant.
+ */
+class HyperlinkStorage {
+  public:
+    static constexpr HyperlinkId None = 0;
+    static constexpr size_t MaxEntries = 0xFFFF;
+
+    /// Registers a new hyperlink, or returns the already registered hyperlink
+    /// with the same non-empty user supplied ID (OSC 8 id parameter).
+    ///
+    /// @returns the hyperlink's ID or None if no more IDs are available.
+    HyperlinkId intern(std::string const& _userId, URI const& _uri);
+
+    HyperlinkInfo* hyperlinkById(HyperlinkId _id) noexcept
+    {
+        return _id < entries_.size() && entries_[_id].has_value() ? &*entries_[_id] : nullptr;
+    }
+
+    HyperlinkInfo const* hyperlinkById(HyperlinkId _id) const noexcept
+    {
+        return _id < entries_.size() && entries_[_id].has_value() ? &*entries_[_id] : nullptr;
+    }
+
+    /// @returns number of registered hyperlinks.
+    size_t size() const noexcept { return size_; }
+
+    /// @returns upper bound (exclusive) of all currently used IDs.
+    size_t idLimit() const noexcept { return entries_.size(); }
+
+    /// Tests whether enough hyperlinks were registered since the last collection to make another one worthwhile.
+    bool collectionDue() const noexcept { return size_ >= collectionThreshold_; }
+
+    /// Releases all hyperlinks whose ID is not flagged in @p _used (indexed by HyperlinkId).
+    void collectGarbage(std::vector<bool> const& _used);
+
+    /// Forgets all user supplied IDs, so that they may be bound to new hyperlinks,
+    /// whereas already registered hyperlinks remain valid.
+    void forgetUserIds() { userIds_.clear(); }
+
+    void clear();
+
+  private:
+    static constexpr size_t MinCollectionThreshold = 64;
+
+    std::vector<std::optional<HyperlinkInfo>> entries_ = std::vector<std::optional<HyperlinkInfo>>(1); // ID 0 (None) is never used.
+    std::vector<HyperlinkId> freeIds_;
+    std::unordered_map<std::string, HyperlinkId> userIds_;
+    size_t size_ = 0;
+    size_t collectionThreshold_ = MinCollectionThreshold;
+};
 
 bool is_local(HyperlinkInfo const& _hyperlink);
 
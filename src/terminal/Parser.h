@@ -33,6 +33,11 @@
 
 #include <fmt/format.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LIBTERMINAL_PARSER_SSE2 1
+#endif
+
 namespace terminal::parser { // {{{ enum class types
 
 enum class State : uint8_t {
@@ -745,6 +750,9 @@ class Parser {
     void processInput(char32_t _ch);
     void handle(ActionClass _actionClass, Action _action, char32_t _char);
 
+    /// @returns end of the run of printable US-ASCII characters starting at @p _begin.
+    static iterator scanPrintableASCII(iterator _begin, iterator _end) noexcept;
+
   private:
     State state_ = State::Ground;
     unicode::utf8_decoder_state utf8DecoderState_{};
@@ -752,12 +760,53 @@ class Parser {
     ParserEvents& eventListener_;
 };
 
+inline Parser::iterator Parser::scanPrintableASCII(iterator _begin, iterator _end) noexcept
+{
+    auto i = _begin;
+
+#if defined(LIBTERMINAL_PARSER_SSE2)
+    // Test 16 bytes at a time, leaving the remainder (and the first mismatching chunk) to the scalar loop.
+    // Bytes >= 0x80 are negative when compared as signed and thus fail the lower bound test.
+    auto const lowerBound = _mm_set1_epi8(0x1F);
+    auto const upperBound = _mm_set1_epi8(0x7F);
+    while (_end - i >= 16)
+    {
+        auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(i));
+        auto const printable = _mm_and_si128(_mm_cmpgt_epi8(chunk, lowerBound),
+                                             _mm_cmplt_epi8(chunk, upperBound));
+        if (_mm_movemask_epi8(printable) != 0xFFFF)
+            break;
+        i += 16;
+    }
+#endif
+
+    while (i != _end && 0x20 <= *i && *i <= 0x7E)
+        ++i;
+
+    return i;
+}
+
 inline void Parser::parseFragment(iterator _begin, iterator _end)
 {
     static constexpr char32_t ReplacementCharacter {0xFFFD};
 
-    for (auto const current : crispy::range(_begin, _end))
+    auto current = _begin;
+    while (current != _end)
     {
+        // Fast path: hand over whole runs of printable US-ASCII text at once,
+        // as these are printed in ground state without any further state transition.
+        if (state_ == State::Ground && utf8DecoderState_.expectedLength == 0)
+        {
+            if (auto const runEnd = scanPrintableASCII(current, _end); runEnd != current)
+            {
+                eventListener_.print(std::string_view(reinterpret_cast<char const*>(current),
+                                                      static_cast<size_t>(runEnd - current)));
+                current = runEnd;
+                continue;
+            }
+        }
+
+        auto const byte = *current++;
 #if 0
         std::visit(
             overloaded{
@@ -771,10 +820,10 @@ inline void Parser::parseFragment(iterator _begin, iterator _end)
                     processInput(success.value);
                 },
             },
-            unicode::from_utf8(utf8DecoderState_, current)
+            unicode::from_utf8(utf8DecoderState_, byte)
         );
 #else
-        unicode::ConvertResult const r = unicode::from_utf8(utf8DecoderState_, current);
+        unicode::ConvertResult const r = unicode::from_utf8(utf8DecoderState_, byte);
         if (std::holds_alternative<unicode::Success>(r))
             processInput(std::get<unicode::Success>(r).value);
         else if (std::holds_alternative<unicode::Invalid>(r))
@@ -39,6 +39,12 @@ class ParserEvents {
      */
     virtual void print(char32_t _text) = 0;
 
+    /**
+     * Bulk variant of print(char32_t), invoked in ground state for a consecutive run of
+     * printable US-ASCII characters (0x20 to 0x7E).
+     */
+    virtual void print(std::string_view _chars) = 0;
+
     /**
      * The C0 or C1 control function should be executed, which may have any one of a variety of
      * effects, including changing the cursor position, suspending or resuming communications or
@@ -145,6 +151,11 @@ class BasicParserEvents : public ParserEvents {
   public:
     void error(std::string_view const&) override {}
     void print(char32_t) override {}
+    void print(std::string_view _chars) override
+    {
+        for (char const ch : _chars)
+            print(static_cast<char32_t>(ch));
+    }
     void execute(char) override {}
     void clear() override {}
     void collect(char) override {}
@@ -36,3 +36,46 @@ TEST_CASE("Parser.utf8_single", "[Parser]")
     CHECK(0xF6 == static_cast<unsigned>(textListener.text.at(0)));
 }
 
+
+TEST_CASE("Parser.print_bulk_ascii", "[Parser]")
+{
+    class BulkTextListener : public terminal::BasicParserEvents {
+      public:
+        std::vector<std::string> runs;
+        std::u32string text;
+
+        void print(char32_t _ch) override { text.push_back(_ch); }
+        void print(string_view _chars) override
+        {
+            runs.emplace_back(_chars);
+            text.append(_chars.begin(), _chars.end());
+        }
+    };
+
+    BulkTextListener listener;
+    auto p = parser::Parser(listener);
+
+    // Long enough to cross multiple 16-byte chunks, interrupted by non-ASCII text and a control sequence.
+    p.parseFragment("Hello, World! This is plain text.\xC3\xB6ok\033[1mbold");
+
+    REQUIRE(listener.runs.size() == 3);
+    CHECK(listener.runs[0] == "Hello, World! This is plain text.");
+    CHECK(listener.runs[1] == "ok");
+    CHECK(listener.runs[2] == "bold");
+    CHECK(listener.text == U"Hello, World! This is plain text.öokbold");
+}
+
+TEST_CASE("Parser.print_bulk_ascii.split_utf8", "[Parser]")
+{
+    MockParserEvents textListener;
+    auto p = parser::Parser(textListener);
+
+    // A multi-byte UTF-8 sequence split across fragments must not be interrupted by the bulk path.
+    p.parseFragment("a\xC3");
+    p.parseFragment("\xB6z");
+
+    REQUIRE(textListener.text.size() == 3);
+    CHECK(textListener.text[0] == 'a');
+    CHECK(textListener.text[1] == 0xF6);
+    CHECK(textListener.text[2] == 'z');
+}
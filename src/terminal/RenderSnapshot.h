@@ -0,0 +1,106 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Grid.h>
+#include <terminal/Hyperlink.h>
+#include <terminal/Sequencer.h> // CursorShape
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace terminal {
+
+/// A single grid cell of the visible page, as captured for rendering.
+struct RenderCell {
+    /// Viewport relative position of this cell.
+    Coordinate position{};
+    Cell cell{};
+    bool selected = false;
+    /// State of the hyperlink this cell is part of, if any.
+    std::optional<HyperlinkState> hyperlink{};
+};
+
+/// Capture state of a single row of the visible page.
+struct RenderLine {
+    /// Revision of the grid line this row has been captured from.
+    Line::Revision revision{};
+
+    /// Whether or not this row differs from the same row of the previous snapshot.
+    bool damaged = true;
+
+    /// Row of the previous snapshot this row's cells have been taken over from, if they
+    /// merely moved due to scrolling.
+    std::optional<int> shiftedFrom{};
+
+    /// Whether or not this row contains hyperlinks.
+    ///
+    /// The state of a hyperlink is not part of the line's revision, so such rows are always captured afresh.
+    bool hyperlinks = false;
+};
+
+struct RenderCursor {
+    /// Viewport relative position of the cursor.
+    Coordinate position;
+    CursorShape shape;
+    int width;
+};
+
+/// Everything needed to render the visible page of a terminal.
+///
+/// A snapshot is captured while holding the terminal's screen lock, so that all
+/// the expensive work (text shaping, texture atlas updates, vertex generation)
+/// can be done afterwards without blocking the terminal from processing
+/// further output.
+///
+/// Snapshots are meant to be reused from frame to frame, which avoids
+/// reallocating the cell buffer for each one. Moreover, only the rows whose
+/// underlying grid lines have been modified since the previous snapshot are
+/// captured again, and rows that merely moved due to scrolling are shifted
+/// in place. See RenderLine.
+struct RenderSnapshot {
+    /// Number of changes that have been applied to the screen since the last snapshot.
+    uint64_t changes = 0;
+
+    /// Whether or not rendering is under pressure, i.e. the screen is being flooded with output.
+    bool pressure = false;
+
+    bool reverseVideo = false;
+
+    /// The cursor, if visible.
+    std::optional<RenderCursor> cursor;
+
+    /// All cells of the visible page, in row-major order.
+    std::vector<RenderCell> cells;
+
+    /// Capture state of each row of the visible page.
+    std::vector<RenderLine> lines;
+
+    /// Whether or not a selection was present at the time of capture.
+    bool selection = false;
+
+    /// @returns whether or not any row differs from the previous snapshot.
+    bool damaged() const noexcept
+    {
+        return std::any_of(lines.begin(), lines.end(), [](RenderLine const& _line) { return _line.damaged; });
+    }
+
+    // Buffers of the previous snapshot, kept around for shifting rows without reallocating.
+    std::vector<RenderLine> previousLines;
+    std::vector<RenderCell> previousCells;
+};
+
+} // end namespace
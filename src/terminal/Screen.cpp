@@ -63,6 +63,7 @@ using std::max;
 using std::min;
 using std::monostate;
 using std::next;
+using std::prev;
 using std::nullopt;
 using std::optional;
 using std::ostringstream;
@@ -70,12 +71,19 @@ using std::pair;
 using std::ref;
 using std::string;
 using std::string_view;
+using std::u32string_view;
 using std::vector;
 
 namespace terminal {
 
 namespace // {{{ helper
 {
+    template <typename Char>
+    constexpr bool isPrintableASCII(Char _ch) noexcept
+    {
+        return 0x20 <= _ch && _ch <= 0x7E;
+    }
+
     class VTWriter {
       public:
         using Writer = std::function<void(char const*, size_t)>;
@@ -289,6 +297,11 @@ void Screen::setMaxHistoryLineCount(optional<int> _maxHistoryLineCount)
     primaryGrid().setMaxHistoryLineCount(_maxHistoryLineCount);
 }
 
+void Screen::setMaxResidentHistoryLineCount(optional<int> _count)
+{
+    primaryGrid().setMaxResidentHistoryLineCount(_count);
+}
+
 void Screen::resizeColumns(int _newColumnCount, bool _clear)
 {
     // DECCOLM / DECSCPP
@@ -341,10 +354,7 @@ void Screen::resize(Size const& _newSize)
 
     // update last-cursor position & iterators
     lastCursorPosition_ = clampCoordinate(lastCursorPosition_);
-    lastColumn_ = columnIteratorAt(
-        begin(*next(begin(grid().mainPage()), lastCursorPosition_.row - 1)), // last line
-        lastCursorPosition_.column
-    );
+    lastColumn_ = columnIteratorAt(begin(grid().lineAt(lastCursorPosition_.row)), lastCursorPosition_.column);
 
     // truncating tabs
     while (!tabs_.empty() && tabs_.back() > _newSize.width)
@@ -421,8 +431,22 @@ void Screen::write(std::u32string_view const& _text)
 
 void Screen::writeText(char32_t _char)
 {
-    bool const consecutiveTextWrite = sequencer_.instructionCounter() == 1;
+    writeTextInternal(_char, sequencer_.instructionCounter() == 1);
+    sequencer_.resetInstructionCounter();
+}
+
+void Screen::writeText(string_view _chars)
+{
+    writeTextSpan(_chars);
+}
+
+void Screen::writeText(u32string_view _chars)
+{
+    writeTextSpan(_chars);
+}
 
+void Screen::writeTextInternal(char32_t _char, bool _consecutiveTextWrite)
+{
     if (wrapPending_ && cursor_.autoWrap)
     {
         linefeed(margin_.horizontal.from);
@@ -435,7 +459,7 @@ void Screen::writeText(char32_t _char)
                     : _char == 0x7F ? ' ' : _char;
 
     bool const insertToPrev =
-        consecutiveTextWrite
+        _consecutiveTextWrite
         && !lastColumn_->empty()
         && unicode::grapheme_segmenter::nonbreakable(lastColumn_->codepoint(lastColumn_->codepointCount() - 1), ch);
 
@@ -443,17 +467,83 @@ void Screen::writeText(char32_t _char)
         writeCharToCurrentAndAdvance(ch);
     else
     {
+        grid().lineAt(lastCursorPosition_.row).touch();
         auto const extendedWidth = lastColumn_->appendCharacter(ch);
 
         if (extendedWidth > 0)
             clearAndAdvance(extendedWidth);
     }
+}
 
+template <typename Char>
+void Screen::writeTextSpan(std::basic_string_view<Char> _chars)
+{
+    auto consecutiveTextWrite = sequencer_.instructionCounter() == 1;
     sequencer_.resetInstructionCounter();
+
+    size_t i = 0;
+    while (i < _chars.size())
+    {
+        // Runs of US-ASCII text are written line by line in one go. The first character of
+        // such a run takes the per-codepoint path, as it may still join the preceding grapheme cluster,
+        // whereas any subsequent US-ASCII character never does.
+        if (i != 0 && isPrintableASCII(_chars[i - 1]))
+        {
+            if (auto const n = writeTextInLine(_chars.substr(i)); n != 0)
+            {
+                i += n;
+                continue;
+            }
+        }
+
+        writeTextInternal(static_cast<char32_t>(_chars[i]), consecutiveTextWrite);
+        consecutiveTextWrite = true;
+        ++i;
+    }
+}
+
+template <typename Char>
+size_t Screen::writeTextInLine(std::basic_string_view<Char> _chars)
+{
+    if (wrapPending_ || !cursor_.charsets.isUSASCII())
+        return 0;
+
+    bool const cursorInsideMargin = isModeEnabled(DECMode::LeftRightMargin) && isCursorInsideMargins();
+    auto const cellsAvailable = cursorInsideMargin ? margin_.horizontal.to - cursor_.position.column
+                                                   : size_.width - cursor_.position.column;
+    if (cellsAvailable <= 0)
+        return 0;
+
+    // The attributes are looked up once for the whole run.
+    auto const& attributes = cursor_.graphicsRendition;
+    auto const hyperlink = currentHyperlink_;
+    auto const maxCount = min(_chars.size(), static_cast<size_t>(cellsAvailable));
+
+    size_t n = 0;
+    while (n < maxCount && isPrintableASCII(_chars[n]))
+    {
+        Cell& cell = *currentColumn_++;
+        cell.setCharacter(static_cast<char32_t>(_chars[n]));
+        cell.attributes() = attributes;
+        cell.setHyperlink(hyperlink);
+        ++n;
+    }
+
+    if (n != 0)
+    {
+        currentLine_->touch();
+        cursor_.position.column += static_cast<int>(n);
+        lastColumn_ = prev(currentColumn_);
+        lastCursorPosition_ = Coordinate{cursor_.position.row, cursor_.position.column - 1};
+    }
+
+    return n;
 }
 
 void Screen::writeCharToCurrentAndAdvance(char32_t _character)
 {
+    currentLine_->touch();
+
     Cell& cell = *currentColumn_;
     cell.setCharacter(_character);
     cell.attributes() = cursor_.graphicsRendition;
@@ -491,6 +581,7 @@ void Screen::clearAndAdvance(int _offset)
     if (n == _offset)
     {
         assert(n > 0);
+        currentLine_->touch();
         cursor_.position.column += n;
         for (auto i = 0; i < n; ++i)
             (currentColumn_++)->reset(cursor_.graphicsRendition, currentHyperlink_);
@@ -630,7 +721,7 @@ void Screen::resetSoft()
     setTopBottomMargin(1, size().height); // DECSTBM
     setLeftRightMargin(1, size().width); // DECRLM
 
-    currentHyperlink_ = {};
+    currentHyperlink_ = HyperlinkStorage::None;
 
     // TODO: DECNKM (Numeric keypad)
     // TODO: DECSCA (Select character attribute)
@@ -652,7 +743,9 @@ void Screen::resetHard()
 
     clearAllTabs();
 
+    auto const maxResidentHistoryLineCount = primaryGrid().maxResidentHistoryLineCount();
     grids_ = emptyGrids(size(), primaryGrid().maxHistoryLineCount());
+    primaryGrid().setMaxResidentHistoryLineCount(maxResidentHistoryLineCount);
     activeGrid_ = &primaryGrid();
     moveCursorTo(Coordinate{1, 1});
 
@@ -664,7 +757,8 @@ void Screen::resetHard()
         Margin::Range{1, size_.width}
     };
 
-    currentHyperlink_ = {};
+    currentHyperlink_ = HyperlinkStorage::None;
+    hyperlinks_.clear();
 }
 
 void Screen::moveCursorTo(Coordinate to)
@@ -753,14 +847,11 @@ string Screen::renderTextLine(int row) const
 string Screen::renderHistoryTextLine(int _lineNumberIntoHistory) const
 {
     assert(1 <= _lineNumberIntoHistory && _lineNumberIntoHistory <= historyLineCount());
-    string line;
-    line.reserve(size_.width);
+    auto const& historyLine = grid().lineAt(1 - _lineNumberIntoHistory);
+    string line = historyLine.toUtf8();
 
-    for (Cell const& cell : grid().lineAt(1 - _lineNumberIntoHistory))
-        if (cell.codepointCount())
-            line += cell.toUtf8();
-        else
-            line += ' '; // fill character
+    // compacted history lines may hold less cells than the screen width
+    line.append(static_cast<size_t>(max(size_.width - historyLine.size(), 0)), ' ');
 
     return line;
 }
@@ -864,11 +955,11 @@ void Screen::sendTerminalId()
 void Screen::clearToEndOfScreen()
 {
     if (isAlternateScreen() && cursor_.position.row == 1 && cursor_.position.column == 1)
-        hyperlinks_.clear();
+        hyperlinks_.forgetUserIds();
 
     clearToEndOfLine();
 
-    for_each(
+    std::for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
         next(currentLine_),
         end(grid().mainPage()),
@@ -882,7 +973,7 @@ void Screen::clearToBeginOfScreen()
 {
     clearToBeginOfLine();
 
-    for_each(
+    std::for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
         begin(grid().mainPage()),
         currentLine_,
@@ -913,6 +1004,7 @@ void Screen::eraseCharacters(int _n)
     // It's not clear from the spec how to perform erase when inside margin and number of chars to be erased would go outside margins.
     // TODO: See what xterm does ;-)
     size_t const n = min(size_.width - realCursorPosition().column + 1, _n == 0 ? 1 : _n);
+    currentLine_->touch();
     fill_n(currentColumn_, n, Cell{{}, cursor_.graphicsRendition});
 }
 
@@ -1083,20 +1175,38 @@ void Screen::setCurrentWorkingDirectory(string const& _url)
 void Screen::hyperlink(string const& _id, string const& _uri)
 {
     if (_uri.empty())
-        currentHyperlink_ = nullptr;
-    else if (_id.empty())
-        currentHyperlink_ = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-    else if (auto i = hyperlinks_.find(_id); i != hyperlinks_.end())
-        currentHyperlink_ = i->second;
-    else
     {
-        currentHyperlink_ = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-        hyperlinks_[_id] = currentHyperlink_;
+        currentHyperlink_ = HyperlinkStorage::None;
+        return;
+    }
+
+    if (hyperlinks_.collectionDue())
+    {
+        // The hyperlink that is about to be closed is not referenced by the cursor anymore.
+        currentHyperlink_ = HyperlinkStorage::None;
+        collectHyperlinks();
     }
-    // TODO:
-    // Care about eviction.
-    // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
-    // alternate screen (not for main screen!)
+
+    currentHyperlink_ = hyperlinks_.intern(_id, _uri);
+
+    // All IDs may be in use by hyperlinks that are not referenced anymore.
+    if (currentHyperlink_ == HyperlinkStorage::None)
+    {
+        collectHyperlinks();
+        currentHyperlink_ = hyperlinks_.intern(_id, _uri);
+    }
+}
+
+void Screen::collectHyperlinks()
+{
+    auto used = vector<bool>(hyperlinks_.idLimit());
+    if (currentHyperlink_ != HyperlinkStorage::None)
+        used[currentHyperlink_] = true;
+
+    for (Grid const& grid : grids_)
+        grid.markHyperlinks(used);
+
+    hyperlinks_.collectGarbage(used);
 }
 
 void Screen::moveCursorUp(int _n)
@@ -1325,85 +1435,14 @@ void Screen::setCursorStyle(CursorDisplay _display, CursorShape _shape)
 
 void Screen::setGraphicsRendition(GraphicsRendition _rendition)
 {
-    // TODO: optimize this as there are only 3 cases
-    // 1.) reset
-    // 2.) set some bits |=
-    // 3.) clear some bits &= ~
-    switch (_rendition)
-    {
-        case GraphicsRendition::Reset:
-            cursor_.graphicsRendition = {};
-            break;
-        case GraphicsRendition::Bold:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Bold;
-            break;
-        case GraphicsRendition::Faint:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Faint;
-            break;
-        case GraphicsRendition::Italic:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Italic;
-            break;
-        case GraphicsRendition::Underline:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Underline;
-            break;
-        case GraphicsRendition::Blinking:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Blinking;
-            break;
-        case GraphicsRendition::Inverse:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Inverse;
-            break;
-        case GraphicsRendition::Hidden:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Hidden;
-            break;
-        case GraphicsRendition::CrossedOut:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::CrossedOut;
-            break;
-        case GraphicsRendition::DoublyUnderlined:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::DoublyUnderlined;
-            break;
-        case GraphicsRendition::CurlyUnderlined:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::CurlyUnderlined;
-            break;
-        case GraphicsRendition::DottedUnderline:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::DottedUnderline;
-            break;
-        case GraphicsRendition::DashedUnderline:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::DashedUnderline;
-            break;
-        case GraphicsRendition::Framed:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Framed;
-            break;
-        case GraphicsRendition::Overline:
-            cursor_.graphicsRendition.styles |= CharacterStyleMask::Overline;
-            break;
-        case GraphicsRendition::Normal:
-            cursor_.graphicsRendition.styles &= ~(CharacterStyleMask::Bold | CharacterStyleMask::Faint);
-            break;
-        case GraphicsRendition::NoItalic:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Italic;
-            break;
-        case GraphicsRendition::NoUnderline:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Underline;
-            break;
-        case GraphicsRendition::NoBlinking:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Blinking;
-            break;
-        case GraphicsRendition::NoInverse:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Inverse;
-            break;
-        case GraphicsRendition::NoHidden:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Hidden;
-            break;
-        case GraphicsRendition::NoCrossedOut:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::CrossedOut;
-            break;
-        case GraphicsRendition::NoFramed:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Framed;
-            break;
-        case GraphicsRendition::NoOverline:
-            cursor_.graphicsRendition.styles &= ~CharacterStyleMask::Overline;
-            break;
-    }
+    auto delta = GraphicsRenditionDelta{};
+    delta.add(_rendition);
+    delta.applyTo(cursor_.graphicsRendition);
+}
+
+void Screen::applyGraphicsRendition(GraphicsRenditionDelta const& _delta)
+{
+    _delta.applyTo(cursor_.graphicsRendition);
 }
 
 void Screen::setMark()
@@ -37,6 +37,8 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
+#include <bitset>
 #include <deque>
 #include <functional>
 #include <list>
@@ -56,52 +58,97 @@ namespace terminal {
 /// API for setting/querying terminal modes.
 ///
 /// This abstracts away the actual implementation for more intuitive use and easier future adaptability.
+///
+/// Modes are stored in dense bitsets, indexed by a compile-time mapping of the mode enums,
+/// making queries constant-time and cheap enough for the per-character write path.
 class Modes {
   public:
-    void set(AnsiMode _mode, bool _enabled)
+    void set(AnsiMode _mode, bool _enabled) { ansi_.set(indexOf(_mode), _enabled); }
+    void set(DECMode _mode, bool _enabled) { dec_.set(indexOf(_mode), _enabled); }
+
+    bool enabled(AnsiMode _mode) const noexcept { return ansi_.test(indexOf(_mode)); }
+    bool enabled(DECMode _mode) const noexcept { return dec_.test(indexOf(_mode)); }
+
+    void save(std::vector<DECMode> const& _modes)
     {
-        if (_enabled)
-            ansi_.insert(_mode);
-        else if (auto i = ansi_.find(_mode); i != ansi_.end())
-            ansi_.erase(i);
+        for (DECMode const mode : _modes)
+            savedModes_[indexOf(mode)].push(enabled(mode));
     }
 
-    void set(DECMode  _mode, bool _enabled)
+    void restore(std::vector<DECMode> const& _modes)
     {
-        if (_enabled)
-            dec_.insert(_mode);
-        else if (auto i = dec_.find(_mode); i != dec_.end())
-            dec_.erase(i);
+        for (DECMode const mode : _modes)
+            if (auto& saved = savedModes_[indexOf(mode)]; !saved.empty())
+                set(mode, saved.pop());
     }
 
-    bool enabled(AnsiMode _mode) const noexcept { return ansi_.find(_mode) != ansi_.end(); }
-
-    bool enabled(DECMode _mode) const noexcept { return dec_.find(_mode) != dec_.end(); }
+  private:
+    // {{{ compile-time mapping of mode enums to dense indices
+    static constexpr size_t AnsiModeCount = 4;
 
-    void save(std::vector<DECMode> const& _modes)
+    static constexpr size_t indexOf(AnsiMode _mode) noexcept
     {
-        for (DECMode const mode : _modes)
-            savedModes_[mode].push_back(enabled(mode));
+        switch (_mode)
+        {
+            case AnsiMode::KeyboardAction: return 0;
+            case AnsiMode::Insert: return 1;
+            case AnsiMode::SendReceive: return 2;
+            case AnsiMode::AutomaticNewLine: return 3;
+        }
+        return 0;
     }
 
-    void restore(std::vector<DECMode> const& _modes)
+    // All DEC modes up to UsePrivateColorRegisters are enumerated sequentially (starting at 0),
+    // the remaining ones carry their VT parameter value and are appended after those.
+    static constexpr size_t SequentialDECModeCount = static_cast<size_t>(DECMode::UsePrivateColorRegisters) + 1;
+    static constexpr size_t DECModeCount = SequentialDECModeCount + 6;
+
+    static constexpr size_t indexOf(DECMode _mode) noexcept
     {
-        for (DECMode const mode : _modes)
+        switch (_mode)
         {
-            if (auto i = savedModes_.find(mode); i != savedModes_.end() && !i->second.empty())
-            {
-                auto& saved = i->second;
-                set(mode, saved.back());
-                saved.pop_back();
-            }
+            case DECMode::MouseExtended: return SequentialDECModeCount + 0;
+            case DECMode::MouseSGR: return SequentialDECModeCount + 1;
+            case DECMode::MouseURXVT: return SequentialDECModeCount + 2;
+            case DECMode::MouseAlternateScroll: return SequentialDECModeCount + 3;
+            case DECMode::BatchedRendering: return SequentialDECModeCount + 4;
+            case DECMode::TextReflow: return SequentialDECModeCount + 5;
+            default: return static_cast<size_t>(_mode);
         }
     }
 
-  private:
-    // TODO: make this a vector<bool> by casting from Mode, but that requires ensured small linearity in Mode enum values.
-    std::set<AnsiMode> ansi_;
-    std::set<DECMode> dec_;
-    std::map<DECMode, std::vector<bool>> savedModes_; //!< saved DEC modes
+    static_assert(SequentialDECModeCount < static_cast<size_t>(DECMode::MouseExtended));
+    // }}}
+
+    /// Stack of saved values of a single mode, with the most recently saved value in the lowest bit.
+    ///
+    /// At most 64 values are kept, saving beyond that drops the oldest saved value.
+    class SavedModeStack {
+      public:
+        bool empty() const noexcept { return depth_ == 0; }
+
+        void push(bool _enabled) noexcept
+        {
+            bits_ = (bits_ << 1) | (_enabled ? 1 : 0);
+            depth_ = std::min(depth_ + 1, 64);
+        }
+
+        bool pop() noexcept
+        {
+            auto const enabled = (bits_ & 1) != 0;
+            bits_ >>= 1;
+            --depth_;
+            return enabled;
+        }
+
+      private:
+        uint64_t bits_ = 0;
+        int depth_ = 0;
+    };
+
+    std::bitset<AnsiModeCount> ansi_;
+    std::bitset<DECModeCount> dec_;
+    std::array<SavedModeStack, DECModeCount> savedModes_{}; //!< saved DEC modes
 };
 // }}}
 
@@ -175,6 +222,10 @@ class Screen {
     void setMaxHistoryLineCount(std::optional<int> _maxHistoryLineCount);
     std::optional<int> maxHistoryLineCount() const noexcept { return grid().maxHistoryLineCount(); }
 
+    /// Sets the maximum number of history lines to keep in memory, paging out any older lines to disk.
+    void setMaxResidentHistoryLineCount(std::optional<int> _count);
+    std::optional<int> maxResidentHistoryLineCount() const noexcept { return grids_[0].maxResidentHistoryLineCount(); }
+
     int historyLineCount() const noexcept { return grid().historyLineCount(); }
 
     /// Writes given data into the screen.
@@ -187,6 +238,15 @@ class Screen {
 
     void writeText(char32_t _char);
 
+    /// Writes a run of printable US-ASCII characters, as passed by the parser's bulk text path.
+    void writeText(std::string_view _chars);
+
+    /// Writes a sequence of codepoints, as if each was passed to writeText(char32_t).
+    ///
+    /// Runs of printable US-ASCII characters are written as a whole, only combining characters,
+    /// wide characters, line wraps and non-US-ASCII charsets take the per-codepoint path.
+    void writeText(std::u32string_view _chars);
+
     /// Renders the full screen by passing every grid cell to the callback.
     template <typename Renderer>
     void render(Renderer&& _render, std::optional<int> _scrollOffset = std::nullopt) const
@@ -280,6 +340,7 @@ class Screen {
     void setUnderlineColor(Color const& _color);
     void setCursorStyle(CursorDisplay _display, CursorShape _shape);
     void setGraphicsRendition(GraphicsRendition _rendition);
+    void applyGraphicsRendition(GraphicsRenditionDelta const& _delta);      // SGR
     void requestMode(std::variant<AnsiMode, DECMode> _mode);
     void setTopBottomMargin(std::optional<int> _top, std::optional<int> _bottom);
     void setLeftRightMargin(std::optional<int> _left, std::optional<int> _right);
@@ -422,11 +483,13 @@ class Screen {
 
     Cell& currentCell() noexcept
     {
+        currentLine_->touch();
         return *currentColumn_;
     }
 
     Cell& currentCell(Cell value)
     {
+        currentLine_->touch();
         *currentColumn_ = std::move(value);
         return *currentColumn_;
     }
@@ -436,8 +499,16 @@ class Screen {
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
     Cell& at(Coordinate const& _coord) noexcept { return grid().at(_coord); }
 
-    /// Gets a reference to the cell relative to screen origin (top left, 1:1).
-    Cell const& at(Coordinate const& _coord) const noexcept { return grid().at(_coord); }
+    /// Gets a copy of the cell relative to screen origin (top left, 1:1).
+    Cell at(Coordinate const& _coord) const { return grid().at(_coord); }
+
+    /// @returns the hyperlink of the cell at the given coordinate relative to screen origin, or nullptr if none.
+    HyperlinkInfo* hyperlinkAt(Coordinate const& _coord) noexcept { return hyperlinks_.hyperlinkById(at(_coord).hyperlink()); }
+    HyperlinkInfo const* hyperlinkAt(Coordinate const& _coord) const noexcept { return hyperlinks_.hyperlinkById(at(_coord).hyperlink()); }
+
+    /// @returns the registry of all hyperlinks referenced by this screen's cells.
+    HyperlinkStorage& hyperlinks() noexcept { return hyperlinks_; }
+    HyperlinkStorage const& hyperlinks() const noexcept { return hyperlinks_; }
 
     bool isPrimaryScreen() const noexcept { return activeGrid_ == &grids_[0]; }
     bool isAlternateScreen() const noexcept { return activeGrid_ == &grids_[1]; }
@@ -554,13 +625,30 @@ class Screen {
     void linefeed(int _column);
 
     void writeCharToCurrentAndAdvance(char32_t _codepoint);
+
+    /// Writes a single codepoint, joining it with the preceding grapheme cluster
+    /// if @p _consecutiveTextWrite is set and the two are nonbreakable.
+    void writeTextInternal(char32_t _char, bool _consecutiveTextWrite);
+
+    template <typename Char>
+    void writeTextSpan(std::basic_string_view<Char> _chars);
+
+    /// Writes the leading printable US-ASCII characters of @p _chars, as far as they fit into
+    /// the current line without wrapping, in one go.
+    ///
+    /// @returns number of characters written, which is 0 if the per-codepoint path must be taken.
+    template <typename Char>
+    size_t writeTextInLine(std::basic_string_view<Char> _chars);
     void clearAndAdvance(int _offset);
 
     void fail(std::string const& _message) const;
 
+    /// Releases all hyperlinks that are not referenced by any cell anymore.
+    void collectHyperlinks();
+
     void updateCursorIterators()
     {
-        currentLine_ = next(begin(grid().mainPage()), cursor_.position.row - 1);
+        currentLine_ = std::next(begin(grid().mainPage()), cursor_.position.row - 1);
         updateColumnIterator();
     }
 
@@ -578,7 +666,7 @@ class Screen {
     /// @returns an iterator to the real column number @p _n.
     ColumnIterator columnIteratorAt(int _n)
     {
-        return columnIteratorAt(std::begin(*currentLine_), _n);
+        return columnIteratorAt(currentLine_->beginUntouched(), _n);
     }
 
     /// @returns an iterator to the real column number @p _n.
@@ -653,8 +741,8 @@ class Screen {
 
     // Hyperlink related
     //
-    HyperlinkRef currentHyperlink_ = {};
-    std::unordered_map<std::string, HyperlinkRef> hyperlinks_; // TODO: use a deque<> instead, always push_back, lookup reverse, evict in front.
+    HyperlinkId currentHyperlink_ = HyperlinkStorage::None;
+    HyperlinkStorage hyperlinks_;
 };
 
 }  // namespace terminal
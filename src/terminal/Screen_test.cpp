@@ -130,6 +130,48 @@ TEST_CASE("AppendChar_CR_LF", "[screen]")
     REQUIRE(screen.cursorPosition() == Coordinate{2, 1});
 }
 
+TEST_CASE("AppendChar.bulk", "[screen]")
+{
+    auto screen = MockScreen{{4, 3}};
+
+    SECTION("wrapping") {
+        screen.write("ABCDEFGHIJ");
+        CHECK("ABCD\nEFGH\nIJ  \n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{3, 3});
+    }
+
+    SECTION("no autowrap") {
+        screen.setMode(DECMode::AutoWrap, false);
+        screen.write("ABCDEFG");
+        CHECK("ABCG\n    \n    \n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{1, 4});
+    }
+
+    SECTION("charset") {
+        screen.write("\033(0qq\033(Bqq");
+        CHECK(U"\u2500\u2500qq" == unicode::from_utf8(screen.renderTextLine(1)));
+    }
+
+    SECTION("attributes") {
+        screen.write("A\033[1mBCD");
+        CHECK_FALSE(screen.at({1, 1}).attributes().styles & CharacterStyleMask::Bold);
+        CHECK(screen.at({1, 2}).attributes().styles & CharacterStyleMask::Bold);
+        CHECK(screen.at({1, 4}).attributes().styles & CharacterStyleMask::Bold);
+    }
+}
+
+TEST_CASE("writeText.u32string_view", "[screen]")
+{
+    auto screen = MockScreen{{5, 1}};
+
+    screen.writeText(U"ae\u0301bc");
+
+    CHECK(screen.at({1, 2}).codepointCount() == 2);
+    CHECK(screen.at({1, 3}).codepoint(0) == 'b');
+    CHECK(screen.at({1, 4}).codepoint(0) == 'c');
+    CHECK(screen.cursorPosition() == Coordinate{1, 5});
+}
+
 TEST_CASE("AppendChar.emoji_exclamationmark", "[screen]")
 {
     auto screen = MockScreen{{5, 1}};
@@ -2230,6 +2272,45 @@ TEST_CASE("DECTABSR", "[screen]")
     }
 }
 
+TEST_CASE("SGR.subparameters", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+
+    screen.write("\033[1;38:2:10:20:30;4:3mA");
+    auto const& attributes = screen.at({1, 1}).attributes();
+    CHECK(attributes.foregroundColor == Color{RGBColor{10, 20, 30}});
+    CHECK(attributes.styles & CharacterStyleMask::Bold);
+    CHECK(attributes.styles & CharacterStyleMask::CurlyUnderlined);
+
+    // Excess parameters and sub-parameters are ignored rather than corrupting preceding ones.
+    screen.write("\033[0;1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;3m\033[4:1:1:1:1:1:1:1:1:1:1mB");
+    CHECK(screen.at({1, 2}).attributes().styles & CharacterStyleMask::Bold);
+    CHECK_FALSE(screen.at({1, 2}).attributes().styles & CharacterStyleMask::Italic);
+    CHECK(screen.at({1, 2}).attributes().styles & CharacterStyleMask::Underline);
+}
+
+TEST_CASE("SGR.folded", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+
+    // Later parameters override earlier ones within the same sequence.
+    screen.write("\033[1;31;22;3;32;24mA");
+    CHECK(screen.at({1, 1}).attributes().foregroundColor == Color{IndexedColor::Green});
+    CHECK(screen.at({1, 1}).attributes().styles.mask() == CharacterStyleMask::Italic);
+
+    screen.write("\033[1;4m\033[33;0;5mB");
+    CHECK(screen.at({1, 2}).attributes().foregroundColor == Color{DefaultColor{}});
+    CHECK(screen.at({1, 2}).attributes().styles.mask() == CharacterStyleMask::Blinking);
+
+    // Repeated sequences are served from the cache and must apply on top of the current state.
+    screen.write("\033[1;31;22;3;32;24mC");
+    CHECK(screen.at({1, 3}).attributes().foregroundColor == Color{IndexedColor::Green});
+    CHECK(screen.at({1, 3}).attributes().styles.mask() == (CharacterStyleMask::Italic | CharacterStyleMask::Blinking));
+
+    screen.write("\033[mD");
+    CHECK(screen.at({1, 4}).attributes() == GraphicsAttributes{});
+}
+
 TEST_CASE("save_restore_DEC_modes", "[screen]")
 {
     auto screen = MockScreen{{2, 2}};
@@ -2244,6 +2325,64 @@ TEST_CASE("save_restore_DEC_modes", "[screen]")
     CHECK_FALSE(screen.isModeEnabled(DECMode::MouseProtocolHighlightTracking));
 }
 
+TEST_CASE("save_restore_DEC_modes.nested", "[screen]")
+{
+    auto screen = MockScreen{{2, 2}};
+    auto const modes = vector{DECMode::MouseSGR, DECMode::TextReflow};
+
+    screen.setMode(DECMode::MouseSGR, true);
+    screen.setMode(DECMode::TextReflow, false);
+    screen.saveModes(modes);
+
+    screen.setMode(DECMode::MouseSGR, false);
+    screen.setMode(DECMode::TextReflow, true);
+    screen.saveModes(modes);
+
+    screen.setMode(DECMode::MouseSGR, true);
+    CHECK_FALSE(screen.isModeEnabled(DECMode::MouseURXVT));
+    CHECK_FALSE(screen.isModeEnabled(DECMode::MouseExtended));
+
+    screen.restoreModes(modes);
+    CHECK_FALSE(screen.isModeEnabled(DECMode::MouseSGR));
+    CHECK(screen.isModeEnabled(DECMode::TextReflow));
+
+    screen.restoreModes(modes);
+    CHECK(screen.isModeEnabled(DECMode::MouseSGR));
+    CHECK_FALSE(screen.isModeEnabled(DECMode::TextReflow));
+
+    // Restoring without any saved state leaves the modes untouched.
+    screen.restoreModes(modes);
+    CHECK(screen.isModeEnabled(DECMode::MouseSGR));
+}
+
+TEST_CASE("hyperlinks.interned", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+
+    screen.write("\033]8;id=a;https://a/\033\\A\033]8;;\033\\B\033]8;id=a;https://a/\033\\C\033]8;;\033\\");
+    REQUIRE(screen.renderTextLine(1) == "ABC ");
+
+    HyperlinkInfo const* a = screen.hyperlinkAt({1, 1});
+    REQUIRE(a != nullptr);
+    CHECK(a->uri == "https://a/");
+    CHECK(screen.hyperlinkAt({1, 2}) == nullptr);
+    CHECK(screen.at({1, 3}).hyperlink() == screen.at({1, 1}).hyperlink());
+    CHECK(screen.hyperlinks().size() == 1);
+}
+
+TEST_CASE("hyperlinks.garbage_collected", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+
+    // Each cell write overwrites the previous hyperlink's only cell.
+    for (int i = 0; i < 1000; ++i)
+        screen.write(fmt::format("\033]8;;https://{}/\033\\X\033]8;;\033\\\r", i));
+
+    CHECK(screen.hyperlinks().size() < 100);
+    REQUIRE(screen.hyperlinkAt({1, 1}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 1})->uri == "https://999/");
+}
+
 // TODO: resize test (should be in Grid_test.cpp?)
 TEST_CASE("resize", "[screen]")
 {
@@ -2363,3 +2502,49 @@ TEST_CASE("resize", "[screen]")
 // TODO: DeviceStatusReport
 // TODO: SendDeviceAttributes
 // TODO: SendTerminalId
+
+TEST_CASE("Screen.line_revisions", "[screen]")
+{
+    auto screen = MockScreen{{3, 3}};
+    screen.write("A\r\nB\r\nC");
+
+    auto const revisions = [&]() {
+        Grid const& grid = static_cast<Screen const&>(screen).grid();
+        return std::array<Line::Revision, 3>{
+            grid.lineAt(1).revision(),
+            grid.lineAt(2).revision(),
+            grid.lineAt(3).revision()
+        };
+    };
+    auto const before = revisions();
+
+    SECTION("cursor movement") {
+        screen.moveCursorTo({1, 1});
+        CHECK(revisions() == before);
+    }
+
+    SECTION("write text") {
+        screen.write("D");
+        auto const after = revisions();
+        CHECK(after[0] == before[0]);
+        CHECK(after[1] == before[1]);
+        CHECK(after[2] != before[2]);
+    }
+
+    SECTION("erase") {
+        screen.moveCursorTo({2, 1});
+        screen.write("\033[K");
+        auto const after = revisions();
+        CHECK(after[0] == before[0]);
+        CHECK(after[1] != before[1]);
+        CHECK(after[2] == before[2]);
+    }
+
+    SECTION("scroll up") {
+        screen.write("\r\n");
+        auto const after = revisions();
+        CHECK(after[0] == before[1]);
+        CHECK(after[1] == before[2]);
+        CHECK(after[2] != before[0]);
+    }
+}
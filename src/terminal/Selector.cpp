@@ -22,14 +22,14 @@ using namespace std;
 namespace terminal {
 
 Selector::Selector(Mode _mode,
-				   GetCellAt _getCellAt,
+				   GetLineAt _getLineAt,
                    GetWrappedFlag _wrappedFlag,
 				   std::u32string const& _wordDelimiters,
 				   int _totalRowCount,
 				   int _columnCount,
 				   Coordinate _from) :
 	mode_{_mode},
-	getCellAt_{move(_getCellAt)},
+	getLineAt_{move(_getLineAt)},
     wrapped_{move(_wrappedFlag)},
 	wordDelimiters_{_wordDelimiters},
 	totalRowCount_{_totalRowCount},
@@ -68,13 +68,11 @@ Selector::Selector(Mode _mode,
                    Coordinate _from) :
     Selector{
         _mode,
-        [screen = std::ref(_screen)](Coordinate _pos) -> Cell const* {
-            assert(_pos.row >= 0 && "must be absolute coordinate");
+        [screen = std::ref(_screen)](int _line) -> Line const* {
+            assert(_line >= 0 && "must be absolute line number");
             auto const& buffer = screen.get();
-            // convert line number  from absolute line to relative line number.
-            auto const row = _pos.row - buffer.historyLineCount() + 1;
-            if (row <= buffer.size().height)
-                return &buffer.at({row, _pos.column});
+            if (_line < buffer.historyLineCount() + buffer.size().height)
+                return &buffer.grid().absoluteLineAt(_line);
             else
                 return nullptr;
         },
@@ -92,7 +90,7 @@ Selector::Selector(Mode _mode,
 Coordinate Selector::stretchedColumn(Coordinate _coord) const noexcept
 {
     Coordinate stretched = _coord;
-    if (Cell const* cell = at(_coord); cell && cell->width() > 1)
+    if (auto const cell = at(_coord); cell && cell->width() > 1)
     {
         // wide character
         stretched.column += cell->width() - 1;
@@ -101,7 +99,7 @@ Coordinate Selector::stretchedColumn(Coordinate _coord) const noexcept
 
     while (stretched.column < columnCount_)
     {
-        if (Cell const* cell = at(stretched); cell)
+        if (auto const cell = at(stretched); cell)
         {
             if (cell->empty())
                 stretched.column++;
@@ -175,7 +173,7 @@ bool Selector::extend(Coordinate const& _coord)
 void Selector::extendSelectionBackward()
 {
     auto const isWordDelimiterAt = [this](Coordinate const& _coord) -> bool {
-        Cell const* cell = at(_coord);
+        auto const cell = at(_coord);
         return !cell || cell->empty() || wordDelimiters_.find(cell->codepoint(0)) != wordDelimiters_.npos;
     };
 
@@ -210,7 +208,7 @@ void Selector::extendSelectionBackward()
 void Selector::extendSelectionForward()
 {
     auto const isWordDelimiterAt = [this](Coordinate const& _coord) -> bool {
-        Cell const* cell = at(_coord);
+        auto const cell = at(_coord);
         return !cell || cell->empty() || wordDelimiters_.find(cell->codepoint(0)) != wordDelimiters_.npos;
     };
 
@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <terminal/Grid.h>          // Cell, Line
 #include <terminal/InputGenerator.h>
 //#include <terminal/Screen.h>
 #include <terminal/Size.h>          // Coordinate
@@ -22,13 +23,13 @@
 #include <fmt/format.h>
 
 #include <functional>
+#include <optional>
 #include <vector>
 #include <utility>
 
 namespace terminal {
 
 class Screen;
-class Cell;
 
 /**
  * Selector API.
@@ -74,11 +75,12 @@ class Selector {
 
 
     enum class Mode { Linear, LinearWordWise, FullLine, Rectangular };
-	using GetCellAt = std::function<Cell const*(Coordinate)>;
+	/// Retrieves the line at the given absolute line number, or nullptr if out of range.
+	using GetLineAt = std::function<Line const*(int)>;
     using GetWrappedFlag = std::function<bool(int)>;
 
     Selector(Mode _mode,
-			 GetCellAt _at,
+			 GetLineAt _lineAt,
              GetWrappedFlag _wrappedFlag,
 			 std::u32string const& _wordDelimiters,
 			 int _totalRowCount,
@@ -154,13 +156,26 @@ class Selector {
 	std::vector<Range> rectangular() const;
 
     /// Renders the current selection into @p _render.
+    ///
+    /// The attribute runs of packed lines are walked directly, without unpacking them.
     template <typename Renderer>
     void render(Renderer&& _render) const
     {
         for (auto const& range : selection())
-            for (auto const col : crispy::times(range.fromColumn, range.length()))
-                if (Cell const* cell = at({range.line, col}); cell != nullptr)
-                    _render(Coordinate{range.line, col}, *cell);
+        {
+            Line const* line = getLineAt_(range.line);
+            if (!line)
+                continue;
+
+            line->visitCells(range.fromColumn, range.toColumn, [&](int _column, Cell const& _cell) {
+                _render(Coordinate{range.line, _column}, _cell);
+            });
+
+            // compacted history lines may hold less cells than the selected range
+            auto const paddingStart = std::max(range.fromColumn, line->size() + 1);
+            for (auto const col : crispy::times(paddingStart, std::max(0, range.toColumn - paddingStart + 1)))
+                _render(Coordinate{range.line, col}, Cell{});
+        }
     }
 
   private:
@@ -175,7 +190,12 @@ class Selector {
 		}
 	}
 
-	Cell const* at(Coordinate const& _pos) const { return getCellAt_(_pos); }
+	std::optional<Cell> at(Coordinate const& _pos) const
+	{
+		if (Line const* line = getLineAt_(_pos.row); line != nullptr)
+			return line->cellAt(_pos.column - 1);
+		return std::nullopt;
+	}
 
 	void extendSelectionBackward();
 	void extendSelectionForward();
@@ -183,7 +203,7 @@ class Selector {
   private:
     State state_{State::Waiting};
 	Mode mode_;
-	GetCellAt getCellAt_;
+	GetLineAt getLineAt_;
     GetWrappedFlag wrapped_;
 	std::u32string wordDelimiters_;
 	int totalRowCount_;
@@ -20,6 +20,7 @@
 #include <crispy/algorithm.h>
 #include <crispy/base64.h>
 #include <crispy/escape.h>
+#include <crispy/FNV.h>
 #include <crispy/debuglog.h>
 #include <crispy/utils.h>
 
@@ -28,6 +29,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <array>
 #include <iostream>             // error logging
 #include <cassert>
@@ -221,7 +223,7 @@ namespace impl // {{{ some command generator helpers
                         auto const b = _seq.subparam(i, 3);
                         if (r <= 255 && g <= 255 && b <= 255)
                         {
-                            *pi = i + 1;
+                            *pi = i;
                             return Color{RGBColor{static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)} };
                         }
                     }
@@ -232,7 +234,7 @@ namespace impl // {{{ some command generator helpers
                 case 5: // ":5:P"
                     if (auto const P = _seq.subparam(i, 1); P <= 255)
                     {
-                        *pi = i + 1;
+                        *pi = i;
                         return static_cast<IndexedColor>(P);
                     }
                     break;
@@ -292,97 +294,99 @@ namespace impl // {{{ some command generator helpers
         return Color{};
 	}
 
-	ApplyResult dispatchSGR(Sequence const& _seq, Screen& _screen)
+	/// Folds all parameters of the given SGR sequence into a single graphics rendition delta.
+	GraphicsRenditionDelta foldSGR(Sequence const& _seq)
 	{
+        auto delta = GraphicsRenditionDelta{};
         if (_seq.parameterCount() == 0)
         {
-           _screen.setGraphicsRendition(GraphicsRendition::Reset);
-            return ApplyResult::Ok;
+            delta.add(GraphicsRendition::Reset);
+            return delta;
         }
 
 		for (size_t i = 0; i < _seq.parameterCount(); ++i)
 		{
 			switch (_seq.param(i))
 			{
-				case 0: _screen.setGraphicsRendition(GraphicsRendition::Reset); break;
-				case 1: _screen.setGraphicsRendition(GraphicsRendition::Bold); break;
-				case 2: _screen.setGraphicsRendition(GraphicsRendition::Faint); break;
-				case 3: _screen.setGraphicsRendition(GraphicsRendition::Italic); break;
+				case 0: delta.add(GraphicsRendition::Reset); break;
+				case 1: delta.add(GraphicsRendition::Bold); break;
+				case 2: delta.add(GraphicsRendition::Faint); break;
+				case 3: delta.add(GraphicsRendition::Italic); break;
 				case 4:
                     if (_seq.subParameterCount(i) == 1)
                     {
                         switch (_seq.subparam(i, 0))
                         {
-                            case 0: _screen.setGraphicsRendition(GraphicsRendition::NoUnderline); break; // 4:0
-                            case 1: _screen.setGraphicsRendition(GraphicsRendition::Underline); break; // 4:1
-                            case 2: _screen.setGraphicsRendition(GraphicsRendition::DoublyUnderlined); break; // 4:2
-                            case 3: _screen.setGraphicsRendition(GraphicsRendition::CurlyUnderlined); break; // 4:3
-                            case 4: _screen.setGraphicsRendition(GraphicsRendition::DottedUnderline); break; // 4:4
-                            case 5: _screen.setGraphicsRendition(GraphicsRendition::DashedUnderline); break; // 4:5
-                            default: _screen.setGraphicsRendition(GraphicsRendition::Underline); break;
+                            case 0: delta.add(GraphicsRendition::NoUnderline); break; // 4:0
+                            case 1: delta.add(GraphicsRendition::Underline); break; // 4:1
+                            case 2: delta.add(GraphicsRendition::DoublyUnderlined); break; // 4:2
+                            case 3: delta.add(GraphicsRendition::CurlyUnderlined); break; // 4:3
+                            case 4: delta.add(GraphicsRendition::DottedUnderline); break; // 4:4
+                            case 5: delta.add(GraphicsRendition::DashedUnderline); break; // 4:5
+                            default: delta.add(GraphicsRendition::Underline); break;
                         }
                     }
                     else
-                        _screen.setGraphicsRendition(GraphicsRendition::Underline);
+                        delta.add(GraphicsRendition::Underline);
 					break;
-				case 5: _screen.setGraphicsRendition(GraphicsRendition::Blinking); break;
-				case 7: _screen.setGraphicsRendition(GraphicsRendition::Inverse); break;
-				case 8: _screen.setGraphicsRendition(GraphicsRendition::Hidden); break;
-				case 9: _screen.setGraphicsRendition(GraphicsRendition::CrossedOut); break;
-				case 21: _screen.setGraphicsRendition(GraphicsRendition::DoublyUnderlined); break;
-				case 22: _screen.setGraphicsRendition(GraphicsRendition::Normal); break;
-				case 23: _screen.setGraphicsRendition(GraphicsRendition::NoItalic); break;
-				case 24: _screen.setGraphicsRendition(GraphicsRendition::NoUnderline); break;
-				case 25: _screen.setGraphicsRendition(GraphicsRendition::NoBlinking); break;
-				case 27: _screen.setGraphicsRendition(GraphicsRendition::NoInverse); break;
-				case 28: _screen.setGraphicsRendition(GraphicsRendition::NoHidden); break;
-				case 29: _screen.setGraphicsRendition(GraphicsRendition::NoCrossedOut); break;
-				case 30: _screen.setForegroundColor(IndexedColor::Black); break;
-				case 31: _screen.setForegroundColor(IndexedColor::Red); break;
-				case 32: _screen.setForegroundColor(IndexedColor::Green); break;
-				case 33: _screen.setForegroundColor(IndexedColor::Yellow); break;
-				case 34: _screen.setForegroundColor(IndexedColor::Blue); break;
-				case 35: _screen.setForegroundColor(IndexedColor::Magenta); break;
-				case 36: _screen.setForegroundColor(IndexedColor::Cyan); break;
-				case 37: _screen.setForegroundColor(IndexedColor::White); break;
-				case 38: _screen.setForegroundColor(parseColor(_seq, &i)); break;
-				case 39: _screen.setForegroundColor(DefaultColor{}); break;
-				case 40: _screen.setBackgroundColor(IndexedColor::Black); break;
-				case 41: _screen.setBackgroundColor(IndexedColor::Red); break;
-				case 42: _screen.setBackgroundColor(IndexedColor::Green); break;
-				case 43: _screen.setBackgroundColor(IndexedColor::Yellow); break;
-				case 44: _screen.setBackgroundColor(IndexedColor::Blue); break;
-				case 45: _screen.setBackgroundColor(IndexedColor::Magenta); break;
-				case 46: _screen.setBackgroundColor(IndexedColor::Cyan); break;
-				case 47: _screen.setBackgroundColor(IndexedColor::White); break;
-				case 48: _screen.setBackgroundColor(parseColor(_seq, &i)); break;
-				case 49: _screen.setBackgroundColor(DefaultColor{}); break;
-                case 51: _screen.setGraphicsRendition(GraphicsRendition::Framed); break;
-                case 53: _screen.setGraphicsRendition(GraphicsRendition::Overline); break;
-                case 54: _screen.setGraphicsRendition(GraphicsRendition::NoFramed); break;
-                case 55: _screen.setGraphicsRendition(GraphicsRendition::NoOverline); break;
+				case 5: delta.add(GraphicsRendition::Blinking); break;
+				case 7: delta.add(GraphicsRendition::Inverse); break;
+				case 8: delta.add(GraphicsRendition::Hidden); break;
+				case 9: delta.add(GraphicsRendition::CrossedOut); break;
+				case 21: delta.add(GraphicsRendition::DoublyUnderlined); break;
+				case 22: delta.add(GraphicsRendition::Normal); break;
+				case 23: delta.add(GraphicsRendition::NoItalic); break;
+				case 24: delta.add(GraphicsRendition::NoUnderline); break;
+				case 25: delta.add(GraphicsRendition::NoBlinking); break;
+				case 27: delta.add(GraphicsRendition::NoInverse); break;
+				case 28: delta.add(GraphicsRendition::NoHidden); break;
+				case 29: delta.add(GraphicsRendition::NoCrossedOut); break;
+				case 30: delta.foregroundColor = IndexedColor::Black; break;
+				case 31: delta.foregroundColor = IndexedColor::Red; break;
+				case 32: delta.foregroundColor = IndexedColor::Green; break;
+				case 33: delta.foregroundColor = IndexedColor::Yellow; break;
+				case 34: delta.foregroundColor = IndexedColor::Blue; break;
+				case 35: delta.foregroundColor = IndexedColor::Magenta; break;
+				case 36: delta.foregroundColor = IndexedColor::Cyan; break;
+				case 37: delta.foregroundColor = IndexedColor::White; break;
+				case 38: delta.foregroundColor = parseColor(_seq, &i); break;
+				case 39: delta.foregroundColor = DefaultColor{}; break;
+				case 40: delta.backgroundColor = IndexedColor::Black; break;
+				case 41: delta.backgroundColor = IndexedColor::Red; break;
+				case 42: delta.backgroundColor = IndexedColor::Green; break;
+				case 43: delta.backgroundColor = IndexedColor::Yellow; break;
+				case 44: delta.backgroundColor = IndexedColor::Blue; break;
+				case 45: delta.backgroundColor = IndexedColor::Magenta; break;
+				case 46: delta.backgroundColor = IndexedColor::Cyan; break;
+				case 47: delta.backgroundColor = IndexedColor::White; break;
+				case 48: delta.backgroundColor = parseColor(_seq, &i); break;
+				case 49: delta.backgroundColor = DefaultColor{}; break;
+                case 51: delta.add(GraphicsRendition::Framed); break;
+                case 53: delta.add(GraphicsRendition::Overline); break;
+                case 54: delta.add(GraphicsRendition::NoFramed); break;
+                case 55: delta.add(GraphicsRendition::NoOverline); break;
                 // 58 is reserved, but used for setting underline/decoration colors by some other VTEs (such as mintty, kitty, libvte)
-                case 58: _screen.setUnderlineColor(parseColor(_seq, &i)); break;
-				case 90: _screen.setForegroundColor(BrightColor::Black); break;
-				case 91: _screen.setForegroundColor(BrightColor::Red); break;
-				case 92: _screen.setForegroundColor(BrightColor::Green); break;
-				case 93: _screen.setForegroundColor(BrightColor::Yellow); break;
-				case 94: _screen.setForegroundColor(BrightColor::Blue); break;
-				case 95: _screen.setForegroundColor(BrightColor::Magenta); break;
-				case 96: _screen.setForegroundColor(BrightColor::Cyan); break;
-				case 97: _screen.setForegroundColor(BrightColor::White); break;
-				case 100: _screen.setBackgroundColor(BrightColor::Black); break;
-				case 101: _screen.setBackgroundColor(BrightColor::Red); break;
-				case 102: _screen.setBackgroundColor(BrightColor::Green); break;
-				case 103: _screen.setBackgroundColor(BrightColor::Yellow); break;
-				case 104: _screen.setBackgroundColor(BrightColor::Blue); break;
-				case 105: _screen.setBackgroundColor(BrightColor::Magenta); break;
-				case 106: _screen.setBackgroundColor(BrightColor::Cyan); break;
-				case 107: _screen.setBackgroundColor(BrightColor::White); break;
+                case 58: delta.underlineColor = parseColor(_seq, &i); break;
+				case 90: delta.foregroundColor = BrightColor::Black; break;
+				case 91: delta.foregroundColor = BrightColor::Red; break;
+				case 92: delta.foregroundColor = BrightColor::Green; break;
+				case 93: delta.foregroundColor = BrightColor::Yellow; break;
+				case 94: delta.foregroundColor = BrightColor::Blue; break;
+				case 95: delta.foregroundColor = BrightColor::Magenta; break;
+				case 96: delta.foregroundColor = BrightColor::Cyan; break;
+				case 97: delta.foregroundColor = BrightColor::White; break;
+				case 100: delta.backgroundColor = BrightColor::Black; break;
+				case 101: delta.backgroundColor = BrightColor::Red; break;
+				case 102: delta.backgroundColor = BrightColor::Green; break;
+				case 103: delta.backgroundColor = BrightColor::Yellow; break;
+				case 104: delta.backgroundColor = BrightColor::Blue; break;
+				case 105: delta.backgroundColor = BrightColor::Magenta; break;
+				case 106: delta.backgroundColor = BrightColor::Cyan; break;
+				case 107: delta.backgroundColor = BrightColor::White; break;
 				default: break; // TODO: logInvalidCSI("Invalid SGR number: {}", _seq.param(i));
 			}
 		}
-		return ApplyResult::Ok;
+		return delta;
 	}
 
 	ApplyResult requestMode(Sequence const& /*_seq*/, unsigned int _mode)
@@ -859,7 +863,7 @@ std::string Sequence::raw() const
         case FunctionCategory::OSC: sstr << "\033]"; break;
     }
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
         for (auto i = 0u; i < parameterCount(); ++i)
         {
@@ -892,35 +896,18 @@ string Sequence::text() const
     if (leaderSymbol_)
         sstr << ' ' << leaderSymbol_;
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
-        sstr << ' ' << accumulate(
-            begin(parameters_), end(parameters_), string{},
-            [](string const& a, auto const& p) -> string {
-                return !a.empty()
-                    ? fmt::format("{};{}",
-                            a,
-                            accumulate(
-                                begin(p), end(p),
-                                string{},
-                                [](string const& x, Sequence::Parameter y) -> string {
-                                    return !x.empty()
-                                        ? fmt::format("{}:{}", x, y)
-                                        : std::to_string(y);
-                                }
-                            )
-                        )
-                    : accumulate(
-                            begin(p), end(p),
-                            string{},
-                            [](string const& x, Sequence::Parameter y) -> string {
-                                return !x.empty()
-                                    ? fmt::format("{}:{}", x, y)
-                                    : std::to_string(y);
-                            }
-                        );
-            }
-        );
+        sstr << ' ';
+        for (auto i = 0u; i < parameterCount(); ++i)
+        {
+            if (i)
+                sstr << ';';
+
+            sstr << param(i);
+            for (auto k = 0u; k < subParameterCount(i); ++k)
+                sstr << ':' << subparam(i, k);
+        }
     }
 
     if (!intermediateCharacters().empty())
@@ -936,6 +923,62 @@ string Sequence::text() const
 }
 // }}}
 
+// {{{ SGRCache
+/// Direct-mapped cache of recently seen SGR parameter lists and their folded graphics rendition delta.
+///
+/// Colorful output tends to repeat the very same few SGR sequences over and over again.
+class SGRCache {
+  public:
+    GraphicsRenditionDelta const& get(Sequence const& _seq)
+    {
+        auto key = Key{};
+        size_t keyLength = 0;
+
+        for (size_t i = 0; i < _seq.parameterCount(); ++i)
+        {
+            if (keyLength + 1 + _seq.subParameterCount(i) > key.size())
+            {
+                // Too long to be worth caching.
+                uncached_ = impl::foldSGR(_seq);
+                return uncached_;
+            }
+
+            key[keyLength++] = _seq.param(i);
+            for (size_t k = 0; k < _seq.subParameterCount(i); ++k)
+                key[keyLength++] = ~_seq.subparam(i, k);
+        }
+
+        auto const hash = crispy::FNV<Sequence::Parameter>{}(key.data(), keyLength);
+        auto& entry = entries_[hash % entries_.size()];
+        if (!entry.valid
+                || entry.keyLength != keyLength
+                || !std::equal(key.begin(), key.begin() + static_cast<long>(keyLength), entry.key.begin()))
+        {
+            entry.key = key;
+            entry.keyLength = keyLength;
+            entry.valid = true;
+            entry.delta = impl::foldSGR(_seq);
+        }
+
+        return entry.delta;
+    }
+
+  private:
+    /// Parameter values, with sub-parameters stored as their bitwise complement.
+    using Key = array<Sequence::Parameter, 16>;
+
+    struct Entry {
+        Key key{};
+        size_t keyLength = 0;
+        bool valid = false;
+        GraphicsRenditionDelta delta{};
+    };
+
+    array<Entry, 64> entries_{};
+    GraphicsRenditionDelta uncached_{};
+};
+// }}}
+
 Sequencer::Sequencer(Screen& _screen,
                      Size _maxImageSize,
                      RGBAColor _backgroundColor,
@@ -943,10 +986,13 @@ Sequencer::Sequencer(Screen& _screen,
     screen_{ _screen },
     imageColorPalette_{ std::move(_imageColorPalette) },
     maxImageSize_{ _maxImageSize },
-    backgroundColor_{ _backgroundColor }
+    backgroundColor_{ _backgroundColor },
+    sgrCache_{ make_unique<SGRCache>() }
 {
 }
 
+Sequencer::~Sequencer() = default;
+
 void Sequencer::error(std::string_view const& _errorString)
 {
     debuglog(VTParserTag).write("Parser error: {}", _errorString);
@@ -963,6 +1009,20 @@ void Sequencer::print(char32_t _char)
     }
 }
 
+void Sequencer::print(string_view _chars)
+{
+    if (batching_)
+    {
+        for (char const ch : _chars)
+            batchedSequences_.emplace_back(static_cast<char32_t>(ch));
+    }
+    else
+    {
+        instructionCounter_++;
+        screen_.writeText(_chars);
+    }
+}
+
 void Sequencer::execute(char _controlCode)
 {
     executeControlFunction(_controlCode);
@@ -985,18 +1045,18 @@ void Sequencer::collectLeader(char _leader)
 
 void Sequencer::param(char _char)
 {
-    if (sequence_.parameters().empty())
-        sequence_.parameters().push_back({0});
+    auto& parameters = sequence_.parameters();
+
+    if (parameters.empty())
+        parameters.addParameter();
 
     switch (_char)
     {
         case ';':
-            if (sequence_.parameters().size() < Sequence::MaxParameters)
-                sequence_.parameters().push_back({0});
+            parameters.addParameter();
             break;
         case ':':
-            if (sequence_.parameters().back().size() < Sequence::MaxParameters)
-                sequence_.parameters().back().push_back({0});
+            parameters.addSubParameter();
             break;
         case '0':
         case '1':
@@ -1008,7 +1068,7 @@ void Sequencer::param(char _char)
         case '7':
         case '8':
         case '9':
-            sequence_.parameters().back().back() = sequence_.parameters().back().back() * 10 + (_char - U'0');
+            parameters.appendDigit(_char - '0');
             break;
     }
 }
@@ -1044,7 +1104,7 @@ void Sequencer::putOSC(char32_t _char)
 void Sequencer::dispatchOSC()
 {
     auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
-    sequence_.parameters().push_back({static_cast<Sequence::Parameter>(code)});
+    sequence_.parameters().addParameter(static_cast<Sequence::Parameter>(code));
     sequence_.intermediateCharacters().erase(0, skipCount);
     handleSequence();
     sequence_.clear();
@@ -1405,7 +1465,7 @@ ApplyResult Sequencer::apply(FunctionDefinition const& _function, Sequence const
         case SCOSC: screen_.saveCursor(); break;
         case SD: screen_.scrollDown(_seq.param_or(0, Sequence::Parameter{1})); break;
         case SETMARK: screen_.setMark(); break;
-        case SGR: return impl::dispatchSGR(_seq, screen_);
+        case SGR: screen_.applyGraphicsRendition(sgrCache_->get(_seq)); break;
         case SM: for_each(crispy::times(_seq.parameterCount()), [&](size_t i) { impl::setAnsiMode(_seq, i, true, screen_); }); break;
         case SU: screen_.scrollUp(_seq.param_or(0, Sequence::Parameter{1})); break;
         case TBC: return impl::TBC(_seq, screen_);
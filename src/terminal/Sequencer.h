@@ -19,6 +19,9 @@
 #include <terminal/Functions.h>
 #include <terminal/SixelParser.h>
 
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -398,10 +401,83 @@ enum class ApplyResult {
 class Sequence {
   public:
     using Parameter = int;
-    using ParameterList = std::vector<std::vector<Parameter>>;
     using Intermediaries = std::string;
     using DataString = std::string;
 
+    size_t constexpr static MaxParameters = 16;
+    size_t constexpr static MaxSubParameters = 8;
+    size_t constexpr static MaxOscLength = 512;
+
+    /// Fixed-capacity parameter storage, never allocating.
+    ///
+    /// All values are stored in one flat array, where each parameter occupies one value,
+    /// directly followed by its sub-parameters. Parameters beyond MaxParameters and
+    /// sub-parameters beyond MaxSubParameters are silently ignored.
+    class ParameterList {
+      public:
+        bool empty() const noexcept { return count_ == 0; }
+        size_t size() const noexcept { return count_; }
+
+        void clear() noexcept
+        {
+            count_ = 0;
+            valueCount_ = 0;
+            discarding_ = false;
+        }
+
+        /// Appends a new parameter with the given initial value.
+        void addParameter(Parameter _value = 0) noexcept
+        {
+            discarding_ = count_ == MaxParameters;
+            if (discarding_)
+                return;
+
+            offsets_[count_++] = static_cast<uint8_t>(valueCount_);
+            values_[valueCount_++] = _value;
+        }
+
+        /// Appends a new sub-parameter of value 0 to the last parameter.
+        void addSubParameter() noexcept
+        {
+            discarding_ = discarding_ || count_ == 0 || subParameterCount(count_ - 1) == MaxSubParameters;
+            if (!discarding_)
+                values_[valueCount_++] = 0;
+        }
+
+        /// Appends a decimal digit to the last (sub-)parameter value.
+        void appendDigit(int _digit) noexcept
+        {
+            if (!discarding_ && valueCount_ != 0)
+                values_[valueCount_ - 1] = values_[valueCount_ - 1] * 10 + _digit;
+        }
+
+        Parameter value(size_t _index) const noexcept
+        {
+            assert(_index < count_);
+            return values_[offsets_[_index]];
+        }
+
+        size_t subParameterCount(size_t _index) const noexcept
+        {
+            assert(_index < count_);
+            auto const end = _index + 1 < count_ ? offsets_[_index + 1] : valueCount_;
+            return end - offsets_[_index] - 1;
+        }
+
+        Parameter subParameter(size_t _index, size_t _subIndex) const noexcept
+        {
+            assert(_subIndex < subParameterCount(_index));
+            return values_[offsets_[_index] + 1 + _subIndex];
+        }
+
+      private:
+        std::array<Parameter, MaxParameters * (1 + MaxSubParameters)> values_{};
+        std::array<uint8_t, MaxParameters> offsets_{};
+        size_t count_ = 0;
+        size_t valueCount_ = 0;
+        bool discarding_ = false;
+    };
+
   private:
     FunctionCategory category_;
     char leaderSymbol_ = 0;
@@ -411,18 +487,6 @@ class Sequence {
     DataString dataString_;
 
   public:
-    size_t constexpr static MaxParameters = 16;
-    size_t constexpr static MaxSubParameters = 8;
-    size_t constexpr static MaxOscLength = 512;
-
-    Sequence()
-    {
-        parameters_.resize(MaxParameters);
-        for (auto& param : parameters_)
-            param.reserve(MaxSubParameters);
-        parameters_.clear();
-    }
-
     // mutators
     //
     void clear()
@@ -461,7 +525,7 @@ class Sequence {
         switch (category_)
         {
             case FunctionCategory::OSC:
-                return FunctionSelector{category_, 0, parameters_[0][0], 0, 0};
+                return FunctionSelector{category_, 0, parameters_.value(0), 0, 0};
             default:
             {
                 // Only support CSI sequences with 0 or 1 intermediate characters.
@@ -482,12 +546,12 @@ class Sequence {
 
     ParameterList const& parameters() const noexcept { return parameters_; }
     size_t parameterCount() const noexcept { return parameters_.size(); }
-    size_t subParameterCount(size_t _index) const noexcept { return parameters_[_index].size() - 1; }
+    size_t subParameterCount(size_t _index) const noexcept { return parameters_.subParameterCount(_index); }
 
     std::optional<Parameter> param_opt(size_t _index) const noexcept
     {
-        if (_index < parameters_.size() && parameters_[_index][0])
-            return {parameters_[_index][0]};
+        if (_index < parameters_.size() && parameters_.value(_index))
+            return {parameters_.value(_index)};
         else
             return std::nullopt;
     }
@@ -499,16 +563,12 @@ class Sequence {
 
     int param(size_t _index) const noexcept
     {
-        assert(_index < parameters_.size());
-        assert(0 < parameters_[_index].size());
-        return parameters_[_index][0];
+        return parameters_.value(_index);
     }
 
     int subparam(size_t _index, size_t _subIndex) const noexcept
     {
-        assert(_index < parameters_.size());
-        assert(_subIndex + 1 < parameters_[_index].size());
-        return parameters_[_index][_subIndex + 1];
+        return parameters_.subParameter(_index, _subIndex);
     }
 
     bool containsParameter(int _value) const noexcept
@@ -520,6 +580,8 @@ class Sequence {
     }
 };
 
+class SGRCache;
+
 /// Sequencer - The semantic VT analyzer layer.
 ///
 /// Sequencer implements the translation from VT parser events, forming a higher level Sequence,
@@ -539,6 +601,8 @@ class Sequencer : public ParserEvents {
                     RGBAColor{},
                     std::make_shared<ColorPalette>()) {}
 
+    ~Sequencer() override;
+
     void setMaxImageSize(Size _value) { maxImageSize_ = _value; }
     void setMaxImageColorRegisters(int _value) { maxImageRegisterCount_ = _value; }
     void setUsePrivateColorRegisters(bool _value) { usePrivateColorRegisters_ = _value; }
@@ -554,6 +618,7 @@ class Sequencer : public ParserEvents {
     //
     void error(std::string_view const& _errorString) override;
     void print(char32_t _text) override;
+    void print(std::string_view _chars) override;
     void execute(char _controlCode) override;
     void clear() override;
     void collect(char _char) override;
@@ -595,6 +660,8 @@ class Sequencer : public ParserEvents {
     Size maxImageSize_;
     int maxImageRegisterCount_;
     RGBAColor backgroundColor_;
+
+    std::unique_ptr<SGRCache> sgrCache_;
 };
 
 }  // namespace terminal
@@ -35,6 +35,13 @@ namespace terminal {
 
 namespace {
     auto const KeyboardTag = crispy::debugtag::make("terminal.input", "Logs terminal input events.");
+
+    /// Capacity of the buffer between PTY reader and screen update thread.
+    constexpr size_t PtyBufferSize = 1024 * 1024;
+
+    /// Maximum number of bytes to process while holding the screen lock,
+    /// so that rendering is not blocked for too long.
+    constexpr size_t MaxScreenUpdateBatchSize = 128 * 1024;
 }
 
 Terminal::Terminal(std::unique_ptr<Pty> _pty,
@@ -68,34 +75,226 @@ Terminal::Terminal(std::unique_ptr<Pty> _pty,
         _maxImageColorRegisters,
         _sixelCursorConformance
     },
+    ptyBuffer_{ PtyBufferSize },
+    ptyReaderThread_{ [this]() { ptyReaderThread(); } },
     screenUpdateThread_{ [this]() { screenUpdateThread(); } },
-    viewport_{ screen_ }
+    viewport_{
+        screen_,
+        [this](int _start, int _end) {
+            auto const _l = lock_guard{ screenLock_ };
+            screen_.grid().pageIn(_start, _end);
+        }
+    }
 {
 }
 
 Terminal::~Terminal()
 {
+    ptyReaderThread_.join();
     screenUpdateThread_.join();
 }
 
-void Terminal::screenUpdateThread()
+void Terminal::notifyPtyBufferChanged()
+{
+    // Taking the lock ensures the other side is either still going to check the buffer's state
+    // or is already waiting, and therefore cannot miss this notification.
+    { auto const _l = lock_guard{ ptyBufferLock_ }; }
+    ptyBufferChanged_.notify_all();
+}
+
+void Terminal::ptyReaderThread()
 {
-    constexpr size_t BufSize = 32 * 1024;
-    vector<char> buf;
-    buf.resize(BufSize);
+    for (;;)
+    {
+        auto target = ptyBuffer_.writable();
+        if (target.empty())
+        {
+            ++readerStalls_;
+            auto _l = unique_lock{ ptyBufferLock_ };
+            ptyBufferChanged_.wait(_l, [this]() { return !ptyBuffer_.full(); });
+            continue;
+        }
 
+        auto const n = pty_->read(target.begin(), target.size());
+        if (n == -1)
+        {
+            ptyClosed_ = true;
+            notifyPtyBufferChanged();
+            break;
+        }
+
+        //log("outputThread.data: {}", crispy::escape(target.begin(), target.begin() + n));
+        ptyBuffer_.commit(static_cast<size_t>(n));
+        bytesRead_ += static_cast<uint64_t>(n);
+        notifyPtyBufferChanged();
+    }
+}
+
+void Terminal::screenUpdateThread()
+{
     for (;;)
     {
-        if (auto const n = pty_->read(buf.data(), buf.size()); n != -1)
+        auto const source = ptyBuffer_.readable();
+        if (source.empty())
+        {
+            if (ptyClosed_ && ptyBuffer_.empty())
+            {
+                eventListener_.onClosed();
+                break;
+            }
+
+            auto _l = unique_lock{ ptyBufferLock_ };
+            ptyBufferChanged_.wait(_l, [this]() { return !ptyBuffer_.empty() || ptyClosed_; });
+            continue;
+        }
+
+        auto const n = std::min(source.size(), MaxScreenUpdateBatchSize);
         {
-            //log("outputThread.data: {}", crispy::escape(buf, buf + n));
             lock_guard<decltype(screenLock_)> _l{ screenLock_ };
-            screen_.write(buf.data(), n);
+            screen_.write(source.begin(), n);
         }
+        ptyBuffer_.consume(n);
+        ++screenUpdates_;
+        if (!ptyBuffer_.empty())
+            ++processorSaturations_;
+        notifyPtyBufferChanged();
+    }
+}
+
+void Terminal::snapshot(RenderSnapshot& _snapshot,
+                        steady_clock::time_point _now,
+                        Coordinate const& _mousePosition,
+                        bool _pressure) const
+{
+    auto _l = lock_guard{*this};
+
+    _snapshot.changes = preRender(_now);
+    _snapshot.pressure = _pressure && screen_.isPrimaryScreen();
+
+    // cursor
+    auto const& cursor = screen_.cursor();
+    if (cursor.visible
+            && (cursorDisplay_ == CursorDisplay::Steady || cursorBlinkActive())
+            && viewport_.isLineVisible(cursor.position.row))
+    {
+        _snapshot.cursor = RenderCursor{
+            Coordinate{cursor.position.row + viewport_.relativeScrollOffset(), cursor.position.column},
+            screen_.focused() ? cursorShape_ : CursorShape::Rectangle,
+            screen_.at(cursor.position).width()
+        };
+    }
+    else
+        _snapshot.cursor.reset();
+
+    // hovered hyperlink
+    auto const hoveredHyperlink = [&]() -> HyperlinkId {
+        if (_snapshot.pressure || !screen_.contains(_mousePosition))
+            return HyperlinkStorage::None;
+        auto const position = Coordinate{
+            _mousePosition.row - viewport_.relativeScrollOffset(),
+            _mousePosition.column
+        };
+        return screen_.at(position).hyperlink();
+    }();
+
+    // cells
+    auto const pageSize = screen_.size();
+    auto const width = static_cast<size_t>(pageSize.width);
+    auto const height = static_cast<size_t>(pageSize.height);
+    auto const baseLine = viewport_.absoluteScrollOffset().value_or(screen_.historyLineCount());
+    auto const& hyperlinks = screen_.hyperlinks();
+    auto const selection = isSelectionAvailable();
+
+    // Rows are only taken over from the previous snapshot if nothing but their lines' contents matter.
+    bool const reusable = _snapshot.cells.size() == width * height
+                       && _snapshot.lines.size() == height
+                       && _snapshot.reverseVideo == screen_.isModeEnabled(DECMode::ReverseVideo)
+                       && !_snapshot.selection
+                       && !selection;
+
+    _snapshot.reverseVideo = screen_.isModeEnabled(DECMode::ReverseVideo);
+    _snapshot.selection = selection;
+    _snapshot.cells.resize(width * height);
+    _snapshot.lines.swap(_snapshot.previousLines);
+    _snapshot.lines.resize(height);
+
+    auto const& previousLines = _snapshot.previousLines;
+    auto const findPreviousRow = [&](Line::Revision const& _revision, size_t _hint) -> optional<size_t> {
+        if (!reusable)
+            return nullopt;
+        if (_hint < height && previousLines[_hint].revision == _revision)
+            return _hint;
+        for (size_t i = 0; i < height; ++i)
+            if (previousLines[i].revision == _revision)
+                return i;
+        return nullopt;
+    };
+
+    // Determine which rows can be taken over from the previous snapshot.
+    auto const page = screen_.grid().pageAtScrollOffset(viewport_.absoluteScrollOffset());
+    bool shifted = false;
+    size_t shift = 0; // modulo arithmetic, as consecutive rows usually move by the same distance
+    for (auto const && [row, line] : crispy::indexed(page))
+    {
+        RenderLine& target = _snapshot.lines[row];
+        target.revision = line.revision();
+        target.shiftedFrom.reset();
+        target.hyperlinks = false;
+
+        auto const previousRow = findPreviousRow(target.revision, row + shift);
+        if (!previousRow.has_value() || previousLines[*previousRow].hyperlinks)
+            target.damaged = true;
+        else if (*previousRow == row)
+            target.damaged = false;
         else
         {
-            eventListener_.onClosed();
-            break;
+            target.damaged = true;
+            target.shiftedFrom = static_cast<int>(*previousRow) + 1;
+            shift = *previousRow - row;
+            shifted = true;
+        }
+    }
+
+    if (shifted)
+        _snapshot.previousCells.assign(_snapshot.cells.begin(), _snapshot.cells.end());
+
+    for (auto const && [row, line] : crispy::indexed(page))
+    {
+        RenderLine& target = _snapshot.lines[row];
+        auto const rowCells = next(_snapshot.cells.begin(), static_cast<long>(row * width));
+
+        if (target.shiftedFrom.has_value())
+        {
+            auto const sourceCells = next(_snapshot.previousCells.begin(),
+                                          static_cast<long>(static_cast<size_t>(*target.shiftedFrom - 1) * width));
+            copy_n(sourceCells, width, rowCells);
+            for (RenderCell& cell : crispy::range(rowCells, next(rowCells, static_cast<long>(width))))
+                cell.position.row = static_cast<int>(row) + 1;
+        }
+        else if (target.damaged)
+        {
+            screen_.grid().renderLine(
+                [&](Coordinate const& _pos, Cell const& _cell) {
+                    if (_pos.column > pageSize.width)
+                        return;
+
+                    RenderCell& cell = *next(rowCells, _pos.column - 1);
+                    cell.position = _pos;
+                    cell.cell = _cell;
+                    cell.selected = selection && isSelectedAbsolute(Coordinate{baseLine + (_pos.row - 1), _pos.column});
+
+                    if (auto const hyperlink = hyperlinks.hyperlinkById(_cell.hyperlink()); hyperlink != nullptr)
+                    {
+                        target.hyperlinks = true;
+                        cell.hyperlink = _cell.hyperlink() == hoveredHyperlink ? HyperlinkState::Hover
+                                                                               : hyperlink->state;
+                    }
+                    else
+                        cell.hyperlink.reset();
+                },
+                static_cast<int>(row) + 1,
+                line
+            );
         }
     }
 }
@@ -15,15 +15,20 @@
 
 #include <terminal/InputGenerator.h>
 #include <terminal/pty/Pty.h>
+#include <terminal/RenderSnapshot.h>
 #include <terminal/ScreenEvents.h>
 #include <terminal/Screen.h>
 #include <terminal/Selector.h>
 #include <terminal/Viewport.h>
 
+#include <crispy/spsc_ring.h>
+
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -147,11 +152,46 @@ class Terminal : public ScreenEvents {
         updateCursorVisibilityState(_now);
         return changes;
     }
+
+    /// Captures everything needed to render the visible page into @p _snapshot.
+    ///
+    /// The screen lock is held only while capturing, not while rendering the snapshot.
+    ///
+    /// @p _now time hint to use for the eventually blinking cursor.
+    /// @p _mousePosition current mouse position, used to highlight a hovered hyperlink.
+    /// @p _pressure whether or not the renderer is under pressure.
+    void snapshot(RenderSnapshot& _snapshot,
+                  std::chrono::steady_clock::time_point _now,
+                  Coordinate const& _mousePosition,
+                  bool _pressure) const;
     // }}}
 
     void lock() const { screenLock_.lock(); }
     void unlock() const { screenLock_.unlock(); }
 
+    /// Counters for telling apart whether PTY reading or screen processing is the bottleneck.
+    struct PtyStatistics {
+        /// Total number of bytes read from the PTY.
+        uint64_t bytesRead;
+        /// Number of times the PTY reader had to wait for the screen to catch up.
+        uint64_t readerStalls;
+        /// Number of batches of PTY output written to the screen.
+        uint64_t screenUpdates;
+        /// Number of screen updates that left PTY output behind for the next one,
+        /// that is, the screen update thread was saturated.
+        uint64_t processorSaturations;
+    };
+
+    PtyStatistics ptyStatistics() const noexcept
+    {
+        return PtyStatistics{
+            bytesRead_.load(std::memory_order_relaxed),
+            readerStalls_.load(std::memory_order_relaxed),
+            screenUpdates_.load(std::memory_order_relaxed),
+            processorSaturations_.load(std::memory_order_relaxed)
+        };
+    }
+
     /// Only access this when having locked.
     Screen const& screen() const noexcept { return screen_; }
 
@@ -193,10 +233,19 @@ class Terminal : public ScreenEvents {
     Selector* selector() noexcept { return selector_.get(); }
 
     template <typename RenderTarget>
-    void renderSelection(RenderTarget _renderTarget) const
+    void renderSelection(RenderTarget _renderTarget)
     {
-        if (selector_)
-            selector_->render(std::forward<RenderTarget>(_renderTarget));
+        if (!selector_)
+            return;
+
+        {
+            // Selected history lines may have been paged out since they were selected.
+            auto const _l = std::lock_guard{ screenLock_ };
+            auto const [top, bottom] = std::minmax(selector_->from().row, selector_->to().row);
+            screen_.grid().pageIn(top, bottom + 1);
+        }
+
+        selector_->render(std::forward<RenderTarget>(_renderTarget));
     }
 
     void clearSelection();
@@ -221,7 +270,9 @@ class Terminal : public ScreenEvents {
 
   private:
     void flushInput();
+    void ptyReaderThread();
     void screenUpdateThread();
+    void notifyPtyBufferChanged();
     void updateCursorVisibilityState(std::chrono::steady_clock::time_point _now) const;
 
     template <typename Renderer, typename... RemainingPasses>
@@ -291,6 +342,20 @@ class Terminal : public ScreenEvents {
     InputGenerator::Sequence pendingInput_;
     Screen screen_;
     std::mutex mutable screenLock_;
+
+    // PTY output is read by a dedicated thread into this lock-free ring buffer and
+    // processed by the screen update thread, so that a slow screen update never keeps
+    // the PTY reader from draining the kernel buffer.
+    crispy::spsc_ring<char> ptyBuffer_;
+    std::mutex ptyBufferLock_; // Only used to sleep and wake up either side, never for accessing the buffer.
+    std::condition_variable ptyBufferChanged_;
+    std::atomic<bool> ptyClosed_ = false;
+    std::atomic<uint64_t> bytesRead_ = 0;
+    std::atomic<uint64_t> readerStalls_ = 0;
+    std::atomic<uint64_t> screenUpdates_ = 0;
+    std::atomic<uint64_t> processorSaturations_ = 0;
+
+    std::thread ptyReaderThread_;
     std::thread screenUpdateThread_;
     Viewport viewport_;
     std::unique_ptr<Selector> selector_;
@@ -16,6 +16,7 @@
 #include <terminal/Screen.h>
 
 #include <algorithm>
+#include <functional>
 #include <optional>
 
 namespace terminal {
@@ -24,8 +25,13 @@ class Screen;
 
 class Viewport {
   public:
-    explicit Viewport(Screen& _screen) :
-        screen_{ _screen }
+    /// Invoked with the absolute line range [start, end) that is about to become visible,
+    /// allowing paged out history lines to be paged in before being rendered.
+    using PageIn = std::function<void(int, int)>;
+
+    explicit Viewport(Screen& _screen, PageIn _pageIn = {}) :
+        screen_{ _screen },
+        pageIn_{ std::move(_pageIn) }
     {}
 
     /// Returns the absolute offset where 0 is the top of scrollback buffer, and the maximum value the bottom of the screeen (plus history).
@@ -103,6 +109,8 @@ class Viewport {
 
         if (0 <= _absoluteScrollOffset && _absoluteScrollOffset < historyLineCount())
         {
+            if (pageIn_)
+                pageIn_(_absoluteScrollOffset, _absoluteScrollOffset + screenLineCount());
             scrollOffset_.emplace(_absoluteScrollOffset);
             return true;
         }
@@ -152,6 +160,7 @@ class Viewport {
 
   private:
     Screen& screen_;
+    PageIn pageIn_;
     std::optional<int> scrollOffset_; //!< scroll offset relative to scroll top (0) or nullopt if not scrolled into history
 };
 
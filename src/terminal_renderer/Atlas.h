@@ -18,11 +18,13 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <map>
 #include <optional>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace terminal::renderer::atlas {
@@ -41,6 +43,18 @@ constexpr int element_count(Format _format) noexcept
     return 0;
 }
 
+/// Strategy of how textures are placed into an atlas.
+enum class Packing {
+    /// Textures are placed left to right in rows as high as their highest texture.
+    /// Released space is only reused by textures that are no larger.
+    Rows,
+
+    /// Textures are placed left to right on shelves of a few height classes, so that textures of
+    /// differing heights do not waste each other's space. Released space is coalesced with
+    /// adjacent free space, and shelves that become empty are merged and may change their class.
+    Shelves,
+};
+
 struct CreateAtlas {
     unsigned atlas;
     std::reference_wrapper<std::string const> atlasName;
@@ -133,6 +147,80 @@ class TextureAtlasAllocator {
 
     struct Offset { unsigned i, x, y, z; };
 
+    struct Span { unsigned x, width; };
+
+    /// A horizontal strip of an atlas layer, used for Packing::Shelves.
+    struct Shelf {
+        unsigned instance;
+        unsigned z;
+        unsigned y;
+        unsigned height;
+        std::vector<Span> free;         // free space, ordered by x, with adjacent spans coalesced
+
+        bool empty(unsigned _width) const noexcept { return free.size() == 1 && free.front().width == _width; }
+
+        std::optional<unsigned> allocate(unsigned _width)
+        {
+            for (auto i = free.begin(); i != free.end(); ++i)
+            {
+                if (i->width < _width)
+                    continue;
+
+                auto const x = i->x;
+                i->x += _width;
+                i->width -= _width;
+                if (i->width == 0)
+                    free.erase(i);
+                return x;
+            }
+            return std::nullopt;
+        }
+
+        void release(unsigned _x, unsigned _width)
+        {
+            auto i = std::lower_bound(free.begin(), free.end(), _x,
+                                      [](Span const& _span, unsigned _value) { return _span.x < _value; });
+            i = free.insert(i, Span{_x, _width});
+
+            if (auto const next = std::next(i); next != free.end() && i->x + i->width == next->x)
+            {
+                i->width += next->width;
+                free.erase(next);
+            }
+
+            if (i != free.begin())
+            {
+                if (auto const prev = std::prev(i); prev->x + prev->width == i->x)
+                {
+                    prev->width += i->width;
+                    free.erase(i);
+                }
+            }
+        }
+
+        /// @returns the width of the free span the given space would become part of once released.
+        unsigned coalescedWidth(unsigned _x, unsigned _width) const noexcept
+        {
+            auto width = _width;
+            for (Span const& span : free)
+                if (span.x + span.width == _x || span.x == _x + _width)
+                    width += span.width;
+            return width;
+        }
+    };
+
+    struct Allocation {
+        std::list<TextureInfo>::iterator textureInfo;
+        Size slot;                      // size of the space occupied, which may exceed the texture's size
+        std::list<Shelf>::iterator shelf; // shelf the texture has been placed on (Packing::Shelves only)
+    };
+
+    struct Placement {
+        Offset offset;
+        Size slot;
+        std::list<Shelf>::iterator shelf;
+    };
+
   public:
     /**
      * Constructs a texture atlas with given limits.
@@ -145,6 +233,7 @@ class TextureAtlasAllocator {
      * @param _height   atlas texture height
      * @param _format   an arbitrary user defined number that defines the storage format for this texture,
      *                  such as GL_R8 or GL_RBGA8 when using OpenGL
+     * @param _packing  strategy of how textures are placed into the atlas
      */
     TextureAtlasAllocator(unsigned _instanceBaseId,
                           unsigned _maxInstances,
@@ -153,13 +242,15 @@ class TextureAtlasAllocator {
                           unsigned _height,
                           Format _format, // such as GL_R8 or GL_RGBA8
                           CommandListener& _listener,
-                          std::string _name = {})
+                          std::string _name = {},
+                          Packing _packing = Packing::Rows)
       : instanceBaseId_{ _instanceBaseId },
         maxInstances_{ _maxInstances },
         depth_{ _depth },
         width_{ _width },
         height_{ _height },
         format_{ _format },
+        packing_{ _packing },
         name_{ std::move(_name) },
         commandListener_{ _listener },
         currentInstanceId_{ instanceBaseId_ }
@@ -184,6 +275,7 @@ class TextureAtlasAllocator {
     constexpr unsigned width() const noexcept { return width_; }
     constexpr unsigned height() const noexcept { return height_; }
     constexpr Format format() const noexcept { return format_; }
+    constexpr Packing packing() const noexcept { return packing_; }
 
     constexpr unsigned instanceBaseId() const noexcept { return instanceBaseId_; }
 
@@ -201,6 +293,45 @@ class TextureAtlasAllocator {
 
     constexpr unsigned maxTextureHeightInCurrentRow() const noexcept { return maxTextureHeightInCurrentRow_; }
 
+    /// @return number of 2D texture atlases (layers) that have been started to be filled.
+    constexpr unsigned layersInUse() const noexcept
+    {
+        return (currentInstanceId_ - instanceBaseId_) * depth_ + currentZ_ + 1;
+    }
+
+    /// @return area (in pixels) covered by the textures currently stored.
+    constexpr size_t usedArea() const noexcept { return usedArea_; }
+
+    /// @return ratio of the area covered by textures to the area of all layers in use.
+    ///
+    /// The lower this is, the more space is wasted by gaps between textures and released space
+    /// that could not be reused.
+    double occupancy() const noexcept
+    {
+        return static_cast<double>(usedArea_) / (static_cast<double>(layersInUse()) * width_ * height_);
+    }
+
+    /// @return number of the current frame, see nextFrame().
+    constexpr uint64_t currentFrame() const noexcept { return currentFrame_; }
+
+    /// Advances to the next frame.
+    ///
+    /// Must be called once all textures used by the current frame have been rendered,
+    /// as only textures that have not been used in the current frame may be evicted
+    /// (see MetadataTextureAtlas).
+    constexpr void nextFrame() noexcept { ++currentFrame_; }
+
+    /// Changes the maximum 3D depth (z-value), recreating the atlas and thus discarding all textures.
+    void setDepth(unsigned _depth)
+    {
+        for (unsigned id = instanceBaseId_; id <= currentInstanceId_; ++id)
+            commandListener_.destroyAtlas(DestroyAtlas{id, name_});
+
+        clear();
+        depth_ = _depth;
+        notifyCreateAtlas();
+    }
+
     void clear()
     {
         currentInstanceId_ = instanceBaseId_;
@@ -209,6 +340,34 @@ class TextureAtlasAllocator {
         currentY_ = 0;
         maxTextureHeightInCurrentRow_ = 0;
         discarded_.clear();
+        shelves_.clear();
+        allocations_.clear();
+        textureInfos_.clear();
+        usedArea_ = 0;
+    }
+
+    /// Tests whether the space occupied by the given texture can hold a texture of the given size,
+    /// once it has been released.
+    bool fits(TextureInfo const& _info, unsigned _width, unsigned _height) const
+    {
+        auto const i = allocations_.find(&_info);
+        if (i == allocations_.end())
+            return false;
+
+        Allocation const& allocation = i->second;
+        if (packing_ == Packing::Rows)
+            return allocation.slot.width >= _width && allocation.slot.height >= _height;
+
+        // Shelves are only ever (re)used for textures of a height class that fits them.
+        Shelf const& shelf = *allocation.shelf;
+        if (shelf.height < shelfHeight(_height))
+            return false;
+
+        auto const freeWidth = shelf.coalescedWidth(_info.x, allocation.slot.width);
+        if (freeWidth == width_)
+            return true; // the shelf becomes empty and can be of any height class up to its own
+
+        return shelf.height == shelfHeight(_height) && freeWidth >= _width;
     }
 
     TextureInfo const& get(size_t _index) const { return *std::next(std::begin(textureInfos_), _index); }
@@ -235,77 +394,203 @@ class TextureAtlasAllocator {
                               Buffer&& _data,
                               unsigned _user = 0)
     {
-        // check free-map first
-        if (auto i = discarded_.find(Size{_width, _height}); i != end(discarded_))
+        auto const placement = packing_ == Packing::Shelves ? placeOnShelf(_width, _height)
+                                                            : placeInRow(_width, _height);
+        if (!placement.has_value())
+            return nullptr;
+
+        TextureInfo const& info = appendTextureInfo(_width, _height, _targetWidth, _targetHeight,
+                                                    *placement,
+                                                    _user);
+
+        commandListener_.uploadTexture(UploadTexture{
+            std::ref(info),
+            std::move(_data),
+            _format
+        });
+
+        return &info;
+    }
+
+    void release(TextureInfo const& _info)
+    {
+        if (auto const i = allocations_.find(&_info); i != allocations_.end())
         {
-            std::vector<Offset>& discardsForGivenSize = i->second;
-            if (!discardsForGivenSize.empty())
+            if (packing_ == Packing::Shelves)
+                releaseFromShelf(i->second.shelf, _info.x, i->second.slot.width);
+            else
             {
-                TextureInfo const& info = appendTextureInfo(_width, _height, _targetWidth, _targetHeight,
-                                                            discardsForGivenSize.back(),
-                                                            _user);
+                std::vector<Offset>& discardsForGivenSize = discarded_[i->second.slot];
+                discardsForGivenSize.emplace_back(Offset{_info.atlas, _info.x, _info.y, _info.z});
+            }
+            usedArea_ -= size_t{_info.width} * _info.height;
+            textureInfos_.erase(i->second.textureInfo);
+            allocations_.erase(i);
+        }
+    }
 
-                discardsForGivenSize.pop_back();
-                if (discardsForGivenSize.empty())
-                    discarded_.erase(i);
+  private:
+    // {{{ Packing::Rows
+    std::optional<Placement> placeInRow(unsigned _width, unsigned _height)
+    {
+        // check free-map first
+        if (auto i = findDiscarded(_width, _height); i != end(discarded_))
+        {
+            std::vector<Offset>& discardsForGivenSize = i->second;
+            auto const placement = Placement{discardsForGivenSize.back(), i->first, {}};
 
-                commandListener_.uploadTexture(UploadTexture{
-                    std::ref(info),
-                    std::move(_data),
-                    _format
-                });
+            discardsForGivenSize.pop_back();
+            if (discardsForGivenSize.empty())
+                discarded_.erase(i);
 
-                return &info;
-            }
+            return placement;
         }
 
         // fail early if to-be-inserted texture is too large to fit a single page in the whole atlas
         if (_height > height_ || _width > width_)
-            return nullptr;
+            return std::nullopt;
 
         // ensure we have enough width space in current row
         if (currentX_ + _width >= width_ + HorizontalGap && !advanceY())
-            return nullptr;
+            return std::nullopt;
 
         // ensure we have enoguh height space in current row
         if (currentY_ + _height > height_ + VerticalGap && !advanceZ())
-            return nullptr;
+            return std::nullopt;
 
-        TextureInfo const& info = appendTextureInfo(_width, _height, _targetWidth, _targetHeight,
-                                                    Offset{currentInstanceId_, currentX_, currentY_, currentZ_},
-                                                    _user);
+        auto const placement = Placement{
+            Offset{currentInstanceId_, currentX_, currentY_, currentZ_},
+            Size{_width, _height},
+            {}
+        };
 
         currentX_ = std::min(currentX_ + _width + HorizontalGap, width_);
 
         if (_height > maxTextureHeightInCurrentRow_)
             maxTextureHeightInCurrentRow_ = _height;
 
-        commandListener_.uploadTexture(UploadTexture{
-            std::ref(info),
-            std::move(_data),
-            _format
-        });
+        return placement;
+    }
 
-        return &info;
+    /// @returns the smallest size of discarded space that can hold a texture of the given size.
+    std::map<Size, std::vector<Offset>>::iterator findDiscarded(unsigned _width, unsigned _height)
+    {
+        auto best = end(discarded_);
+        for (auto i = discarded_.lower_bound(Size{_width, 0}); i != end(discarded_); ++i)
+        {
+            if (i->first.height < _height)
+                continue;
+
+            if (best == end(discarded_) || i->first.width * i->first.height < best->first.width * best->first.height)
+                best = i;
+
+            if (i->first == Size{_width, _height})
+                break;
+        }
+        return best;
     }
+    // }}}
 
-    void release(TextureInfo const& _info)
+    // {{{ Packing::Shelves
+    /// @returns the height class of shelves to hold textures of the given height.
+    ///
+    /// Heights are rounded up in steps of an eighth of their next power of two (but at least 4),
+    /// which bounds the space wasted above a texture to about 12.5%.
+    unsigned shelfHeight(unsigned _height) const noexcept
+    {
+        unsigned powerOfTwo = 1;
+        while (powerOfTwo < _height)
+            powerOfTwo <<= 1;
+        auto const step = std::max(4u, powerOfTwo / 8);
+        return std::min((_height + step - 1) / step * step, height_);
+    }
+
+    std::optional<Placement> placeOnShelf(unsigned _width, unsigned _height)
+    {
+        if (_height > height_ || _width > width_)
+            return std::nullopt;
+
+        auto const height = shelfHeight(_height);
+        auto const place = [&](std::list<Shelf>::iterator _shelf) -> std::optional<Placement> {
+            if (auto const x = _shelf->allocate(_width + HorizontalGap); x.has_value())
+                return Placement{Offset{_shelf->instance, *x, _shelf->y, _shelf->z},
+                                 Size{_width + HorizontalGap, _shelf->height},
+                                 _shelf};
+            return std::nullopt;
+        };
+
+        // first-fit on shelves of the same height class
+        for (auto shelf = shelves_.begin(); shelf != shelves_.end(); ++shelf)
+            if (shelf->height == height)
+                if (auto const placement = place(shelf); placement.has_value())
+                    return placement;
+
+        // reuse an empty shelf that is high enough, splitting off the remaining height
+        for (auto shelf = shelves_.begin(); shelf != shelves_.end(); ++shelf)
+        {
+            if (shelf->height < height || !shelf->empty(width_))
+                continue;
+
+            if (shelf->height > height)
+            {
+                shelves_.insert(std::next(shelf), Shelf{shelf->instance,
+                                                        shelf->z,
+                                                        shelf->y + height,
+                                                        shelf->height - height,
+                                                        {Span{0, width_}}});
+                shelf->height = height;
+            }
+            return place(shelf);
+        }
+
+        // open a new shelf
+        if (currentY_ + height > height_ && !advanceZ())
+            return std::nullopt;
+
+        auto const shelf = shelves_.insert(shelves_.end(), Shelf{currentInstanceId_,
+                                                                 currentZ_,
+                                                                 currentY_,
+                                                                 height,
+                                                                 {Span{0, width_}}});
+        currentY_ += height + VerticalGap;
+        return place(shelf);
+    }
+
+    void releaseFromShelf(std::list<Shelf>::iterator _shelf, unsigned _x, unsigned _width)
     {
-        auto i = std::find_if(begin(textureInfos_),
-                              end(textureInfos_),
-                              [&](TextureInfo const& ti) -> bool {
-                                  return &ti == &_info;
-                              });
+        _shelf->release(_x, _width);
+        if (!_shelf->empty(width_))
+            return;
+
+        // Merge with vertically adjacent empty shelves, so they can be split up into other height classes.
+        auto const adjacent = [&](Shelf const& _other) {
+            return &_other != &*_shelf
+                && _other.instance == _shelf->instance
+                && _other.z == _shelf->z
+                && _other.empty(width_)
+                && (_other.y + _other.height + VerticalGap == _shelf->y
+                    || _shelf->y + _shelf->height + VerticalGap == _other.y);
+        };
+        for (auto i = std::find_if(shelves_.begin(), shelves_.end(), adjacent);
+                  i != shelves_.end();
+                  i = std::find_if(shelves_.begin(), shelves_.end(), adjacent))
+        {
+            _shelf->y = std::min(_shelf->y, i->y);
+            _shelf->height += i->height + VerticalGap;
+            shelves_.erase(i);
+        }
 
-        if (i != end(textureInfos_))
+        // Give the space back to the layer if the shelf is the last one opened.
+        if (_shelf->instance == currentInstanceId_
+                && _shelf->z == currentZ_
+                && _shelf->y + _shelf->height + VerticalGap == currentY_)
         {
-            std::vector<Offset>& discardsForGivenSize = discarded_[Size{_info.width, _info.height}];
-            discardsForGivenSize.emplace_back(Offset{_info.atlas, _info.x, _info.y, _info.z});
-            textureInfos_.erase(i);
+            currentY_ = _shelf->y;
+            shelves_.erase(_shelf);
         }
     }
+    // }}}
 
-  private:
     constexpr bool advanceY()
     {
         if (currentY_ + maxTextureHeightInCurrentRow_ <= height_)
@@ -321,7 +606,7 @@ class TextureAtlasAllocator {
 
     constexpr bool advanceZ()
     {
-        if (currentZ_ < depth_)
+        if (currentZ_ + 1 < depth_)
         {
             currentZ_++;
             currentY_ = 0;
@@ -335,7 +620,7 @@ class TextureAtlasAllocator {
 
     constexpr bool advanceInstance()
     {
-        if (currentInstanceId_ < instanceBaseId_ + maxInstances_)
+        if (currentInstanceId_ + 1 < instanceBaseId_ + maxInstances_)
         {
             currentInstanceId_++;
             currentZ_ = 0;
@@ -364,36 +649,42 @@ class TextureAtlasAllocator {
 
     TextureInfo const& appendTextureInfo(unsigned _width, unsigned _height,
                                          unsigned _targetWidth, unsigned _targetHeight,
-                                         Offset _offset,
+                                         Placement const& _placement,
                                          unsigned _user)
     {
+        auto const& offset = _placement.offset;
         textureInfos_.emplace_back(TextureInfo{
-            _offset.i,
+            offset.i,
             name_,
-            _offset.x,
-            _offset.y,
-            _offset.z,
+            offset.x,
+            offset.y,
+            offset.z,
             _width,
             _height,
             _targetWidth,
             _targetHeight,
-            static_cast<float>(_offset.x) / static_cast<float>(width_),
-            static_cast<float>(_offset.y) / static_cast<float>(height_),
+            static_cast<float>(offset.x) / static_cast<float>(width_),
+            static_cast<float>(offset.y) / static_cast<float>(height_),
             static_cast<float>(_width) / static_cast<float>(width_),
             static_cast<float>(_height) / static_cast<float>(height_),
             _user
         });
 
-        return textureInfos_.back();
+        auto const textureInfo = std::prev(end(textureInfos_));
+        allocations_.emplace(&*textureInfo, Allocation{textureInfo, _placement.slot, _placement.shelf});
+        usedArea_ += size_t{_width} * _height;
+
+        return *textureInfo;
     }
 
   private:
     unsigned const instanceBaseId_;    // default value to assign to first instance, and incrementing from that point for further instances.
     unsigned const maxInstances_;       // maximum number of atlas instances (e.g. maximum number of OpenGL 3D textures)
-    unsigned const depth_;              // atlas total depth
+    unsigned depth_;                    // atlas total depth
     unsigned const width_;              // atlas total width
     unsigned const height_;             // atlas total height
     Format const format_;               // internal storage format, such as GL_R8 or GL_RGBA8
+    Packing const packing_;             // strategy of how textures are placed into the atlas
 
     std::string const name_;            // atlas human readable name (only for debugging)
     CommandListener& commandListener_;  // atlas event listener (used to perform allocation/modification actions)
@@ -403,12 +694,20 @@ class TextureAtlasAllocator {
     unsigned currentX_ = 0;             // current X-offset to start drawing to
     unsigned currentY_ = 0;             // current Y-offset to start drawing to
     unsigned maxTextureHeightInCurrentRow_ = 0; // current maximum height in the current row (used to increment currentY_ to get to the next row)
+    uint64_t currentFrame_ = 0;         // number of the current frame, for tracking texture usage
 
     std::map<Size, std::vector<Offset>> discarded_; // map of texture size to list of atlas texture offsets of regions that have been discarded and are available for reuse.
+    std::list<Shelf> shelves_;          // shelves opened so far (Packing::Shelves only)
+    size_t usedArea_ = 0;               // area covered by the textures currently stored
 
     std::list<TextureInfo> textureInfos_;
+    std::unordered_map<TextureInfo const*, Allocation> allocations_; // maps textures to the space they occupy
 };
 
+/// Texture atlas of textures that are accessed by a key, each with some attached metadata.
+///
+/// Once the underlying TextureAtlasAllocator is full, the least recently used texture
+/// (that has not been used in the current frame) is evicted to make room for a new one.
 template <typename Key, typename Metadata = int>
 class MetadataTextureAtlas {
   public:
@@ -434,6 +733,9 @@ class MetadataTextureAtlas {
     /// @return boolean indicating whether or not this atlas is empty (has no textures present).
     constexpr bool empty() const noexcept { return allocations_.size() == 0; }
 
+    /// @return number of textures that have been evicted to make room for new ones.
+    constexpr size_t evictions() const noexcept { return evictions_; }
+
     TextureAtlasAllocator& allocator() noexcept { return atlas_; }
     TextureAtlasAllocator const& allocator() const noexcept { return atlas_; }
 
@@ -442,7 +744,7 @@ class MetadataTextureAtlas {
     void clear()
     {
         allocations_.clear();
-        metadata_.clear();
+        recentlyUsed_.clear();
     }
 
     /// Tests whether given sub-texture is being present in this texture atlas.
@@ -479,50 +781,93 @@ class MetadataTextureAtlas {
 
         TextureInfo const* textureInfo = atlas_.insert(_width, _height, _targetWidth, _targetHeight,
                                                        atlas_.format(), std::move(_data), _user);
+
+        // The data is only consumed on success, so it can be passed again.
+        if (!textureInfo && evict(_width, _height))
+            textureInfo = atlas_.insert(_width, _height, _targetWidth, _targetHeight,
+                                        atlas_.format(), std::move(_data), _user);
+
         if (!textureInfo)
             return std::nullopt;
 
-        allocations_.emplace(_id, textureInfo);
-
-        if constexpr (!std::is_same_v<Metadata, void>)
-            metadata_.emplace(std::pair{_id, std::move(_metadata)});
+        recentlyUsed_.emplace_front(_id);
+        allocations_.emplace(_id, Allocation{
+            textureInfo,
+            std::move(_metadata),
+            atlas_.currentFrame(),
+            recentlyUsed_.begin()
+        });
 
         return get(_id);
     }
 
     /// Retrieves TextureInfo and Metadata tuple if available, std::nullopt otherwise.
-    [[nodiscard]] std::optional<DataRef> get(Key const& _id) const
+    ///
+    /// The texture is marked as used in the current frame.
+    [[nodiscard]] std::optional<DataRef> get(Key const& _id)
     {
         if (auto const i = allocations_.find(_id); i != allocations_.end())
-            return DataRef{*i->second, metadata_.at(_id)};
+        {
+            Allocation& allocation = i->second;
+            allocation.lastUsed = atlas_.currentFrame();
+            recentlyUsed_.splice(recentlyUsed_.begin(), recentlyUsed_, allocation.recentlyUsed);
+            return DataRef{*allocation.textureInfo, allocation.metadata};
+        }
         else
             return std::nullopt;
     }
 
     void release(Key const& _id)
     {
-        if (auto k = metadata_.find(_id); k != metadata_.end())
-            metadata_.erase(k);
-
         if (auto const i = allocations_.find(_id); i != allocations_.end())
         {
-            TextureInfo const& ti = *i->second;
-            atlas_.release(ti);
-
+            atlas_.release(*i->second.textureInfo);
+            recentlyUsed_.erase(i->second.recentlyUsed);
             allocations_.erase(i);
         }
     }
 
   private:
-    TextureAtlasAllocator& atlas_;
+    /// Evicts the least recently used texture that has not been used in the current frame,
+    /// and whose space can hold a texture of the given size.
+    ///
+    /// @returns whether or not a texture has been evicted.
+    bool evict(unsigned _width, unsigned _height)
+    {
+        for (auto i = recentlyUsed_.rbegin(); i != recentlyUsed_.rend(); ++i)
+        {
+            Allocation const& allocation = allocations_.at(*i);
 
-    std::map<Key, TextureInfo const*> allocations_ = {};
+            // Textures used in the current frame may still be scheduled for rendering,
+            // and so may be all the more recently used ones.
+            if (allocation.lastUsed == atlas_.currentFrame())
+                return false;
+
+            if (atlas_.fits(*allocation.textureInfo, _width, _height))
+            {
+                release(Key{*i});
+                ++evictions_;
+                return true;
+            }
+        }
+        return false;
+    }
 
     // conditionally transform void to int as I can't conditionally enable/disable this member var.
-    std::map<
-        Key,
-        std::conditional_t<std::is_same_v<Metadata, void>, int, Metadata>
-    > metadata_ = {};
+    using MetadataStorage = std::conditional_t<std::is_same_v<Metadata, void>, int, Metadata>;
+
+    struct Allocation {
+        TextureInfo const* textureInfo;
+        MetadataStorage metadata;
+        uint64_t lastUsed;                                  // frame this texture has been used in the last time
+        typename std::list<Key>::iterator recentlyUsed;     // position in recentlyUsed_
+    };
+
+    TextureAtlasAllocator& atlas_;
+
+    std::map<Key, Allocation> allocations_ = {};
+    std::list<Key> recentlyUsed_ = {};                      // most recently used first
+    size_t evictions_ = 0;
 };
 
 } // end namespace
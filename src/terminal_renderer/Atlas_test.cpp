@@ -0,0 +1,333 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/Atlas.h>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace terminal::renderer::atlas;
+
+namespace // {{{ helper
+{
+    class NoopListener : public CommandListener {
+      public:
+        void createAtlas(CreateAtlas const&) override {}
+        void uploadTexture(UploadTexture const&) override {}
+        void renderTexture(RenderTexture const&) override {}
+        void destroyAtlas(DestroyAtlas const&) override {}
+    };
+
+    TextureInfo const* insert(TextureAtlasAllocator& _atlas, unsigned _width, unsigned _height)
+    {
+        return _atlas.insert(_width, _height, _width, _height, Format::Red, Buffer(_width * _height));
+    }
+
+    bool overlapping(TextureInfo const& a, TextureInfo const& b)
+    {
+        return a.atlas == b.atlas
+            && a.z == b.z
+            && a.x < b.x + b.width && b.x < a.x + a.width
+            && a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+} // }}}
+
+TEST_CASE("Atlas.shelves.height_classes", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    auto const a = insert(atlas, 10, 10);
+    auto const b = insert(atlas, 10, 11);
+    auto const c = insert(atlas, 10, 20);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+
+    // 10 and 11 both round up to the same height class and share a shelf.
+    CHECK(a->y == 0);
+    CHECK(b->x == 10);
+    CHECK(b->y == 0);
+
+    // 20 does not, and gets a shelf of its own below.
+    CHECK(c->x == 0);
+    CHECK(c->y == 12);
+    CHECK(atlas.currentY() == 32);
+}
+
+TEST_CASE("Atlas.shelves.coalescing", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    auto const a = insert(atlas, 10, 10);
+    auto const b = insert(atlas, 10, 10);
+    auto const c = insert(atlas, 10, 10);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+    CHECK(c->x == 20);
+
+    // Releasing two adjacent textures leaves one span wide enough for a texture of twice the width.
+    atlas.release(*a);
+    atlas.release(*b);
+    auto const d = insert(atlas, 20, 10);
+    REQUIRE(d != nullptr);
+    CHECK(d->x == 0);
+    CHECK(d->y == 0);
+
+    // Releasing the outer textures first and the middle one last leaves a single span again.
+    auto const e = insert(atlas, 10, 10);
+    REQUIRE(e != nullptr);
+    CHECK(e->x == 30);
+    atlas.release(*d);
+    atlas.release(*e);
+    atlas.release(*c);
+    CHECK(atlas.currentY() == 0);
+    CHECK(atlas.usedArea() == 0);
+}
+
+TEST_CASE("Atlas.shelves.merge_empty", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    auto const a = insert(atlas, 10, 10); // shelf at y=0, 12 high
+    auto const b = insert(atlas, 10, 20); // shelf at y=12, 20 high
+    auto const c = insert(atlas, 10, 28); // shelf at y=32, 28 high
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+    CHECK(b->y == 12);
+    CHECK(c->y == 32);
+    CHECK(atlas.currentY() == 60);
+
+    // Neither of the emptied shelves is high enough on its own, nor is there room for a new one.
+    atlas.release(*a);
+    atlas.release(*b);
+
+    auto const d = insert(atlas, 30, 30);
+    REQUIRE(d != nullptr);
+    CHECK(d->x == 0);
+    CHECK(d->y == 0);
+    CHECK(atlas.currentY() == 60);
+}
+
+TEST_CASE("Atlas.shelves.give_back", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    auto const a = insert(atlas, 10, 10);
+    auto const b = insert(atlas, 10, 20);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    CHECK(atlas.currentY() == 32);
+
+    atlas.release(*b);
+    CHECK(atlas.currentY() == 12);
+
+    atlas.release(*a);
+    CHECK(atlas.currentY() == 0);
+
+    // The whole layer is available again.
+    auto const c = insert(atlas, 60, 60);
+    REQUIRE(c != nullptr);
+    CHECK(c->x == 0);
+    CHECK(c->y == 0);
+}
+
+TEST_CASE("Atlas.shelves.fits", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    auto const a = insert(atlas, 10, 10);
+    auto const b = insert(atlas, 10, 10);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+
+    CHECK(atlas.fits(*a, 10, 9));   // same height class
+    CHECK_FALSE(atlas.fits(*a, 11, 10)); // b is in the way
+    CHECK(atlas.fits(*b, 30, 10));  // coalesced with the free space to its right
+    CHECK_FALSE(atlas.fits(*a, 4, 4));   // different height class on a shelf still in use
+    CHECK_FALSE(atlas.fits(*a, 10, 20)); // higher than the shelf
+
+    // Once b is gone, releasing a empties the shelf, which can then hold any lower height class.
+    atlas.release(*b);
+    CHECK(atlas.fits(*a, 4, 4));
+    CHECK(atlas.fits(*a, 64, 12));
+    CHECK_FALSE(atlas.fits(*a, 10, 13));
+}
+
+TEST_CASE("Atlas.rows.fits", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Rows);
+
+    auto const a = insert(atlas, 10, 12);
+    REQUIRE(a != nullptr);
+
+    CHECK(atlas.fits(*a, 10, 12));
+    CHECK(atlas.fits(*a, 8, 4));
+    CHECK_FALSE(atlas.fits(*a, 11, 12));
+    CHECK_FALSE(atlas.fits(*a, 10, 13));
+}
+
+TEST_CASE("Atlas.shelves.no_overlap", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 2, 64, 64, Format::Red, listener, "test", Packing::Shelves);
+
+    // Deterministic pseudo random sequence of inserts and releases.
+    uint32_t seed = 42;
+    auto const random = [&](unsigned _max) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 16) % _max;
+    };
+
+    std::vector<TextureInfo const*> textures;
+    for (int round = 0; round < 2000; ++round)
+    {
+        if (!textures.empty() && random(3) == 0)
+        {
+            auto const i = textures.begin() + random(static_cast<unsigned>(textures.size()));
+            atlas.release(**i);
+            textures.erase(i);
+        }
+        else if (auto const info = insert(atlas, 1 + random(24), 1 + random(24)); info != nullptr)
+            textures.push_back(info);
+
+        size_t area = 0;
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            TextureInfo const& a = *textures[i];
+            INFO(fmt::format("round {}: texture {} at {}x{}+{}+{}@{}", round, i, a.width, a.height, a.x, a.y, a.z));
+            REQUIRE(a.x + a.width <= 64);
+            REQUIRE(a.y + a.height <= 64);
+            REQUIRE(a.z < 2);
+            for (size_t k = i + 1; k < textures.size(); ++k)
+                if (overlapping(a, *textures[k]))
+                    FAIL(fmt::format("overlaps texture {}", k));
+            area += size_t{a.width} * a.height;
+        }
+        REQUIRE(atlas.usedArea() == area);
+    }
+}
+
+TEST_CASE("Atlas.rows.best_fit", "[atlas]")
+{
+    NoopListener listener;
+    auto atlas = TextureAtlasAllocator(0, 1, 1, 64, 64, Format::Red, listener, "test", Packing::Rows);
+
+    auto const a = insert(atlas, 12, 8);
+    auto const b = insert(atlas, 16, 8);
+    auto const c = insert(atlas, 8, 8);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+    auto const ax = a->x, ay = a->y;
+    auto const bx = b->x, by = b->y;
+    auto const cx = c->x, cy = c->y;
+    atlas.release(*b);
+    atlas.release(*a);
+    atlas.release(*c);
+
+    // The smallest released slot that can hold the texture is reused.
+    auto const d = insert(atlas, 10, 8);
+    REQUIRE(d != nullptr);
+    CHECK(d->x == ax);
+    CHECK(d->y == ay);
+
+    auto const e = insert(atlas, 8, 8);
+    REQUIRE(e != nullptr);
+    CHECK(e->x == cx);
+    CHECK(e->y == cy);
+
+    auto const f = insert(atlas, 8, 4);
+    REQUIRE(f != nullptr);
+    CHECK(f->x == bx);
+    CHECK(f->y == by);
+}
+
+TEST_CASE("MetadataTextureAtlas.evict_least_recently_used", "[atlas]")
+{
+    NoopListener listener;
+    auto allocator = TextureAtlasAllocator(0, 1, 1, 32, 16, Format::Red, listener, "test", Packing::Rows);
+    auto atlas = MetadataTextureAtlas<int>(allocator);
+    auto const insert = [&](int _key) { return atlas.insert(_key, 8, 8, 8, 8, Buffer(8 * 8)).has_value(); };
+
+    // Fill up the atlas in the first frame. Nothing can be evicted while all textures are in use.
+    int capacity = 0;
+    while (insert(capacity))
+        ++capacity;
+    REQUIRE(capacity > 2);
+    CHECK(atlas.size() == static_cast<size_t>(capacity));
+    CHECK(atlas.evictions() == 0);
+
+    // In the next frame, texture 0 is used again, so texture 1 is the least recently used one.
+    allocator.nextFrame();
+    CHECK(atlas.get(0).has_value());
+
+    REQUIRE(insert(100));
+    CHECK_FALSE(atlas.contains(1));
+    CHECK(atlas.contains(0));
+    CHECK(atlas.contains(2));
+    CHECK(atlas.evictions() == 1);
+
+    REQUIRE(insert(101));
+    CHECK_FALSE(atlas.contains(2));
+    CHECK(atlas.evictions() == 2);
+
+    // Evict the remaining textures of the previous frame.
+    for (int key = 3; key < capacity; ++key)
+    {
+        REQUIRE(insert(100 + key - 1));
+        CHECK_FALSE(atlas.contains(key));
+    }
+    CHECK(atlas.evictions() == static_cast<size_t>(capacity - 1));
+
+    // All remaining textures have been used in the current frame and must survive.
+    CHECK_FALSE(insert(200));
+    CHECK(atlas.evictions() == static_cast<size_t>(capacity - 1));
+    CHECK(atlas.size() == static_cast<size_t>(capacity));
+    CHECK(atlas.contains(0));
+    for (int key = 100; key < 100 + capacity - 1; ++key)
+        CHECK(atlas.contains(key));
+
+    // Once the frame is over, they can be evicted again.
+    allocator.nextFrame();
+    REQUIRE(insert(200));
+    CHECK_FALSE(atlas.contains(0));
+    CHECK(atlas.evictions() == static_cast<size_t>(capacity));
+}
+
+TEST_CASE("MetadataTextureAtlas.evict_fitting", "[atlas]")
+{
+    NoopListener listener;
+    auto allocator = TextureAtlasAllocator(0, 1, 1, 32, 8, Format::Red, listener, "test", Packing::Rows);
+    auto atlas = MetadataTextureAtlas<int>(allocator);
+
+    REQUIRE(atlas.insert(1, 8, 8, 8, 8, Buffer(8 * 8)).has_value());
+    REQUIRE(atlas.insert(2, 16, 8, 16, 8, Buffer(16 * 8)).has_value());
+    REQUIRE_FALSE(atlas.insert(3, 16, 8, 16, 8, Buffer(16 * 8)).has_value());
+
+    // The least recently used texture is too small, so the next one is evicted instead.
+    allocator.nextFrame();
+    REQUIRE(atlas.insert(3, 16, 8, 16, 8, Buffer(16 * 8)).has_value());
+    CHECK(atlas.contains(1));
+    CHECK_FALSE(atlas.contains(2));
+    CHECK(atlas.evictions() == 1);
+}
@@ -254,14 +254,15 @@ void DecorationRenderer::rebuild()
 }
 
 void DecorationRenderer::renderCell(Coordinate const& _pos,
-                                    Cell const& _cell)
+                                    Cell const& _cell,
+                                    std::optional<HyperlinkState> _hyperlink)
 {
-    if (_cell.hyperlink())
+    if (_hyperlink)
     {
-        auto const& color = _cell.hyperlink()->state == HyperlinkState::Hover
+        auto const& color = *_hyperlink == HyperlinkState::Hover
                             ? colorProfile_.hyperlinkDecoration.hover
                             : colorProfile_.hyperlinkDecoration.normal;
-        auto const decoration = _cell.hyperlink()->state == HyperlinkState::Hover
+        auto const decoration = *_hyperlink == HyperlinkState::Hover
                             ? hyperlinkHover_
                             : hyperlinkNormal_;
         renderDecoration(decoration, _pos, 1, color);
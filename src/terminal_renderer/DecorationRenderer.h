@@ -74,7 +74,7 @@ class DecorationRenderer {
         hyperlinkHover_ = _hover;
     }
 
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
+    void renderCell(Coordinate const& _pos, Cell const& _cell, std::optional<HyperlinkState> _hyperlink);
 
     void renderDecoration(Decorator _decoration,
                           Coordinate const& _pos,
@@ -16,10 +16,46 @@
 #include <terminal_renderer/Atlas.h>
 #include <terminal/Size.h>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace terminal::renderer {
 
+/// A single cell of the page, as rendered by RenderTarget::renderGrid().
+///
+/// Colors are packed as 0xAABBGGRR and pairs as (first | second << 16).
+/// Glyph coordinates refer to the monochrome or the LCD atlas, in pixels.
+struct GridCell {
+    enum Flags : uint32_t {
+        Glyph = 0x01,       //!< The cell has a glyph, as described by the glyph* members.
+        LcdGlyph = 0x02,    //!< The glyph is stored in the LCD atlas rather than the monochrome one.
+        Underline = 0x04,   //!< The cell is underlined in decorationColor.
+    };
+
+    uint32_t background = 0;
+    uint32_t foreground = 0;
+    uint32_t decorationColor = 0;
+    uint32_t flags = 0;
+    uint32_t glyphPosition = 0;     //!< x and y of the glyph's bitmap in the atlas.
+    uint32_t glyphLayer = 0;        //!< z of the glyph's bitmap in the atlas.
+    uint32_t glyphSize = 0;         //!< width and height of the glyph's bitmap.
+    uint32_t glyphOffset = 0;       //!< signed offset of the glyph's bitmap relative to the cell's bottom left.
+};
+static_assert(sizeof(GridCell) == 32, "GridCell is uploaded as two RGBA32UI texels.");
+
+/// Geometry of the page rendered by RenderTarget::renderGrid().
+struct GridLayout {
+    int x = 0;                      //!< left of the page, in pixels
+    int y = 0;                      //!< bottom of the page, in pixels
+    int columns = 0;
+    int rows = 0;
+    int cellWidth = 0;
+    int cellHeight = 0;
+    int underlinePosition = 0;      //!< center of the underline, relative to the cell's bottom
+    int underlineThickness = 0;
+};
+
 /**
  * Terminal render target interface.
  *
@@ -39,9 +75,42 @@ class RenderTarget
 
     virtual atlas::CommandListener& textureScheduler() = 0;
 
+    /// Changes the video memory (in bytes) each texture atlas may use.
+    ///
+    /// @retval true  the atlases have been recreated, discarding all of their textures.
+    /// @retval false the atlases are left untouched, as their size would not change.
+    virtual bool setAtlasMemoryBudget(size_t _bytes) = 0;
+
     virtual void renderRectangle(unsigned _x, unsigned _y, unsigned _width, unsigned _height,
                                  float _r, float _g, float _b, float _a) = 0;
 
+    /// Renders the whole page in a single pass, from the cell data in @p _cells
+    /// (in row-major order, top row first) that is kept by the render target from frame to frame.
+    ///
+    /// Only the rows flagged in @p _damagedRows are updated, unless the number of
+    /// columns or rows changed. Everything else rendered in the same frame is drawn on top.
+    virtual void renderGrid(GridLayout const& _layout,
+                            std::vector<GridCell> const& _cells,
+                            std::vector<bool> const& _damagedRows) = 0;
+
+    /// @returns whether or not the contents of the previous frame are still present.
+    ///
+    /// If so, the next frame is rendered on top of them, and only the areas that
+    /// changed need to be rendered again, after having been scrolled into place
+    /// via scrollArea() or cleared via clearArea().
+    /// Otherwise the next frame starts with a cleared surface.
+    virtual bool frameRetained() = 0;
+
+    /// Discards the contents of the previous frame, forcing the next frame to be rendered in full.
+    virtual void invalidateFrame() = 0;
+
+    /// Moves the previous frame's contents of the given area by @p _offset pixels upwards
+    /// (or downwards, if negative).
+    virtual void scrollArea(int _x, int _y, int _width, int _height, int _offset) = 0;
+
+    /// Clears the given area of the previous frame's contents to the background color.
+    virtual void clearArea(int _x, int _y, int _width, int _height) = 0;
+
     virtual void execute() = 0;
 
     virtual void clearCache() = 0;
@@ -17,16 +17,21 @@
 #include <text_shaper/open_shaper.h>
 
 #include <crispy/debuglog.h>
+#include <crispy/indexed.h>
+#include <crispy/range.h>
 
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <memory>
 
 using std::array;
+using std::get;
 using std::scoped_lock;
 using std::chrono::steady_clock;
 using std::make_unique;
 using std::move;
+using std::next;
 using std::optional;
 using std::tuple;
 using std::unique_ptr;
@@ -136,15 +141,28 @@ void Renderer::executeImageDiscards()
 {
     auto _l = scoped_lock{imageDiscardLock_};
 
+    if (discardImageQueue_.empty())
+        return;
+
     for (auto const& imageId : discardImageQueue_)
         imageRenderer_.discardImage(imageId);
 
     discardImageQueue_.clear();
+    invalidateFrame();
+}
+
+void Renderer::invalidateFrame()
+{
+    renderTarget_->invalidateFrame();
+
+    // The grid's colors and glyph locations may have changed, too.
+    gridCells_.clear();
 }
 
 void Renderer::clearCache()
 {
     renderTarget_->clearCache();
+    invalidateFrame();
 
     // TODO(?): below functions are actually doing the same again and again and again. delete them (and their functions for that)
     // either that, or only the render target is allowed to clear the actual atlas caches.
@@ -179,6 +197,33 @@ void Renderer::updateFontMetrics()
     decorationRenderer_.clearCache();
 
     clearCache();
+
+    textRenderer_.prewarm(prewarmRanges_);
+}
+
+void Renderer::setGridRendering(bool _enabled)
+{
+    gridRendering_ = _enabled;
+    invalidateFrame();
+}
+
+void Renderer::setAtlasMemoryBudget(size_t _bytes)
+{
+    if (renderTarget_->setAtlasMemoryBudget(_bytes))
+    {
+        clearCache();
+        textRenderer_.prewarm(prewarmRanges_);
+    }
+}
+
+void Renderer::setPrewarmRanges(std::vector<CodepointRange> _ranges)
+{
+    // Reloading the configuration passes the same ranges again, whose glyphs are already pre-warmed.
+    if (_ranges == prewarmRanges_)
+        return;
+
+    prewarmRanges_ = move(_ranges);
+    textRenderer_.prewarm(prewarmRanges_);
 }
 
 void Renderer::setRenderSize(int _width, int _height)
@@ -189,6 +234,7 @@ void Renderer::setRenderSize(int _width, int _height)
 void Renderer::setBackgroundOpacity(terminal::Opacity _opacity)
 {
     backgroundOpacity_ = _opacity;
+    invalidateFrame();
 }
 
 void Renderer::setColorProfile(terminal::ColorProfile const& _colors)
@@ -197,6 +243,7 @@ void Renderer::setColorProfile(terminal::ColorProfile const& _colors)
     backgroundRenderer_.setDefaultColor(_colors.defaultBackground);
     decorationRenderer_.setColorProfile(_colors);
     cursorRenderer_.setColor(RGBAColor(colorProfile_.cursor));
+    invalidateFrame();
 }
 
 uint64_t Renderer::render(Terminal& _terminal,
@@ -208,6 +255,10 @@ uint64_t Renderer::render(Terminal& _terminal,
 
     executeImageDiscards();
 
+    // Rows showing glyphs that have been left blank so far are not necessarily damaged.
+    if (textRenderer_.collectRasterizedGlyphs())
+        invalidateFrame();
+
     uint64_t const changes = renderInternalNoFlush(_terminal, _now, _currentMousePosition, _pressure);
 
     backgroundRenderer_.renderPendingCells();
@@ -226,75 +277,122 @@ uint64_t Renderer::renderInternalNoFlush(Terminal& _terminal,
                                          terminal::Coordinate const& _currentMousePosition,
                                          bool _pressure)
 {
-    auto const pressure = _pressure && _terminal.screen().isPrimaryScreen();
-    textRenderer_.setPressure(pressure);
-
-    auto _l = scoped_lock{_terminal};
-    auto const reverseVideo = _terminal.screen().isModeEnabled(terminal::DECMode::ReverseVideo);
-    auto const baseLine = _terminal.viewport().absoluteScrollOffset().value_or(_terminal.screen().historyLineCount());
+    // Only the snapshot is taken while holding the screen lock,
+    // everything below is done without blocking the terminal.
+    _terminal.snapshot(snapshot_, _now, _currentMousePosition, _pressure);
 
-    renderCursor(_terminal);
+    textRenderer_.setPressure(snapshot_.pressure);
 
-    auto const renderHyperlinks = !pressure && _terminal.screen().contains(_currentMousePosition);
-
-    auto const currentMousePositionRel = Coordinate{
-        _currentMousePosition.row - _terminal.viewport().relativeScrollOffset(),
-        _currentMousePosition.column
-    };
-
-    if (renderHyperlinks)
+    // Reverse video also swaps the color the page's margins are cleared to, which are never redrawn otherwise.
+    if (snapshot_.reverseVideo != lastReverseVideo_)
     {
-        auto& cellAtMouse = _terminal.screen().at(currentMousePositionRel);
-        if (cellAtMouse.hyperlink())
-            cellAtMouse.hyperlink()->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
+        invalidateFrame();
+        lastReverseVideo_ = snapshot_.reverseVideo;
     }
 
-    auto const changes = _terminal.preRender(_now);
+    if (snapshot_.cursor.has_value())
+        renderCursor(*snapshot_.cursor);
 
-    _terminal.screen().render(
-        [&](Coordinate const& _pos, Cell const& _cell) {
-            auto const absolutePos = Coordinate{baseLine + (_pos.row - 1), _pos.column};
-            auto const selected = _terminal.isSelectedAbsolute(absolutePos);
-            renderCell(_pos, _cell, reverseVideo, selected);
-        },
-        _terminal.viewport().absoluteScrollOffset()
-    );
+    if (gridRendering_)
+        renderGrid();
+    else if (renderTarget_->frameRetained())
+        renderDamagedRows();
+    else
+        for (RenderCell const& cell : snapshot_.cells)
+            renderCell(cell, snapshot_.reverseVideo);
+
+    if (snapshot_.cursor.has_value())
+        lastCursorRow_ = snapshot_.cursor->position.row;
+    else
+        lastCursorRow_.reset();
 
-    if (renderHyperlinks)
+    return snapshot_.changes;
+}
+
+int Renderer::scrollOffset()
+{
+    auto const pageHeight = static_cast<int>(snapshot_.lines.size());
+
+    // Count how many rows moved by each distance (indexed by distance + pageHeight),
+    // and how many did not move at all.
+    auto& distances = scrollDistances_;
+    distances.assign(static_cast<size_t>(2 * pageHeight + 1), 0);
+    auto unchangedRows = 0;
+    for (auto const && [row, line] : crispy::indexed(snapshot_.lines, 1))
     {
-        auto& cellAtMouse = _terminal.screen().at(currentMousePositionRel);
-        if (cellAtMouse.hyperlink())
-            cellAtMouse.hyperlink()->state = HyperlinkState::Inactive;
+        if (line.shiftedFrom.has_value())
+            distances[static_cast<size_t>(*line.shiftedFrom - static_cast<int>(row) + pageHeight)]++;
+        else if (!line.damaged)
+            unchangedRows++;
     }
 
-    return changes;
+    auto const mostCommon = std::max_element(distances.begin(), distances.end());
+    if (mostCommon == distances.end() || *mostCommon <= unchangedRows)
+        return 0;
+
+    return static_cast<int>(std::distance(distances.begin(), mostCommon)) - pageHeight;
 }
 
-void Renderer::renderCursor(Terminal const& _terminal)
+void Renderer::renderDamagedRows()
 {
-    bool const shouldDisplayCursor = _terminal.screen().cursor().visible
-        && (_terminal.cursorDisplay() == CursorDisplay::Steady || _terminal.cursorBlinkActive());
+    auto const pageHeight = static_cast<int>(snapshot_.lines.size());
+    if (pageHeight == 0)
+        return;
 
-    // TODO: check if CursorStyle has changed, and update render context accordingly.
-    if (shouldDisplayCursor && _terminal.viewport().isLineVisible(_terminal.screen().cursor().position.row))
+    auto const pageWidth = static_cast<int>(snapshot_.cells.size()) / pageHeight;
+
+    // Moving the previous frame by the distance most rows moved by (e.g. because the page scrolled)
+    // leaves only the rows that moved differently (e.g. newly exposed ones) to be rendered.
+    auto const offset = scrollOffset();
+
+    damagedRows_.resize(static_cast<size_t>(pageHeight));
+    for (auto const && [row, line] : crispy::indexed(snapshot_.lines, 1))
+        damagedRows_[row - 1] = offset != 0 ? line.shiftedFrom != static_cast<int>(row) + offset
+                                            : line.damaged;
+
+    // The cursor is rendered on top of the cells, so the rows it was and is on must be rendered again.
+    auto const markDamaged = [&](int _row) {
+        if (1 <= _row && _row <= pageHeight)
+            damagedRows_[static_cast<size_t>(_row - 1)] = true;
+    };
+    if (lastCursorRow_.has_value())
+        markDamaged(*lastCursorRow_ - offset);
+    if (snapshot_.cursor.has_value())
+        markDamaged(snapshot_.cursor->position.row);
+
+    auto const rowWidth = pageWidth * gridMetrics_.cellSize.width;
+    auto const rowHeight = gridMetrics_.cellSize.height;
+
+    if (offset != 0)
     {
-        Cell const& cursorCell = _terminal.screen().at(_terminal.screen().cursor().position);
+        auto const origin = gridMetrics_.map(1, pageHeight);
+        renderTarget_->scrollArea(origin.x, origin.y, rowWidth, pageHeight * rowHeight, offset * rowHeight);
+    }
 
-        auto const cursorShape = _terminal.screen().focused() ? _terminal.cursorShape()
-                                                              : CursorShape::Rectangle;
+    for (int row = 1; row <= pageHeight; ++row)
+    {
+        if (!damagedRows_[static_cast<size_t>(row - 1)])
+            continue;
 
-        cursorRenderer_.setShape(cursorShape);
+        auto const origin = gridMetrics_.map(1, row);
+        renderTarget_->clearArea(origin.x, origin.y, rowWidth, rowHeight);
 
-        cursorRenderer_.render(
-            gridMetrics_.map(
-                _terminal.screen().cursor().position.column,
-                _terminal.screen().cursor().position.row + _terminal.viewport().relativeScrollOffset()
-            ),
-            cursorCell.width()
-        );
+        auto const cells = next(snapshot_.cells.begin(), (row - 1) * pageWidth);
+        for (RenderCell const& cell : crispy::range(cells, next(cells, pageWidth)))
+            renderCell(cell, snapshot_.reverseVideo);
     }
 }
 
+void Renderer::renderCursor(RenderCursor const& _cursor)
+{
+    // TODO: check if CursorStyle has changed, and update render context accordingly.
+    cursorRenderer_.setShape(_cursor.shape);
+    cursorRenderer_.render(
+        gridMetrics_.map(_cursor.position.column, _cursor.position.row),
+        _cursor.width
+    );
+}
+
 tuple<RGBColor, RGBColor> makeColors(ColorProfile const& _colorProfile, Cell const& _cell, bool _reverseVideo, bool _selected)
 {
     auto const [fg, bg] = _cell.attributes().makeColors(_colorProfile, _reverseVideo);
@@ -306,15 +404,172 @@ tuple<RGBColor, RGBColor> makeColors(ColorProfile const& _colorProfile, Cell con
     return tuple{a, b};
 }
 
-void Renderer::renderCell(Coordinate const& _pos, Cell const& _cell, bool _reverseVideo, bool _selected)
+void Renderer::renderCell(RenderCell const& _cell, bool _reverseVideo)
+{
+    auto const& pos = _cell.position;
+    auto const [fg, bg] = makeColors(colorProfile_, _cell.cell, _reverseVideo, _cell.selected);
+
+    backgroundRenderer_.renderCell(pos, bg);
+    decorationRenderer_.renderCell(pos, _cell.cell, _cell.hyperlink);
+    textRenderer_.schedule(pos, _cell.cell, fg);
+    if (optional<ImageFragment> const& fragment = _cell.cell.imageFragment(); fragment.has_value())
+        imageRenderer_.renderImage(gridMetrics_.map(pos), fragment.value());
+}
+
+namespace // {{{ grid helper
+{
+    enum GridFallback : uint8_t {
+        FallbackText = 0x01,
+        FallbackDecoration = 0x02,
+        FallbackImage = 0x04,
+    };
+
+    constexpr uint32_t packPair(int _first, int _second) noexcept
+    {
+        return static_cast<uint32_t>(static_cast<uint16_t>(_first))
+            | (static_cast<uint32_t>(static_cast<uint16_t>(_second)) << 16);
+    }
+
+    constexpr uint32_t packColor(RGBColor const& _color, uint8_t _alpha = 0xFF) noexcept
+    {
+        return static_cast<uint32_t>(_color.red)
+            | (static_cast<uint32_t>(_color.green) << 8)
+            | (static_cast<uint32_t>(_color.blue) << 16)
+            | (static_cast<uint32_t>(_alpha) << 24);
+    }
+} // }}}
+
+void Renderer::updateGridCells(int _pageWidth)
+{
+    // Cells of the default background color share the default background's translucency.
+    auto const defaultBackground = snapshot_.reverseVideo ? colorProfile_.defaultForeground
+                                                          : colorProfile_.defaultBackground;
+
+    unsigned constexpr OtherDecorations = CharacterStyleMask::DoublyUnderlined
+                                    | CharacterStyleMask::CurlyUnderlined
+                                    | CharacterStyleMask::DottedUnderline
+                                    | CharacterStyleMask::DashedUnderline
+                                    | CharacterStyleMask::Overline
+                                    | CharacterStyleMask::CrossedOut
+                                    | CharacterStyleMask::Framed
+                                    | CharacterStyleMask::Encircled;
+
+    for (size_t i = 0; i < snapshot_.cells.size(); ++i)
+    {
+        if (!damagedRows_[i / static_cast<size_t>(_pageWidth)])
+            continue;
+
+        RenderCell const& cell = snapshot_.cells[i];
+        auto const [fg, bg] = makeColors(colorProfile_, cell.cell, snapshot_.reverseVideo, cell.selected);
+        auto const& styles = cell.cell.attributes().styles;
+
+        GridCell& target = gridCells_[i];
+        uint8_t& fallback = gridFallbacks_[i];
+        target = GridCell{};
+        target.background = packColor(bg, bg == defaultBackground ? static_cast<uint8_t>(backgroundOpacity_) : 0xFF);
+        target.foreground = packColor(fg);
+        fallback = 0;
+
+        if (optional<TextRenderer::CellGlyph> const glyph = textRenderer_.cellGlyph(cell.cell); !glyph.has_value())
+            fallback |= FallbackText;
+        else if (glyph->texture)
+        {
+            atlas::TextureInfo const& texture = *glyph->texture;
+            target.flags |= GridCell::Glyph;
+            if (texture.user == 2)
+                target.flags |= GridCell::LcdGlyph;
+            target.glyphPosition = packPair(static_cast<int>(texture.x), static_cast<int>(texture.y));
+            target.glyphLayer = texture.z;
+            target.glyphSize = packPair(static_cast<int>(texture.width), static_cast<int>(texture.height));
+            target.glyphOffset = packPair(glyph->left, glyph->bottom);
+        }
+
+        if (cell.hyperlink.has_value() || (styles & OtherDecorations))
+            fallback |= FallbackDecoration;
+        else if (styles & CharacterStyleMask::Underline)
+        {
+            target.flags |= GridCell::Underline;
+            target.decorationColor = packColor(cell.cell.attributes().getUnderlineColor(colorProfile_));
+        }
+
+        if (cell.cell.imageFragment().has_value())
+            fallback |= FallbackImage;
+    }
+}
+
+void Renderer::renderGrid()
 {
-    auto const [fg, bg] = makeColors(colorProfile_, _cell, _reverseVideo, _selected);
+    auto const pageHeight = static_cast<int>(snapshot_.lines.size());
+    if (pageHeight == 0)
+        return;
+
+    auto const pageWidth = static_cast<int>(snapshot_.cells.size()) / pageHeight;
+
+    // Only rows that changed since the previous frame need their cells to be recomputed (and uploaded).
+    // Cells of all other rows may still refer to glyphs that have been evicted from the texture atlases
+    // after they have been computed, e.g. by rendering fallback cells or the cursor, or by uploading
+    // glyphs rasterized in the background, in which case all rows are recomputed.
+    bool const rebuild = gridCells_.size() != snapshot_.cells.size() || textRenderer_.evictions() != lastEvictions_;
+    gridCells_.resize(snapshot_.cells.size());
+    gridFallbacks_.resize(snapshot_.cells.size());
+    damagedRows_.resize(static_cast<size_t>(pageHeight));
+    for (auto const && [row, line] : crispy::indexed(snapshot_.lines))
+        damagedRows_[row] = rebuild || line.damaged;
+
+    // The same applies to glyphs evicted while looking up those of the damaged rows.
+    // Glyphs looked up for this frame are never evicted, so doing so once suffices.
+    auto const evictions = textRenderer_.evictions();
+    updateGridCells(pageWidth);
+    if (textRenderer_.evictions() != evictions && !rebuild)
+    {
+        std::fill(damagedRows_.begin(), damagedRows_.end(), true);
+        updateGridCells(pageWidth);
+    }
+    lastEvictions_ = textRenderer_.evictions();
+
+    renderTarget_->renderGrid(
+        GridLayout{
+            gridMetrics_.pageMargin.left,
+            gridMetrics_.pageMargin.bottom,
+            pageWidth,
+            pageHeight,
+            gridMetrics_.cellSize.width,
+            gridMetrics_.cellSize.height,
+            gridMetrics_.underline.position,
+            gridMetrics_.underline.thickness
+        },
+        gridCells_,
+        damagedRows_
+    );
 
-    backgroundRenderer_.renderCell(_pos, bg);
-    decorationRenderer_.renderCell(_pos, _cell);
-    textRenderer_.schedule(_pos, _cell, fg);
-    if (optional<ImageFragment> const& fragment = _cell.imageFragment(); fragment.has_value())
-        imageRenderer_.renderImage(gridMetrics_.map(_pos), fragment.value());
+    // Render whatever the grid does not cover on top of it, as usual.
+    bool textScheduled = false;
+    for (size_t i = 0; i < snapshot_.cells.size(); ++i)
+    {
+        auto const fallback = gridFallbacks_[i];
+        if (!(fallback & FallbackText) && textScheduled)
+        {
+            // Text runs must not span across cells that are not scheduled.
+            textRenderer_.flushPendingSegments();
+            textRenderer_.finish();
+            textScheduled = false;
+        }
+
+        if (!fallback)
+            continue;
+
+        RenderCell const& cell = snapshot_.cells[i];
+        if (fallback & FallbackText)
+        {
+            auto const fg = get<0>(makeColors(colorProfile_, cell.cell, snapshot_.reverseVideo, cell.selected));
+            textRenderer_.schedule(cell.position, cell.cell, fg);
+            textScheduled = true;
+        }
+        if (fallback & FallbackDecoration)
+            decorationRenderer_.renderCell(cell.position, cell.cell, cell.hyperlink);
+        if (fallback & FallbackImage)
+            imageRenderer_.renderImage(gridMetrics_.map(cell.position), cell.cell.imageFragment().value());
+    }
 }
 
 void Renderer::dumpState(std::ostream& _textOutput) const
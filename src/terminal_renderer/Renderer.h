@@ -28,6 +28,7 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <utility>
 
@@ -70,11 +71,13 @@ class Renderer {
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover)
     {
         decorationRenderer_.setHyperlinkDecoration(_normal, _hover);
+        invalidateFrame();
     }
 
     void setScreenSize(Size const& _screenSize) noexcept
     {
         gridMetrics_.pageSize = _screenSize;
+        invalidateFrame();
     }
 
     void setMargin(int _leftMargin, int _bottomMargin) noexcept
@@ -84,6 +87,32 @@ class Renderer {
         gridMetrics_.pageMargin.bottom = _bottomMargin;
     }
 
+    /// Enables or disables rendering the page via RenderTarget::renderGrid().
+    ///
+    /// In this mode, backgrounds, underlines and the glyphs of cells that can be rendered on their own
+    /// (see TextRenderer::cellGlyph()) are drawn by the render target straight from per-cell data,
+    /// which is only updated for damaged rows. Only the remaining cells (such as complex scripts,
+    /// emoji, images and any other decorations) are rendered as usual, on top.
+    /// As simple cells are shaped on their own, ligatures are not rendered in this mode.
+    void setGridRendering(bool _enabled);
+    bool gridRendering() const noexcept { return gridRendering_; }
+
+    /// Enables or disables rasterizing missing glyphs in the background, see TextRenderer::setAsyncRasterization().
+    void setAsyncRasterization(bool _enabled) { textRenderer_.setAsyncRasterization(_enabled); }
+
+    /// @returns whether or not glyphs are still being rasterized in the background,
+    ///          in which case another frame needs to be rendered once they are done.
+    bool rasterizing() const noexcept { return textRenderer_.rasterizing(); }
+
+    /// Changes the video memory (in bytes) each texture atlas may use, see RenderTarget::setAtlasMemoryBudget().
+    void setAtlasMemoryBudget(size_t _bytes);
+
+    /// Sets the codepoints whose glyphs are rasterized in the background right after fonts have been
+    /// loaded (and right away), so that zooming or switching fonts does not stall the next frames.
+    ///
+    /// @see TextRenderer::prewarm()
+    void setPrewarmRanges(std::vector<CodepointRange> _ranges);
+
     /**
      * Renders the given @p _terminal to the current OpenGL context.
      *
@@ -118,11 +147,27 @@ class Renderer {
                                    terminal::Coordinate const& _currentMousePosition,
                                    bool _pressure);
 
-    void renderCell(Coordinate const& _pos, Cell const& _cell, bool _reverseVideo, bool _selected);
-    void renderCursor(Terminal const& _terminal);
+    /// Renders only the rows of the snapshot that differ from the retained previous frame.
+    void renderDamagedRows();
+
+    /// @returns the number of rows the previous frame should be moved up by (or down, if negative)
+    ///          to match the snapshot with as few rows as possible left to be rendered.
+    int scrollOffset();
+
+    /// Renders the snapshot via RenderTarget::renderGrid(), see setGridRendering().
+    void renderGrid();
+
+    /// Recomputes the GridCells of all rows marked in damagedRows_.
+    void updateGridCells(int _pageWidth);
+
+    void renderCell(RenderCell const& _cell, bool _reverseVideo);
+    void renderCursor(RenderCursor const& _cursor);
 
     void executeImageDiscards();
 
+    /// Forces the next frame to be rendered in full.
+    void invalidateFrame();
+
     std::unique_ptr<text::shaper> textShaper_;
 
     FontDescriptions fontDescriptions_;
@@ -130,6 +175,21 @@ class Renderer {
 
     GridMetrics gridMetrics_;
 
+    /// Reused from frame to frame to avoid reallocating its cell buffer.
+    RenderSnapshot snapshot_;
+
+    std::vector<bool> damagedRows_;             //!< Rows to be rendered on top of the retained frame.
+    std::vector<int> scrollDistances_;          //!< Scratch buffer for scrollOffset().
+    std::optional<int> lastCursorRow_;          //!< Row the cursor has been rendered to in the previous frame.
+    bool lastReverseVideo_ = false;             //!< Whether or not the previous frame has been rendered in reverse video.
+
+    std::vector<CodepointRange> prewarmRanges_; //!< Codepoints to be pre-rendered, see setPrewarmRanges().
+
+    bool gridRendering_ = false;
+    std::vector<GridCell> gridCells_;           //!< Cells of the page, as passed to RenderTarget::renderGrid().
+    std::vector<uint8_t> gridFallbacks_;        //!< Per cell, what needs to be rendered on top of the grid.
+    size_t lastEvictions_ = 0;                  //!< Texture atlas evictions by the time gridCells_ were computed.
+
     ColorProfile colorProfile_;
     Opacity backgroundOpacity_;
 
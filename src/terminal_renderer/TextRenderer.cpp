@@ -37,7 +37,6 @@ using std::move;
 using std::nullopt;
 using std::optional;
 using std::pair;
-using std::u32string;
 using std::u32string_view;
 using std::vector;
 
@@ -45,6 +44,44 @@ namespace terminal::renderer {
 
 namespace {
     auto const TextRendererTag = crispy::debugtag::make("renderer.text", "Logs details about text rendering.");
+
+    /// Tests whether the given codepoint is rendered the same with or without its neighbours,
+    /// i.e. is neither part of a complex script, nor usually subject to emoji presentation.
+    constexpr bool isSimpleCodepoint(char32_t _codepoint) noexcept
+    {
+        return (0x21 <= _codepoint && _codepoint < 0x7F)      // ASCII
+            || (0xA1 <= _codepoint && _codepoint < 0x0300)    // Latin-1 Supplement, Latin Extended, IPA
+            || (0x2500 <= _codepoint && _codepoint < 0x25A0); // Box Drawing, Block Elements
+    }
+
+    /// Maximum number of shaped text runs to be cached.
+    constexpr size_t ShapingCacheCapacity = 16384;
+
+    /// @returns 64-bit FNV-1a hash of the given text run and its style.
+    ///
+    /// The fonts are not part of the hash, as they are determined by the style,
+    /// and the cache is cleared whenever they change.
+    uint64_t hashTextRun(vector<char32_t> const& _codepoints, CharacterStyleMask _styles) noexcept
+    {
+        constexpr uint64_t Basis = 14695981039346656037llu;
+        constexpr uint64_t Prime = 1099511628211llu;
+
+        auto hash = Basis;
+        auto const apply = [&](uint32_t _value) {
+            for (int i = 0; i < 4; ++i)
+            {
+                hash ^= (_value >> (8 * i)) & 0xFF;
+                hash *= Prime;
+            }
+        };
+
+        apply(static_cast<uint32_t>(_codepoints.size()));
+        for (char32_t const codepoint : _codepoints)
+            apply(static_cast<uint32_t>(codepoint));
+        apply(static_cast<uint32_t>(static_cast<unsigned>(_styles)));
+
+        return hash;
+    }
 }
 
 TextRenderer::TextRenderer(atlas::CommandListener& _commandListener,
@@ -58,6 +95,7 @@ TextRenderer::TextRenderer(atlas::CommandListener& _commandListener,
     gridMetrics_{ _gridMetrics },
     fontDescriptions_{ _fontDescriptions },
     fonts_{ _fonts },
+    shapingCache_{ ShapingCacheCapacity },
     textShaper_{ _textShaper },
     commandListener_{ _commandListener },
     monochromeAtlas_{ _monochromeAtlasAllocator },
@@ -72,12 +110,13 @@ void TextRenderer::clearCache()
     colorAtlas_.clear();
     lcdAtlas_.clear();
 
-    cacheKeyStorage_.clear();
-    cache_.clear();
+    shapingCache_.clear();
 
-#if !defined(NDEBUG)
-    cacheHits_.clear();
-#endif
+    // Glyphs still being rasterized in the background are of no use anymore.
+    textShaper_.discard_rasterized();
+    pendingGlyphs_.clear();
+    failedGlyphs_.clear();
+    blankGlyphs_ = 0;
 }
 
 void TextRenderer::updateFontMetrics()
@@ -153,6 +192,43 @@ void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell, RGBColor
     }
 }
 
+optional<TextRenderer::CellGlyph> TextRenderer::cellGlyph(Cell const& _cell)
+{
+    constexpr char32_t SP = 0x20;
+
+    if (_cell.empty() || _cell.codepoint(0) == SP || (_cell.attributes().styles & CharacterStyleMask::Hidden))
+        return CellGlyph{};
+
+    if (_cell.codepointCount() != 1 || _cell.width() != 1 || !isSimpleCodepoint(_cell.codepoint(0)))
+        return nullopt;
+
+    assert(state_ == State::Empty && "Must not be called while text is scheduled.");
+
+    // Shaped on its own, just like under pressure, and thus sharing the same cache entries.
+    reset(Coordinate{}, _cell.attributes().styles, RGBColor{});
+    extend(_cell, 1);
+    text::shape_result const& glyphPositions = cachedGlyphPositions();
+    codepoints_.clear();
+
+    if (glyphPositions.size() != 1 || textShaper_.has_color(glyphPositions.front().glyph.font))
+        return nullopt;
+
+    text::glyph_position const& gpos = glyphPositions.front();
+    optional<DataRef> const dataRef = getTextureInfo(gpos.glyph);
+    if (!dataRef.has_value())
+        return CellGlyph{};
+
+    atlas::TextureInfo const& textureInfo = get<0>(*dataRef).get();
+    GlyphMetrics const& metrics = get<1>(*dataRef).get();
+
+    // Same placement as renderTexture() does for non-colored glyphs, relative to the cell.
+    return CellGlyph{
+        &textureInfo,
+        metrics.bearing.x + gpos.x,
+        gpos.y + gridMetrics_.baseline + metrics.bearing.y - metrics.bitmapSize.y
+    };
+}
+
 void TextRenderer::flushPendingSegments()
 {
     if (codepoints_.empty())
@@ -167,34 +243,55 @@ void TextRenderer::flushPendingSegments()
 
 text::shape_result const& TextRenderer::cachedGlyphPositions()
 {
-    auto const codepoints = u32string_view(codepoints_.data(), codepoints_.size());
-    if (auto const cached = cache_.find(CacheKey{codepoints, characterStyleMask_}); cached != cache_.end())
-    {
-#if !defined(NDEBUG)
-        cacheHits_[cached->first]++;
-#endif
-        return cached->second;
-    }
-
-    cacheKeyStorage_.emplace_back(u32string{codepoints});
-    auto const cacheKeyFromStorage = CacheKey{ cacheKeyStorage_.back(), characterStyleMask_ };
-
-#if !defined(NDEBUG)
-    cacheHits_[cacheKeyFromStorage] = 0;
-#endif
-
-    return cache_[cacheKeyFromStorage] = requestGlyphPositions();
+    return shapingCache_.get_or_emplace(hashTextRun(codepoints_, characterStyleMask_),
+                                        [this](text::shape_result& _result) { requestGlyphPositions(_result); });
 }
 
-text::shape_result TextRenderer::requestGlyphPositions()
+void TextRenderer::requestGlyphPositions(text::shape_result& _result)
 {
-    text::shape_result glyphPositions;
+    _result.clear();
+    if (mapCodepoints(_result))
+        return;
+
     unicode::run_segmenter::range run;
     auto rs = unicode::run_segmenter(codepoints_.data(), codepoints_.size());
     while (rs.consume(out(run)))
-        crispy::copy(shapeRun(run), std::back_inserter(glyphPositions));
+        crispy::copy(shapeRun(run), std::back_inserter(_result));
+}
+
+bool TextRenderer::mapCodepoints(text::shape_result& _result)
+{
+    // Simple codepoints do not interact with their neighbours, unless by the font's ligatures,
+    // which text::shaper::map_codepoint() takes care of.
+    if ((characterStyleMask_ & CharacterStyleMask::Hidden)
+            || !std::all_of(codepoints_.begin(), codepoints_.end(), isSimpleCodepoint))
+        return false;
+
+    auto const font = textFont();
+    for (char32_t const codepoint : codepoints_)
+    {
+        optional<text::glyph_position> const glyph = textShaper_.map_codepoint(font, codepoint);
+        if (!glyph.has_value())
+        {
+            _result.clear();
+            return false;
+        }
+        _result.emplace_back(*glyph);
+    }
+
+    return true;
+}
 
-    return glyphPositions;
+text::font_key TextRenderer::textFont() const noexcept
+{
+    if (characterStyleMask_ & (CharacterStyleMask::Mask::Bold | CharacterStyleMask::Mask::Italic))
+        return fonts_.boldItalic;
+    if (characterStyleMask_ & CharacterStyleMask::Mask::Bold)
+        return fonts_.bold;
+    if (characterStyleMask_ & CharacterStyleMask::Mask::Italic)
+        return fonts_.italic;
+
+    return fonts_.regular;
 }
 
 text::shape_result TextRenderer::shapeRun(unicode::run_segmenter::range const& _run)
@@ -217,18 +314,7 @@ text::shape_result TextRenderer::shapeRun(unicode::run_segmenter::range const& _
 
     bool const isEmojiPresentation = std::get<unicode::PresentationStyle>(_run.properties) == unicode::PresentationStyle::Emoji;
 
-    auto font = [&]() -> text::font_key {
-        if (isEmojiPresentation)
-            return fonts_.emoji;
-        if (characterStyleMask_ & (CharacterStyleMask::Mask::Bold | CharacterStyleMask::Mask::Italic))
-            return fonts_.boldItalic;
-        if (characterStyleMask_ & CharacterStyleMask::Mask::Bold)
-            return fonts_.bold;
-        if (characterStyleMask_ & CharacterStyleMask::Mask::Italic)
-            return fonts_.italic;
-
-        return fonts_.regular;
-    }();
+    auto const font = isEmojiPresentation ? fonts_.emoji : textFont();
 
     // TODO(where to apply cell-advances) auto const advanceX = gridMetrics_.cellSize.width;
     auto const count = static_cast<int>(_run.end - _run.start);
@@ -325,59 +411,170 @@ TextRenderer::TextureAtlas& TextRenderer::atlasForFont(text::font_key _font)
 
 optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key const& _id)
 {
-    auto font = _id.font;
-    auto const colored = textShaper_.has_color(font);
-    TextureAtlas& lookupAtlas = atlasForFont(font);
+    TextureAtlas& lookupAtlas = atlasForFont(_id.font);
     // TODO: what if lookupAtlas != targetAtlas. the lookup should be decoupled
 
     if (optional<DataRef> const dataRef = lookupAtlas.get(_id); dataRef.has_value())
         return dataRef;
 
+    if (failedGlyphs_.count(_id))
+        return nullopt;
+
+    if (auto const pending = pendingGlyphs_.find(_id); pending != pendingGlyphs_.end())
+    {
+        if (asyncRasterization_)
+        {
+            // Left blank until collected, see collectRasterizedGlyphs().
+            if (!pending->second)
+            {
+                pending->second = true;
+                ++blankGlyphs_;
+            }
+            return nullopt;
+        }
+
+        // Pre-warmed (or left blank before asynchronous rasterization got disabled), but needed right away.
+        // The result of the background thread is dropped once collected.
+        if (pending->second)
+            --blankGlyphs_;
+        pendingGlyphs_.erase(pending);
+    }
+    else if (asyncRasterization_ && textShaper_.rasterize_async(_id, fontDescriptions_.renderMode))
+    {
+        pendingGlyphs_.emplace(_id, true);
+        ++blankGlyphs_;
+        return nullopt;
+    }
+
     auto theGlyphOpt = textShaper_.rasterize(_id, fontDescriptions_.renderMode);
     if (!theGlyphOpt.has_value())
+    {
+        failedGlyphs_.insert(_id);
         return nullopt;
+    }
+
+    return uploadGlyph(_id, theGlyphOpt.value());
+}
+
+bool TextRenderer::collectRasterizedGlyphs()
+{
+    if (pendingGlyphs_.empty())
+        return false;
+
+    bool collected = false;
+    textShaper_.collect_rasterized([&](text::glyph_key _id,
+                                       text::render_mode _mode,
+                                       optional<text::rasterized_glyph> _glyph) {
+        // Results of glyphs that have been rasterized synchronously meanwhile are stale.
+        auto const pending = pendingGlyphs_.find(_id);
+        if (pending == pendingGlyphs_.end() || _mode != fontDescriptions_.renderMode)
+            return;
+
+        // Glyphs that failed to rasterize remain blank, so there is nothing to be rendered again.
+        if (pending->second)
+        {
+            collected = collected || _glyph.has_value();
+            --blankGlyphs_;
+        }
+        pendingGlyphs_.erase(pending);
+
+        if (_glyph.has_value())
+            uploadGlyph(_id, _glyph.value());
+        else
+            failedGlyphs_.insert(_id);
+    });
+
+    return collected;
+}
+
+void TextRenderer::prewarm(vector<CodepointRange> const& _ranges)
+{
+    assert(state_ == State::Empty && "Must not be called while text is scheduled.");
+
+    // Rasterizing all of them right away would stall the caller instead.
+    if (!asyncRasterization_)
+        return;
+
+    auto constexpr styles = array{
+        CharacterStyleMask{},
+        CharacterStyleMask{CharacterStyleMask::Bold},
+        CharacterStyleMask{CharacterStyleMask::Italic},
+        CharacterStyleMask{CharacterStyleMask::Bold | CharacterStyleMask::Italic}
+    };
+
+    for (CharacterStyleMask const& style : styles)
+    {
+        reset(Coordinate{}, style, RGBColor{});
+        auto const font = textFont();
+
+        for (CodepointRange const& range : _ranges)
+        {
+            for (char32_t codepoint = range.first; codepoint <= range.last; ++codepoint)
+            {
+                // Yields the same glyph as mapping the codepoint does when it is shown,
+                // whose shaping result is then cached on demand.
+                optional<text::glyph_key> const glyph = textShaper_.find_glyph(font, codepoint);
+                if (!glyph.has_value()
+                        || pendingGlyphs_.count(*glyph)
+                        || failedGlyphs_.count(*glyph)
+                        || atlasForFont(glyph->font).contains(*glyph))
+                    continue;
+
+                if (!textShaper_.rasterize_async(*glyph, fontDescriptions_.renderMode))
+                    return;
+
+                pendingGlyphs_.emplace(*glyph, false);
+            }
+        }
+    }
+}
+
+optional<TextRenderer::DataRef> TextRenderer::uploadGlyph(text::glyph_key const& _id,
+                                                        text::rasterized_glyph& _glyph)
+{
+    auto const colored = textShaper_.has_color(_id.font);
+    TextureAtlas& lookupAtlas = atlasForFont(_id.font);
 
-    text::rasterized_glyph& glyph = theGlyphOpt.value();
     auto const numCells = colored ? 2 : 1; // is this the only case - with colored := Emoji presentation?
     // FIXME: this `2` is a hack of my bad knowledge. FIXME.
     // As I only know of emojis being colored fonts, and those take up 2 cell with units.
 
-    debuglog(TextRendererTag).write("Glyph metrics: {}", glyph);
-    // auto const xMax = glyph.left + glyph.width;
+    debuglog(TextRendererTag).write("Glyph metrics: {}", _glyph);
+    // auto const xMax = _glyph.left + _glyph.width;
     // if (xMax > gridMetrics_.cellSize.width * numCells)
     // {
     //     debuglog(TextRendererTag).write("Glyph width {}+{}={} exceeds cell width {}.",
-    //                                     glyph.left,
-    //                                     glyph.width,
+    //                                     _glyph.left,
+    //                                     _glyph.width,
     //                                     xMax,
     //                                     gridMetrics_.cellSize.width * numCells);
     // }
 
     // {{{ scale bitmap down iff bitmap is emoji and overflowing in diemensions
-    if (glyph.format == text::bitmap_format::rgba)
+    if (_glyph.format == text::bitmap_format::rgba)
     {
         assert(colored && "RGBA should be only used on colored (i.e. emoji) fonts.");
         assert(numCells >= 2);
         auto const cellSize = gridMetrics_.cellSize;
 
         if (numCells > 1 && // XXX for now, only if emoji glyph
-                (glyph.width > cellSize.width * numCells
-              || glyph.height > cellSize.height))
+                (_glyph.width > cellSize.width * numCells
+              || _glyph.height > cellSize.height))
         {
-            auto [scaled, factor] = text::scale(glyph, cellSize.width * numCells, cellSize.height);
+            auto [scaled, factor] = text::scale(_glyph, cellSize.width * numCells, cellSize.height);
 
-            glyph.width = scaled.width;
-            glyph.height = scaled.height; // TODO: there shall be only one with'x'height.
+            _glyph.width = scaled.width;
+            _glyph.height = scaled.height; // TODO: there shall be only one with'x'height.
 
             // center the image in the middle of the cell
-            glyph.top = gridMetrics_.cellSize.height - gridMetrics_.baseline;
-            glyph.left = (gridMetrics_.cellSize.width * numCells - glyph.width) / 2;
+            _glyph.top = gridMetrics_.cellSize.height - gridMetrics_.baseline;
+            _glyph.left = (gridMetrics_.cellSize.width * numCells - _glyph.width) / 2;
 
             // (old way)
-            // glyph.metrics.bearing.x /= factor;
-            // glyph.metrics.bearing.y /= factor;
+            // _glyph.metrics.bearing.x /= factor;
+            // _glyph.metrics.bearing.y /= factor;
 
-            glyph.bitmap = move(scaled.bitmap);
+            _glyph.bitmap = move(scaled.bitmap);
 
             // XXX currently commented out because it's not used.
             // TODO: But it should be used for cutting the image off the right edge with unnecessary
@@ -385,10 +582,10 @@ optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key con
             //
             // int const rightEdge = [&]() {
             //     auto rightEdge = std::numeric_limits<int>::max();
-            //     for (int x = glyph.bitmap.width - 1; x >= 0; --x) {
-            //         for (int y = 0; y < glyph.bitmap.height; ++y)
+            //     for (int x = _glyph.bitmap.width - 1; x >= 0; --x) {
+            //         for (int y = 0; y < _glyph.bitmap.height; ++y)
             //         {
-            //             auto const& pixel = &glyph.bitmap.data.at(y * glyph.bitmap.width * 4 + x * 4);
+            //             auto const& pixel = &_glyph.bitmap.data.at(y * _glyph.bitmap.width * 4 + x * 4);
             //             if (pixel[3] > 20)
             //                 rightEdge = x;
             //         }
@@ -398,18 +595,18 @@ optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key con
             //     return rightEdge;
             // }();
             // if (rightEdge != std::numeric_limits<int>::max())
-            //     debuglog(TextRendererTag).write("right edge found. {} < {}.", rightEdge+1, glyph.bitmap.width);
+            //     debuglog(TextRendererTag).write("right edge found. {} < {}.", rightEdge+1, _glyph.bitmap.width);
         }
     }
     // }}}
 
-    auto const yMax = gridMetrics_.baseline + glyph.top;
-    auto const yMin = yMax - glyph.height;
+    auto const yMax = gridMetrics_.baseline + _glyph.top;
+    auto const yMin = yMax - _glyph.height;
 
     auto const ratio = !colored
                      ? 1.0f
-                     : max(float(gridMetrics_.cellSize.width * numCells) / float(glyph.width),
-                           float(gridMetrics_.cellSize.height) / float(glyph.height));
+                     : max(float(gridMetrics_.cellSize.width * numCells) / float(_glyph.width),
+                           float(gridMetrics_.cellSize.height) / float(_glyph.height));
 
     auto const yOverflow = gridMetrics_.cellSize.height - yMax;
     if (crispy::logging_sink::for_debug().enabled())
@@ -419,13 +616,13 @@ optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key con
                                         ratio,
                                         yOverflow < 0 ? yOverflow : 0,
                                         yMin < 0 ? yMin : 0,
-                                        glyph);
+                                        _glyph);
 
     auto && [userFormat, targetAtlas] = [&]() -> pair<int, TextureAtlas&> { // {{{
         // this format ID is used by the fragment shader to select the right texture atlas
         if (colored)
             return {1, colorAtlas_};
-        switch (glyph.format)
+        switch (_glyph.format)
         {
             case text::bitmap_format::rgba:
                 return {1, colorAtlas_};
@@ -440,34 +637,34 @@ optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key con
     if (yOverflow < 0)
     {
         debuglog(TextRendererTag).write("Cropping {} overflowing bitmap rows.", -yOverflow);
-        glyph.height += yOverflow;
-        glyph.top += yOverflow;
+        _glyph.height += yOverflow;
+        _glyph.top += yOverflow;
     }
 
     if (yMin < 0)
     {
         auto const rowCount = -yMin;
-        auto const pixelCount = rowCount * glyph.width * text::pixel_size(glyph.format);
+        auto const pixelCount = rowCount * _glyph.width * text::pixel_size(_glyph.format);
         debuglog(TextRendererTag).write("Cropping {} underflowing bitmap rows.", rowCount);
-        glyph.height += yMin;
-        auto& data = glyph.bitmap;
+        _glyph.height += yMin;
+        auto& data = _glyph.bitmap;
         data.erase(begin(data), next(begin(data), pixelCount));
     }
 
     assert(&lookupAtlas == &targetAtlas);
 
     GlyphMetrics metrics{};
-    metrics.bitmapSize.x = glyph.width;
-    metrics.bitmapSize.y = glyph.height;
-    metrics.bearing.x = glyph.left;
-    metrics.bearing.y = glyph.top;
+    metrics.bitmapSize.x = _glyph.width;
+    metrics.bitmapSize.y = _glyph.height;
+    metrics.bearing.x = _glyph.left;
+    metrics.bearing.y = _glyph.top;
 
     return targetAtlas.insert(_id,
-                              glyph.width,
-                              glyph.height,
-                              unsigned(ceilf(float(glyph.width) * ratio)),
-                              unsigned(ceilf(float(glyph.height) * ratio)),
-                              move(glyph.bitmap),
+                              _glyph.width,
+                              _glyph.height,
+                              unsigned(ceilf(float(_glyph.width) * ratio)),
+                              unsigned(ceilf(float(_glyph.height) * ratio)),
+                              move(_glyph.bitmap),
                               userFormat,
                               metrics);
 }
@@ -540,27 +737,21 @@ void TextRenderer::renderTexture(crispy::Point const& _pos,
 
 void TextRenderer::debugCache(std::ostream& _textOutput) const
 {
-    std::map<u32string, CacheKey> orderedKeys;
-
-    for (auto && [key, val] : cache_)
-    {
-        (void) val;
-        orderedKeys[u32string(key.text)] = key;
-    }
-
-    _textOutput << fmt::format("TextRenderer: {} cache entries:\n", orderedKeys.size());
-    for (auto && [word, key] : orderedKeys)
-    {
-        auto const vword = u32string_view(word);
-#if !defined(NDEBUG)
-        auto hits = int64_t{};
-        if (auto i = cacheHits_.find(key); i != cacheHits_.end())
-            hits = i->second;
-        _textOutput << fmt::format("{:>5} : {}\n", hits, unicode::convert_to<char>(vword));
-#else
-        _textOutput << fmt::format("  {}\n", unicode::convert_to<char>(vword));
-#endif
-    }
+    _textOutput << fmt::format("TextRenderer: {} glyphs in atlases (monochrome: {}, color: {}, LCD: {}), {} evicted\n",
+                               monochromeAtlas_.size() + colorAtlas_.size() + lcdAtlas_.size(),
+                               monochromeAtlas_.size(), colorAtlas_.size(), lcdAtlas_.size(),
+                               evictions());
+    for (TextureAtlas const* atlas : {&monochromeAtlas_, &colorAtlas_, &lcdAtlas_})
+        _textOutput << fmt::format("  {}: {} layers in use, {:.1f}% occupied\n",
+                                   atlas->allocator().name(),
+                                   atlas->allocator().layersInUse(),
+                                   100.0 * atlas->allocator().occupancy());
+    _textOutput << fmt::format("TextRenderer: {}/{} cached text runs, {} hits, {} misses, {} evicted\n",
+                               shapingCache_.size(),
+                               shapingCache_.capacity(),
+                               shapingCache_.hits(),
+                               shapingCache_.misses(),
+                               shapingCache_.evictions());
 }
 
 } // end namespace
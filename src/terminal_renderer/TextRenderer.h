@@ -21,58 +21,20 @@
 #include <text_shaper/font.h>
 #include <text_shaper/shaper.h>
 
-#include <crispy/FNV.h>
+#include <crispy/clock_cache.h>
 #include <crispy/point.h>
 
 #include <unicode/run_segmenter.h>
 
 #include <functional>
-#include <list>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace terminal::renderer
 {
     using GlyphId = text::glyph_key;
-
-    struct CacheKey {
-        std::u32string_view text;
-        CharacterStyleMask styles;
-
-        bool operator==(CacheKey const& _rhs) const noexcept
-        {
-            return text == _rhs.text && styles == _rhs.styles;
-        }
-
-        bool operator!=(CacheKey const& _rhs) const noexcept
-        {
-            return !(*this == _rhs);
-        }
-
-        bool operator<(CacheKey const& _rhs) const noexcept
-        {
-            if (text < _rhs.text)
-                return true;
-
-            if (static_cast<unsigned>(styles) < static_cast<unsigned>(_rhs.styles))
-                return true;
-
-            return false;
-        }
-    };
-}
-
-namespace std
-{
-    template <>
-    struct hash<terminal::renderer::CacheKey> {
-        size_t operator()(terminal::renderer::CacheKey const& _key) const noexcept
-        {
-            auto fnv = crispy::FNV<char32_t>{};
-            return static_cast<size_t>(fnv(fnv(_key.text.data(), _key.text.size()), static_cast<char32_t>(_key.styles)));
-        }
-    };
 }
 
 namespace terminal::renderer {
@@ -105,6 +67,22 @@ inline bool operator!=(FontDescriptions const& a, FontDescriptions const& b) noe
     return !(a == b);
 }
 
+/// Range of codepoints, both inclusive.
+struct CodepointRange {
+    char32_t first;
+    char32_t last;
+};
+
+constexpr bool operator==(CodepointRange const& a, CodepointRange const& b) noexcept
+{
+    return a.first == b.first && a.last == b.last;
+}
+
+constexpr bool operator!=(CodepointRange const& a, CodepointRange const& b) noexcept
+{
+    return !(a == b);
+}
+
 struct FontKeys {
     text::font_key regular;
     text::font_key bold;
@@ -129,20 +107,76 @@ class TextRenderer {
 
     void setPressure(bool _pressure) noexcept { pressure_ = _pressure; }
 
+    /// Enables or disables rasterizing glyphs that are missing from the texture atlases
+    /// on the text shaper's background threads, see text::shaper::rasterize_async().
+    ///
+    /// Until such a glyph has been collected, it is left blank.
+    void setAsyncRasterization(bool _enabled) noexcept { asyncRasterization_ = _enabled; }
+
+    /// Uploads all glyphs that have been rasterized in the background since the last call.
+    ///
+    /// @returns whether or not any glyph that has been left blank has been collected,
+    ///          in which case the rows showing it need to be rendered again.
+    bool collectRasterizedGlyphs();
+
+    /// @returns whether or not glyphs that have been left blank are still being rasterized in the background.
+    bool rasterizing() const noexcept { return blankGlyphs_ != 0; }
+
+    /// Looks up the glyphs of the given codepoints in regular, bold, italic and bold italic style,
+    /// and rasterizes them in the background, so that they are readily available once shown.
+    ///
+    /// The codepoints are not shaped, their shaping results are cached once they are shown.
+    /// Codepoints that the respective font lacks a glyph for are skipped, as looking through
+    /// all fallback fonts for them would stall the caller.
+    /// Nothing is pre-warmed unless asynchronous rasterization is enabled.
+    ///
+    /// Must not be called while text is scheduled, i.e. before finish().
+    void prewarm(std::vector<CodepointRange> const& _ranges);
+
     void schedule(Coordinate const& _pos, Cell const& _cell, RGBColor const& _color);
     void flushPendingSegments();
     void finish();
 
+    /// Glyph of a single cell that can be rendered on its own, e.g. as part of a GridCell.
+    struct CellGlyph {
+        atlas::TextureInfo const* texture = nullptr;  //!< the glyph's bitmap, or nullptr if there is nothing to draw
+        int left = 0;                                 //!< offset of the bitmap relative to the cell's left
+        int bottom = 0;                               //!< offset of the bitmap relative to the cell's bottom
+    };
+
+    /// Looks up the glyph of the given cell, without scheduling it for rendering.
+    ///
+    /// Must not be called while text is scheduled, i.e. before finish().
+    ///
+    /// @returns the glyph of a cell that does not need to be shaped together with its neighbours,
+    ///          and whose glyph is neither colored nor wider than the cell,
+    ///          or std::nullopt if the cell needs to be scheduled instead.
+    std::optional<CellGlyph> cellGlyph(Cell const& _cell);
+
     void debugCache(std::ostream& _textOutput) const;
     void clearCache();
 
+    /// @return number of glyphs that have been evicted from the texture atlases so far.
+    size_t evictions() const noexcept
+    {
+        return monochromeAtlas_.evictions() + colorAtlas_.evictions() + lcdAtlas_.evictions();
+    }
+
   private:
     void reset(Coordinate const& _pos, CharacterStyleMask const& _styles, RGBColor const& _color);
     void extend(Cell const& _cell, int _column);
     text::shape_result shapeRun(unicode::run_segmenter::range const& _range);
 
+    /// Maps the pending codepoints to their glyphs directly, without text shaping.
+    ///
+    /// @returns whether or not all codepoints could be mapped, see text::shaper::map_codepoint().
+    bool mapCodepoints(text::shape_result& _result);
+
+    /// @returns the font for the current character style (without emoji presentation).
+    text::font_key textFont() const noexcept;
+
     text::shape_result const& cachedGlyphPositions();
-    text::shape_result requestGlyphPositions();
+    void requestGlyphPositions(text::shape_result& _result);
 
     void render(crispy::Point _pos,
                 std::vector<text::glyph_position> const& glyphPositions,
@@ -166,6 +200,9 @@ class TextRenderer {
 
     std::optional<DataRef> getTextureInfo(GlyphId const& _id);
 
+    /// Fits the given rasterized glyph into its cell(s) and inserts it into its texture atlas.
+    std::optional<DataRef> uploadGlyph(GlyphId const& _id, text::rasterized_glyph& _glyph);
+
     void renderTexture(crispy::Point const& _pos,
                        RGBAColor const& _color,
                        atlas::TextureInfo const& _textureInfo,
@@ -195,14 +232,15 @@ class TextRenderer {
     // performance optimizations
     //
     bool pressure_ = false;
+    bool asyncRasterization_ = false;
+    std::unordered_map<text::glyph_key, bool> pendingGlyphs_;  // glyphs being rasterized in the background,
+                                                               // and whether they have been left blank meanwhile
+    size_t blankGlyphs_ = 0;                                   // number of pending glyphs that have been left blank
+    std::unordered_set<text::glyph_key> failedGlyphs_;         // glyphs that could not be rasterized
 
-    // text shaping cache
+    // text shaping cache, keyed by the hash of the codepoints and their style
     //
-    std::list<std::u32string> cacheKeyStorage_;
-    std::unordered_map<CacheKey, text::shape_result> cache_;
-#if !defined(NDEBUG)
-    std::unordered_map<CacheKey, int64_t> cacheHits_;
-#endif
+    crispy::clock_cache<text::shape_result> shapingCache_;
 
     // target surface rendering
     //
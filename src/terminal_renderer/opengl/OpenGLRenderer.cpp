@@ -15,10 +15,15 @@
 #include <terminal_renderer/opengl/ShaderConfig.h>
 #include <terminal_renderer/Atlas.h>
 
-#include <crispy/algorithm.h>
+#include <QtGui/QVector2D>
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cmath>
+#include <cstdlib>
 
+using std::clamp;
 using std::min;
 
 namespace terminal::renderer::opengl {
@@ -62,11 +67,42 @@ namespace // {{{ helper
         mat.ortho(left, right, bottom, top, nearPlane, farPlane);
         return mat;
     }
+
+    /// Per-instance vertex attributes of a single texture to render.
+    ///
+    /// Each instance is drawn as a quad of 6 vertices whose corners are derived from
+    /// gl_VertexID in the vertex shader, so that only this compact record needs
+    /// to be uploaded per texture, rather than all the vertices of its quad.
+    struct TextureInstance {
+        std::array<GLshort, 4> rect;         // target rectangle (x, y, width, height) in pixels
+        std::array<GLushort, 4> textureRect; // normalized atlas rectangle (x, y, width, height)
+        std::array<GLushort, 2> layer;       // atlas layer (z) and texture selector (user)
+        std::array<GLubyte, 4> color;        // normalized RGBA
+    };
+    static_assert(sizeof(TextureInstance) == 24);
+
+    constexpr GLsizei VerticesPerInstance = 6;
+
+    constexpr GLushort normalizedShort(float _value) noexcept
+    {
+        return static_cast<GLushort>(std::clamp(_value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    constexpr GLubyte normalizedByte(float _value) noexcept
+    {
+        return static_cast<GLubyte>(std::clamp(_value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    constexpr std::array<GLubyte, 4> normalizedColor(float _r, float _g, float _b, float _a) noexcept
+    {
+        return {normalizedByte(_r), normalizedByte(_g), normalizedByte(_b), normalizedByte(_a)};
+    }
 } // }}}
 
 constexpr unsigned MaxInstanceCount = 1;
 constexpr unsigned MaxMonochromeTextureSize = 1024;
 constexpr unsigned MaxColorTextureSize = 2048;
+constexpr unsigned GridTextureUnit = 3; // next to the atlases' texture units
 
 struct OpenGLRenderer::TextureScheduler : public atlas::CommandListener
 {
@@ -78,8 +114,7 @@ struct OpenGLRenderer::TextureScheduler : public atlas::CommandListener
     std::vector<CreateAtlas> createAtlases;
     std::vector<UploadTexture> uploadTextures;
     std::vector<RenderTexture> renderTextures;
-    std::vector<GLfloat> buffer;
-    GLsizei vertexCount = 0;
+    std::vector<TextureInstance> instances;
     std::vector<DestroyAtlas> destroyAtlases;
 
     void createAtlas(CreateAtlas const& _atlas) override
@@ -96,43 +131,26 @@ struct OpenGLRenderer::TextureScheduler : public atlas::CommandListener
     {
         renderTextures.emplace_back(_render);
 
-        // Vertices
-        GLfloat const x = _render.x;
-        GLfloat const y = _render.y;
-        GLfloat const z = _render.z;
-      //GLfloat const w = _render.w;
-        GLfloat const r = _render.texture.get().targetWidth;
-        GLfloat const s = _render.texture.get().targetHeight;
-
-        // TexCoords
-        GLfloat const rx = _render.texture.get().relativeX;
-        GLfloat const ry = _render.texture.get().relativeY;
-        GLfloat const w = _render.texture.get().relativeWidth;
-        GLfloat const h = _render.texture.get().relativeHeight;
-        GLfloat const i = _render.texture.get().z;
-        GLfloat const u = _render.texture.get().user;
-
-        // color
-        GLfloat const cr = _render.color[0];
-        GLfloat const cg = _render.color[1];
-        GLfloat const cb = _render.color[2];
-        GLfloat const ca = _render.color[3];
-
-        GLfloat const vertices[6 * 11] = {
-            // first triangle
-        // <X      Y      Z> <X       Y       I  U>  <R   G   B   A>
-            x,     y + s, z,  rx,     ry + h, i, u,  cr, cg, cb, ca, // left top
-            x,     y,     z,  rx,     ry,     i, u,  cr, cg, cb, ca, // left bottom
-            x + r, y,     z,  rx + w, ry,     i, u,  cr, cg, cb, ca, // right bottom
-
-            // second triangle
-            x,     y + s, z,  rx,     ry + h, i, u,  cr, cg, cb, ca, // left top
-            x + r, y,     z,  rx + w, ry,     i, u,  cr, cg, cb, ca, // right bottom
-            x + r, y + s, z,  rx + w, ry + h, i, u,  cr, cg, cb, ca, // right top
-        };
-
-        crispy::copy(vertices, back_inserter(buffer));
-        vertexCount += 6;
+        auto const& texture = _render.texture.get();
+        instances.emplace_back(TextureInstance{
+            {
+                static_cast<GLshort>(_render.x),
+                static_cast<GLshort>(_render.y),
+                static_cast<GLshort>(texture.targetWidth),
+                static_cast<GLshort>(texture.targetHeight)
+            },
+            {
+                normalizedShort(texture.relativeX),
+                normalizedShort(texture.relativeY),
+                normalizedShort(texture.relativeWidth),
+                normalizedShort(texture.relativeHeight)
+            },
+            {
+                static_cast<GLushort>(texture.z),
+                static_cast<GLushort>(texture.user)
+            },
+            normalizedColor(_render.color[0], _render.color[1], _render.color[2], _render.color[3])
+        });
     }
 
     void destroyAtlas(DestroyAtlas const& _atlas) override
@@ -154,17 +172,18 @@ struct OpenGLRenderer::TextureScheduler : public atlas::CommandListener
         uploadTextures.clear();
         renderTextures.clear();
         destroyAtlases.clear();
-        buffer.clear();
-        vertexCount = 0;
+        instances.clear();
     }
 };
 
 OpenGLRenderer::OpenGLRenderer(ShaderConfig const& _textShaderConfig,
                                ShaderConfig const& _rectShaderConfig,
+                               ShaderConfig const& _gridShaderConfig,
                                int _width,
                                int _height,
                                int _leftMargin,
-                               int _bottomMargin) :
+                               int _bottomMargin,
+                               size_t _atlasMemoryBudget) :
     projectionMatrix_{ },
     leftMargin_{ _leftMargin },
     bottomMargin_{ _bottomMargin },
@@ -175,36 +194,44 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig const& _textShaderConfig,
     monochromeAtlasAllocator_{
         0,
         MaxInstanceCount,
-        maxTextureSize() / maxTextureDepth(),
+        atlasDepth(_atlasMemoryBudget, min(MaxMonochromeTextureSize, maxTextureSize()), atlas::Format::Red),
         min(MaxMonochromeTextureSize, maxTextureSize()),
         min(MaxMonochromeTextureSize, maxTextureSize()),
         atlas::Format::Red,
         *textureScheduler_,
-        "monochromeAtlas"
+        "monochromeAtlas",
+        atlas::Packing::Shelves
     },
     coloredAtlasAllocator_{
         1,
         MaxInstanceCount,
-        maxTextureSize() / maxTextureDepth(),
+        atlasDepth(_atlasMemoryBudget, min(MaxColorTextureSize, maxTextureSize()), atlas::Format::RGBA),
         min(MaxColorTextureSize, maxTextureSize()),
         min(MaxColorTextureSize, maxTextureSize()),
         atlas::Format::RGBA,
         *textureScheduler_,
-        "colorAtlas"
+        "colorAtlas",
+        atlas::Packing::Shelves
     },
     lcdAtlasAllocator_{
         2,
         MaxInstanceCount,
-        maxTextureSize() / maxTextureDepth(),
+        atlasDepth(_atlasMemoryBudget, min(MaxColorTextureSize, maxTextureSize()), atlas::Format::RGB),
         min(MaxColorTextureSize, maxTextureSize()),
         min(MaxColorTextureSize, maxTextureSize()),
         atlas::Format::RGB,
         *textureScheduler_,
-        "lcdAtlas"
+        "lcdAtlas",
+        atlas::Packing::Shelves
     },
     // rect
     rectShader_{ createShader(_rectShaderConfig) },
-    rectProjectionLocation_{ rectShader_->uniformLocation("u_projection") }
+    rectProjectionLocation_{ rectShader_->uniformLocation("u_projection") },
+    // streaming vertex buffers
+    rectBuffer_{ *this },
+    textureBuffer_{ *this },
+    // grid
+    gridShader_{ createShader(_gridShaderConfig) }
 {
     initialize();
 
@@ -226,6 +253,7 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig const& _textShaderConfig,
 
     initializeRectRendering();
     initializeTextureRendering();
+    initializeGridRendering();
 }
 
 void OpenGLRenderer::setRenderSize(int _width, int _height)
@@ -234,12 +262,16 @@ void OpenGLRenderer::setRenderSize(int _width, int _height)
         0.0f, float(_width),      // left, right
         0.0f, float(_height)      // bottom, top
     );
+    renderWidth_ = _width;
+    renderHeight_ = _height;
+    invalidateFrame();
 }
 
 void OpenGLRenderer::setMargin(int _left, int _bottom) noexcept
 {
     leftMargin_ = _left;
     bottomMargin_ = _bottom;
+    invalidateFrame();
 }
 
 atlas::TextureAtlasAllocator& OpenGLRenderer::monochromeAtlasAllocator() noexcept
@@ -262,26 +294,35 @@ atlas::CommandListener& OpenGLRenderer::textureScheduler()
     return *textureScheduler_;
 }
 
+bool OpenGLRenderer::setAtlasMemoryBudget(size_t _bytes)
+{
+    bool changed = false;
+    for (atlas::TextureAtlasAllocator* allocator : {&monochromeAtlasAllocator_,
+                                                    &coloredAtlasAllocator_,
+                                                    &lcdAtlasAllocator_})
+    {
+        auto const depth = atlasDepth(_bytes, allocator->width(), allocator->format());
+        if (depth != allocator->depth())
+        {
+            allocator->setDepth(depth);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
 void OpenGLRenderer::initializeRectRendering()
 {
     glGenVertexArrays(1, &rectVAO_);
     glBindVertexArray(rectVAO_);
 
-    glGenBuffers(1, &rectVBO_);
-    glBindBuffer(GL_ARRAY_BUFFER, rectVBO_);
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
-
-    auto constexpr BufferStride = 7 * sizeof(GLfloat);
-    auto const VertexOffset = (void const*) (0 * sizeof(GLfloat));
-    auto const ColorOffset = (void const*) (3 * sizeof(GLfloat));
-
-    // 0 (vec3): vertex buffer
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset);
+    // 0 (vec4): target rectangle
     glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
 
-    // 1 (vec4): color buffer
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset);
+    // 1 (vec4): color
     glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
 }
 
 void OpenGLRenderer::initializeTextureRendering()
@@ -289,40 +330,73 @@ void OpenGLRenderer::initializeTextureRendering()
     glGenVertexArrays(1, &vao_);
     glBindVertexArray(vao_);
 
-    auto constexpr BufferStride = (3 + 4 + 4) * sizeof(GLfloat);
-    auto constexpr VertexOffset = (void const*) 0;
-    auto const TexCoordOffset = (void const*) (3 * sizeof(GLfloat));
-    auto const ColorOffset = (void const*) (7 * sizeof(GLfloat));
-
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, 0/* sizeof(GLfloat) * 6 * 11 * 200 * 100*/, nullptr, GL_STREAM_DRAW);
+    // All attributes advance per instance, the quad's corners are derived from gl_VertexID.
 
-    // 0 (vec3): vertex buffer
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset);
+    // 0 (vec4): target rectangle
     glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
 
-    // 1 (vec3): texture coordinates buffer
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, TexCoordOffset);
+    // 1 (vec4): atlas rectangle
     glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
 
-    // 2 (vec4): color buffer
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset);
+    // 2 (vec2): atlas layer and texture selector
     glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    // 3 (vec4): color
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+}
 
-    // setup EBO
-    // glGenBuffers(1, &ebo_);
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    // static const GLuint indices[6] = { 0, 1, 3, 1, 2, 3 };
-    // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+void OpenGLRenderer::initializeGridRendering()
+{
+    // The page's quad is derived from gl_VertexID alone, but a vertex array object must be bound nonetheless.
+    glGenVertexArrays(1, &gridVAO_);
+
+    gridShader_->bind();
+    gridShader_->setUniformValue("u_cells", GridTextureUnit);
+    gridShader_->setUniformValue("u_monochromeTextures", monochromeAtlasAllocator_.instanceBaseId());
+    gridShader_->setUniformValue("u_lcdTextures", lcdAtlasAllocator_.instanceBaseId());
+    gridShader_->release();
+}
 
-    //glVertexAttribDivisor(0, 1); // TODO: later for instanced rendering
+void OpenGLRenderer::setRectAttributes(GLintptr _offset)
+{
+    auto constexpr BufferStride = sizeof(RectInstance);
+    auto const RectOffset = (void const*) (_offset + offsetof(RectInstance, rect));
+    auto const ColorOffset = (void const*) (_offset + offsetof(RectInstance, color));
+
+    glVertexAttribPointer(0, 4, GL_SHORT, GL_FALSE, BufferStride, RectOffset);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, BufferStride, ColorOffset);
+}
+
+void OpenGLRenderer::setTextureAttributes(GLintptr _offset)
+{
+    auto constexpr BufferStride = sizeof(TextureInstance);
+    auto const RectOffset = (void const*) (_offset + offsetof(TextureInstance, rect));
+    auto const TextureRectOffset = (void const*) (_offset + offsetof(TextureInstance, textureRect));
+    auto const LayerOffset = (void const*) (_offset + offsetof(TextureInstance, layer));
+    auto const ColorOffset = (void const*) (_offset + offsetof(TextureInstance, color));
+
+    glVertexAttribPointer(0, 4, GL_SHORT, GL_FALSE, BufferStride, RectOffset);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, GL_TRUE, BufferStride, TextureRectOffset);
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_FALSE, BufferStride, LayerOffset);
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, BufferStride, ColorOffset);
 }
 
 OpenGLRenderer::~OpenGLRenderer()
 {
     glDeleteVertexArrays(1, &rectVAO_);
-    glDeleteBuffers(1, &rectVBO_);
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteVertexArrays(1, &gridVAO_);
+    glDeleteTextures(1, &gridTexture_);
+
+    for (Page const& page : pages_)
+    {
+        glDeleteFramebuffers(1, &page.framebuffer);
+        glDeleteTextures(1, &page.texture);
+    }
 }
 
 void OpenGLRenderer::initialize()
@@ -343,20 +417,35 @@ void OpenGLRenderer::clearCache()
 
 unsigned OpenGLRenderer::maxTextureDepth()
 {
-    initialize();
+    if (!maxTextureDepth_)
+    {
+        initialize();
 
-    GLint value;
-    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &value);
-    return static_cast<unsigned>(value);
+        GLint value;
+        glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &value);
+        maxTextureDepth_ = static_cast<unsigned>(value);
+    }
+    return maxTextureDepth_;
+}
+
+unsigned OpenGLRenderer::atlasDepth(size_t _memoryBudget, unsigned _size, atlas::Format _format)
+{
+    auto const layerSize = size_t{_size} * _size * static_cast<size_t>(atlas::element_count(_format));
+    auto const depth = _memoryBudget / layerSize;
+    return static_cast<unsigned>(clamp(depth, size_t{1}, size_t{maxTextureDepth()}));
 }
 
 unsigned OpenGLRenderer::maxTextureSize()
 {
-    initialize();
+    if (!maxTextureSize_)
+    {
+        initialize();
 
-    GLint value = {};
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
-    return static_cast<unsigned>(value);
+        GLint value = {};
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+        maxTextureSize_ = static_cast<unsigned>(value);
+    }
+    return maxTextureSize_;
 }
 
 void OpenGLRenderer::createAtlas(atlas::CreateAtlas const& _param)
@@ -502,33 +591,274 @@ void OpenGLRenderer::selectTextureUnit(unsigned _id)
 void OpenGLRenderer::renderRectangle(unsigned _x, unsigned _y, unsigned _width, unsigned _height,
                                      float _r, float _g, float _b, float _a)
 {
-    GLfloat const x = _x;
-    GLfloat const y = _y;
-    GLfloat const z = 0.0f;
-    GLfloat const r = _width;
-    GLfloat const s = _height;
-    GLfloat const cr = _r;
-    GLfloat const cg = _g;
-    GLfloat const cb = _b;
-    GLfloat const ca = _a;
-
-    GLfloat const vertices[6 * 7] = {
-        // first triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x,     y,     z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-
-        // second triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-        x + r, y + s, z, cr, cg, cb, ca
+    rectInstances_.emplace_back(RectInstance{
+        {
+            static_cast<GLshort>(_x),
+            static_cast<GLshort>(_y),
+            static_cast<GLshort>(_width),
+            static_cast<GLshort>(_height)
+        },
+        normalizedColor(_r, _g, _b, _a)
+    });
+}
+
+void OpenGLRenderer::renderGrid(GridLayout const& _layout,
+                                std::vector<GridCell> const& _cells,
+                                std::vector<bool> const& _damagedRows)
+{
+    assert(_cells.size() == static_cast<size_t>(_layout.columns * _layout.rows));
+    assert(_damagedRows.size() == static_cast<size_t>(_layout.rows));
+
+    auto const texelsPerRow = 2 * _layout.columns;
+    bool const resized = !gridLayout_.has_value()
+                      || gridLayout_->columns != _layout.columns
+                      || gridLayout_->rows != _layout.rows;
+
+    if (!gridTexture_)
+        glGenTextures(1, &gridTexture_);
+
+    glBindTexture(GL_TEXTURE_2D, gridTexture_);
+
+    if (resized)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, texelsPerRow, _layout.rows, 0,
+                     GL_RGBA_INTEGER, GL_UNSIGNED_INT, _cells.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    else
+    {
+        // Consecutive damaged rows are consecutive in memory, too, and thus uploaded at once.
+        int row = 0;
+        while (row < _layout.rows)
+        {
+            if (!_damagedRows[static_cast<size_t>(row)])
+            {
+                ++row;
+                continue;
+            }
+
+            auto const firstRow = row;
+            while (row < _layout.rows && _damagedRows[static_cast<size_t>(row)])
+                ++row;
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, texelsPerRow, row - firstRow,
+                            GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+                            _cells.data() + firstRow * _layout.columns);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gridLayout_ = _layout;
+    gridScheduled_ = true;
+}
+
+void OpenGLRenderer::bindAtlas(atlas::TextureAtlasAllocator const& _allocator)
+{
+    auto const key = AtlasKey{_allocator.name(), _allocator.instanceBaseId()};
+    if (auto const it = atlasMap_.find(key); it != atlasMap_.end())
+    {
+        selectTextureUnit(_allocator.instanceBaseId());
+        bindTexture2DArray(it->second);
+    }
+}
+
+void OpenGLRenderer::executeRenderGrid()
+{
+    if (!gridScheduled_)
+        return;
+
+    gridScheduled_ = false;
+    auto const& layout = *gridLayout_;
+
+    gridShader_->bind();
+    gridShader_->setUniformValue("u_projection", projectionMatrix_);
+    gridShader_->setUniformValue("u_page", QVector4D(float(layout.x),
+                                                     float(layout.y),
+                                                     float(layout.columns * layout.cellWidth),
+                                                     float(layout.rows * layout.cellHeight)));
+    gridShader_->setUniformValue("u_cellSize", QVector2D(float(layout.cellWidth), float(layout.cellHeight)));
+    gridShader_->setUniformValue("u_underline", QVector2D(float(layout.underlinePosition),
+                                                          float(layout.underlineThickness)));
+
+    bindAtlas(monochromeAtlasAllocator_);
+    bindAtlas(lcdAtlasAllocator_);
+    selectTextureUnit(GridTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, gridTexture_);
+
+    // The grid covers each of its pixels entirely, including the default background's translucency,
+    // so it replaces the previous contents rather than being blended onto them.
+    auto const blending = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    glBindVertexArray(gridVAO_);
+    glDrawArrays(GL_TRIANGLES, 0, VerticesPerInstance);
+    glBindVertexArray(0);
+    if (blending)
+        glEnable(GL_BLEND);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gridShader_->release();
+}
+
+// {{{ retained frames
+OpenGLRenderer::Viewport OpenGLRenderer::currentViewport()
+{
+    Viewport viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    return viewport;
+}
+
+bool OpenGLRenderer::frameRetained()
+{
+    auto const viewport = currentViewport();
+    return pageRetained_ && pageWidth_ == viewport[2] && pageHeight_ == viewport[3];
+}
+
+void OpenGLRenderer::invalidateFrame()
+{
+    pageRetained_ = false;
+}
+
+void OpenGLRenderer::scrollArea(int _x, int _y, int _width, int _height, int _offset)
+{
+    assert(!pendingScroll_.has_value() && "Only one area can be scrolled per frame.");
+    pendingScroll_ = ScrollArea{_x, _y, _width, _height, _offset};
+}
+
+void OpenGLRenderer::clearArea(int _x, int _y, int _width, int _height)
+{
+    pendingClears_.push_back({_x, _y, _width, _height});
+}
+
+std::array<GLint, 4> OpenGLRenderer::toPageArea(int _x, int _y, int _width, int _height) const noexcept
+{
+    // Render coordinates are logical pixels, whereas the page is sized in device pixels.
+    auto const sx = renderWidth_ ? double(pageWidth_) / renderWidth_ : 1.0;
+    auto const sy = renderHeight_ ? double(pageHeight_) / renderHeight_ : 1.0;
+    return {
+        static_cast<GLint>(std::lround(_x * sx)),
+        static_cast<GLint>(std::lround(_y * sy)),
+        static_cast<GLint>(std::lround(_width * sx)),
+        static_cast<GLint>(std::lround(_height * sy))
     };
+}
+
+void OpenGLRenderer::preparePage(Viewport const& _viewport)
+{
+    bool const retained = frameRetained();
+
+    if (pageWidth_ != _viewport[2] || pageHeight_ != _viewport[3])
+    {
+        pageWidth_ = _viewport[2];
+        pageHeight_ = _viewport[3];
+
+        for (Page& page : pages_)
+        {
+            if (!page.framebuffer)
+            {
+                glGenFramebuffers(1, &page.framebuffer);
+                glGenTextures(1, &page.texture);
+            }
+
+            glBindTexture(GL_TEXTURE_2D, page.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pageWidth_, pageHeight_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, page.framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, page.texture, 0);
+            assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        }
+    }
+
+    if (retained)
+        executeScrollArea();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, pages_[0].framebuffer);
+    glViewport(0, 0, pageWidth_, pageHeight_);
 
-    crispy::copy(vertices, back_inserter(rectBuffer_));
+    if (!retained)
+        glClear(GL_COLOR_BUFFER_BIT);
+    else if (!pendingClears_.empty())
+    {
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& [x, y, width, height] : pendingClears_)
+        {
+            auto const area = toPageArea(x, y, width, height);
+            glScissor(area[0], area[1], area[2], area[3]);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    pendingScroll_.reset();
+    pendingClears_.clear();
+}
+
+void OpenGLRenderer::executeScrollArea()
+{
+    if (!pendingScroll_.has_value() || pendingScroll_->offset == 0)
+        return;
+
+    auto const area = toPageArea(pendingScroll_->x, pendingScroll_->y, pendingScroll_->width, pendingScroll_->height);
+    auto const offset = toPageArea(0, pendingScroll_->offset, 0, 0)[1];
+    auto const x0 = area[0];
+    auto const x1 = area[0] + area[2];
+    auto const y0 = area[1];
+    auto const y1 = area[1] + area[3];
+
+    // Blitting within the same framebuffer is undefined for overlapping regions,
+    // hence the page is copied into the other one, which then becomes the current page.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, pages_[0].framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pages_[1].framebuffer);
+    glBlitFramebuffer(0, 0, pageWidth_, pageHeight_,
+                      0, 0, pageWidth_, pageHeight_,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    if (std::abs(offset) < area[3])
+    {
+        if (offset > 0)
+            glBlitFramebuffer(x0, y0, x1, y1 - offset,
+                              x0, y0 + offset, x1, y1,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        else
+            glBlitFramebuffer(x0, y0 - offset, x1, y1,
+                              x0, y0, x1, y1 + offset,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    std::swap(pages_[0], pages_[1]);
+}
+
+void OpenGLRenderer::presentPage(GLuint _targetFramebuffer, Viewport const& _viewport)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, pages_[0].framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _targetFramebuffer);
+    glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+    glBlitFramebuffer(0, 0, pageWidth_, pageHeight_,
+                      _viewport[0], _viewport[1], _viewport[0] + _viewport[2], _viewport[1] + _viewport[3],
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, _targetFramebuffer);
+
+    pageRetained_ = true;
 }
+// }}}
 
 void OpenGLRenderer::execute()
 {
+    // Render on top of the retained page, rather than into the target framebuffer directly.
+    GLint targetFramebuffer{};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+    auto const viewport = currentViewport();
+    preparePage(viewport);
+
+    // Atlases must be up to date before anything that samples them is rendered, starting with the grid.
+    executeUploadTextures();
+
+    executeRenderGrid();
+
     //FIXME
     //glEnable(GL_BLEND);
     //glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
@@ -537,20 +867,22 @@ void OpenGLRenderer::execute()
 
     // render filled rects
     //
-    if (!rectBuffer_.empty())
+    if (!rectInstances_.empty())
     {
         rectShader_->bind();
         rectShader_->setUniformValue(rectProjectionLocation_, projectionMatrix_);
 
         glBindVertexArray(rectVAO_);
-        glBindBuffer(GL_ARRAY_BUFFER, rectVBO_);
-        glBufferData(GL_ARRAY_BUFFER, rectBuffer_.size() * sizeof(GLfloat), rectBuffer_.data(), GL_STREAM_DRAW);
+        auto const offset = rectBuffer_.write(rectInstances_.data(),
+                                              static_cast<GLsizeiptr>(rectInstances_.size() * sizeof(RectInstance)));
+        setRectAttributes(offset);
 
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(rectBuffer_.size() / 7));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, VerticesPerInstance, static_cast<GLsizei>(rectInstances_.size()));
+        rectBuffer_.fence();
 
         rectShader_->release();
         glBindVertexArray(0);
-        rectBuffer_.clear();
+        rectInstances_.clear();
     }
 
     // render textures
@@ -563,14 +895,22 @@ void OpenGLRenderer::execute()
     executeRenderTextures();
 
     textShader_->release();
+
+    presentPage(static_cast<GLuint>(targetFramebuffer), viewport);
+
+    // Textures used by this frame have been rendered and may be evicted from now on.
+    monochromeAtlasAllocator_.nextFrame();
+    coloredAtlasAllocator_.nextFrame();
+    lcdAtlasAllocator_.nextFrame();
 }
 
-void OpenGLRenderer::executeRenderTextures()
+void OpenGLRenderer::executeUploadTextures()
 {
-    // std::cout << fmt::format("OpenGLRenderer::executeRenderTextures() upload={} render={}\n",
-    //     textureScheduler_->uploadTextures.size(),
-    //     textureScheduler_->renderTextures.size()
-    // );
+    // Atlases are destroyed before any others are created, as they may be recreated under the same ID
+    // (see TextureAtlasAllocator::setDepth()).
+    for (auto const& params : textureScheduler_->destroyAtlases)
+        destroyAtlas(params);
+    textureScheduler_->destroyAtlases.clear();
 
     // potentially create new atlases
     for (auto const& params : textureScheduler_->createAtlases)
@@ -580,6 +920,17 @@ void OpenGLRenderer::executeRenderTextures()
     for (auto const& params : textureScheduler_->uploadTextures)
         uploadTexture(params);
 
+    textureScheduler_->createAtlases.clear();
+    textureScheduler_->uploadTextures.clear();
+}
+
+void OpenGLRenderer::executeRenderTextures()
+{
+    // std::cout << fmt::format("OpenGLRenderer::executeRenderTextures() upload={} render={}\n",
+    //     textureScheduler_->uploadTextures.size(),
+    //     textureScheduler_->renderTextures.size()
+    // );
+
     // order and prepare texture geometry
     sort(textureScheduler_->renderTextures.begin(),
          textureScheduler_->renderTextures.end(),
@@ -593,18 +944,14 @@ void OpenGLRenderer::executeRenderTextures()
     {
         glBindVertexArray(vao_);
 
-        // upload buffer
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-        glBufferData(GL_ARRAY_BUFFER,
-                     textureScheduler_->buffer.size() * sizeof(GLfloat),
-                     textureScheduler_->buffer.data(),
-                     GL_STREAM_DRAW);
-
-        glDrawArrays(GL_TRIANGLES, 0, textureScheduler_->vertexCount);
+        auto const& instances = textureScheduler_->instances;
+        auto const offset = textureBuffer_.write(instances.data(),
+                                                 static_cast<GLsizeiptr>(instances.size() * sizeof(TextureInstance)));
+        setTextureAttributes(offset);
 
-        // TODO: Instead of on glDrawArrays (and many if's in the shader for each GL_TEXTUREi),
-        //       make a loop over each GL_TEXTUREi and draw a sub range of the vertices and a
-        //       fixed GL_TEXTURE0. - will this be noticable faster?
+        // Each atlas is bound to its own texture unit, hence all of them are drawn in one go.
+        glDrawArraysInstanced(GL_TRIANGLES, 0, VerticesPerInstance, static_cast<GLsizei>(instances.size()));
+        textureBuffer_.fence();
     }
 
     // destroy any pending atlases that were meant to be destroyed
@@ -15,6 +15,7 @@
 
 #include <terminal_renderer/RenderTarget.h>
 #include <terminal_renderer/Atlas.h>
+#include <terminal_renderer/opengl/StreamingBuffer.h>
 
 #include <terminal/Size.h>
 
@@ -24,7 +25,10 @@
 #include <QtGui/QOpenGLExtraFunctions>
 #include <QtGui/QOpenGLShaderProgram>
 
+#include <array>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace terminal::renderer::opengl {
 
@@ -40,10 +44,12 @@ class OpenGLRenderer :
   public:
     OpenGLRenderer(ShaderConfig const& _textShaderConfig,
                    ShaderConfig const& _rectShaderConfig,
+                   ShaderConfig const& _gridShaderConfig,
                    int _width,
                    int _height,
                    int _leftMargin,
-                   int _bottomMargin);
+                   int _bottomMargin,
+                   size_t _atlasMemoryBudget);
 
     ~OpenGLRenderer() override;
 
@@ -56,9 +62,20 @@ class OpenGLRenderer :
 
     atlas::CommandListener& textureScheduler() override;
 
+    bool setAtlasMemoryBudget(size_t _bytes) override;
+
     void renderRectangle(unsigned _x, unsigned _y, unsigned _width, unsigned _height,
                          float _r, float _g, float _b, float _a) override;
 
+    void renderGrid(GridLayout const& _layout,
+                    std::vector<GridCell> const& _cells,
+                    std::vector<bool> const& _damagedRows) override;
+
+    bool frameRetained() override;
+    void invalidateFrame() override;
+    void scrollArea(int _x, int _y, int _width, int _height, int _offset) override;
+    void clearArea(int _x, int _y, int _width, int _height) override;
+
     void execute() override;
 
     void clearCache() override;
@@ -69,23 +86,46 @@ class OpenGLRenderer :
     void initialize();
     void initializeTextureRendering();
     void initializeRectRendering();
+    void initializeGridRendering();
     unsigned maxTextureDepth();
+    /// @returns number of layers of an atlas of the given size and format to fit into the given memory budget (in bytes).
+    unsigned atlasDepth(size_t _memoryBudget, unsigned _size, atlas::Format _format);
     unsigned maxTextureSize();
     unsigned maxTextureUnits();
 
     void selectTextureUnit(unsigned _id);
     void bindTexture2DArray(GLuint _textureId);
 
+    void executeUploadTextures();
+    void executeRenderGrid();
     void executeRenderTextures();
+    void bindAtlas(atlas::TextureAtlasAllocator const& _allocator);
     void createAtlas(atlas::CreateAtlas const& _param);
     void uploadTexture(atlas::UploadTexture const& _param);
     void renderTexture(atlas::RenderTexture const& _param);
     void destroyAtlas(atlas::DestroyAtlas const& _param);
 
+    void setRectAttributes(GLintptr _offset);
+    void setTextureAttributes(GLintptr _offset);
+
     void executeRenderRectangle(unsigned _x, unsigned _y, unsigned _width, unsigned _height, QVector4D const& _color);
 
+    using Viewport = std::array<GLint, 4>; // x, y, width, height
+    Viewport currentViewport();
+    void preparePage(Viewport const& _viewport);
+    void presentPage(GLuint _targetFramebuffer, Viewport const& _viewport);
+    void executeScrollArea();
+    std::array<GLint, 4> toPageArea(int _x, int _y, int _width, int _height) const noexcept;
+
     // private helper types
     //
+
+    /// Per-instance vertex attributes of a single filled rectangle.
+    struct RectInstance {
+        std::array<GLshort, 4> rect;    // target rectangle (x, y, width, height) in pixels
+        std::array<GLubyte, 4> color;   // normalized RGBA
+    };
+
     struct AtlasKey {
         std::reference_wrapper<std::string const> name;
         unsigned atlasTexture;
@@ -105,8 +145,13 @@ class OpenGLRenderer :
     // private data members
     //
     bool initialized_ = false;
+    unsigned maxTextureDepth_ = 0;  // cached GL_MAX_3D_TEXTURE_SIZE, queried once a GL context is current
+    unsigned maxTextureSize_ = 0;   // cached GL_MAX_TEXTURE_SIZE, ditto
     QMatrix4x4 projectionMatrix_;
 
+    int renderWidth_ = 0;
+    int renderHeight_ = 0;
+
     int leftMargin_ = 0;
     int bottomMargin_ = 0;
 
@@ -116,8 +161,6 @@ class OpenGLRenderer :
     // private data members for rendering textures
     //
     GLuint vao_{};              // Vertex Array Object, covering all buffer objects
-    GLuint vbo_{};              // Buffer containing the vertex coordinates
-    //TODO: GLuint ebo_{};
     std::map<AtlasKey, GLuint> atlasMap_; // maps atlas IDs to texture IDs
     GLuint currentActiveTexture_ = std::numeric_limits<GLuint>::max();
     GLuint currentTextureId_ = std::numeric_limits<GLuint>::max();
@@ -128,11 +171,48 @@ class OpenGLRenderer :
 
     // private data members for rendering filled rectangles
     //
-    std::vector<GLfloat> rectBuffer_;
+    std::vector<RectInstance> rectInstances_;
     std::unique_ptr<QOpenGLShaderProgram> rectShader_;
     GLint rectProjectionLocation_;
     GLuint rectVAO_;
-    GLuint rectVBO_;
+
+    // per-instance vertex data of rectangles and textures, respectively
+    StreamingBuffer rectBuffer_;
+    StreamingBuffer textureBuffer_;
+
+    // private data members for rendering the grid
+    //
+    // The cells are kept in a texture of two RGBA32UI texels per cell, that is only
+    // updated for damaged rows, and resolved into pixels by the grid's fragment shader.
+    std::unique_ptr<QOpenGLShaderProgram> gridShader_;
+    GLuint gridVAO_{};
+    GLuint gridTexture_{};
+    std::optional<GridLayout> gridLayout_;  // layout of the cells in gridTexture_
+    bool gridScheduled_ = false;            // whether or not to render the grid in the current frame
+
+    // private data members for retaining frames
+    //
+    // Frames are rendered into an offscreen page that is kept from frame to frame and
+    // finally copied into the target framebuffer. Scrolling copies the page into
+    // the second one (shifted), which then becomes the current page.
+    struct Page {
+        GLuint framebuffer{};
+        GLuint texture{};
+    };
+    std::array<Page, 2> pages_{};  // current page, and target page for scrolling
+    int pageWidth_ = 0;             // in device pixels
+    int pageHeight_ = 0;            // in device pixels
+    bool pageRetained_ = false;
+
+    struct ScrollArea {
+        int x;
+        int y;
+        int width;
+        int height;
+        int offset;
+    };
+    std::optional<ScrollArea> pendingScroll_;
+    std::vector<std::array<int, 4>> pendingClears_;
 };
 
 } // end namespace
@@ -20,6 +20,8 @@
 
 #include "background_vert.h"
 #include "background_frag.h"
+#include "grid_vert.h"
+#include "grid_frag.h"
 #include "text_vert.h"
 #include "text_frag.h"
 
@@ -45,6 +47,8 @@ ShaderConfig defaultShaderConfig(ShaderClass _shaderClass)
             return {s(background_vert), s(background_frag), "builtin.background.vert", "builtin.background.frag"};
         case ShaderClass::Text:
             return {s(text_vert), s(text_frag), "builtin.text.vert", "builtin.text.frag"};
+        case ShaderClass::Grid:
+            return {s(grid_vert), s(grid_frag), "builtin.grid.vert", "builtin.grid.frag"};
     }
 
     throw std::invalid_argument(fmt::format("ShaderClass<{}>", static_cast<unsigned>(_shaderClass)));
@@ -25,7 +25,8 @@ namespace terminal::renderer::opengl {
 
 enum class ShaderClass {
     Background,
-    Text
+    Text,
+    Grid
 };
 
 struct ShaderConfig {
@@ -43,6 +44,8 @@ inline std::string to_string(ShaderClass _shaderClass)
             return "background";
         case ShaderClass::Text:
             return "text";
+        case ShaderClass::Grid:
+            return "grid";
     }
 
     throw std::invalid_argument(fmt::format("ShaderClass<{}>", static_cast<unsigned>(_shaderClass)));
@@ -0,0 +1,106 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/opengl/StreamingBuffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace terminal::renderer::opengl {
+
+namespace {
+    constexpr GLsizeiptr MinimumRegionSize = 64 * 1024;
+    constexpr GLsizeiptr RegionAlignment = 256;
+    constexpr GLuint64 FenceTimeout = 1'000'000'000; // 1s, in nanoseconds
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    for (GLsync& fence : fences_)
+        if (fence)
+            gl_.glDeleteSync(fence);
+
+    if (buffer_)
+        gl_.glDeleteBuffers(1, &buffer_);
+}
+
+GLintptr StreamingBuffer::write(void const* _data, GLsizeiptr _size)
+{
+    if (!buffer_)
+        gl_.glGenBuffers(1, &buffer_);
+
+    gl_.glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+
+    if (_size > regionSize_)
+        reserve(_size);
+
+    currentRegion_ = (currentRegion_ + 1) % RegionCount;
+    awaitRegion(currentRegion_);
+
+    auto const offset = static_cast<GLintptr>(currentRegion_) * regionSize_;
+    auto constexpr access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (void* target = gl_.glMapBufferRange(GL_ARRAY_BUFFER, offset, _size, access); target != nullptr)
+    {
+        std::memcpy(target, _data, static_cast<size_t>(_size));
+        gl_.glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    else
+        gl_.glBufferSubData(GL_ARRAY_BUFFER, offset, _size, _data);
+
+    return offset;
+}
+
+void StreamingBuffer::fence()
+{
+    GLsync& fence = fences_[static_cast<size_t>(currentRegion_)];
+    if (fence)
+        gl_.glDeleteSync(fence);
+    fence = gl_.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamingBuffer::reserve(GLsizeiptr _regionSize)
+{
+    // Grow geometrically, so that a steadily growing frame size only rarely reallocates.
+    auto const regionSize = std::max({_regionSize, 2 * regionSize_, MinimumRegionSize});
+    regionSize_ = (regionSize + RegionAlignment - 1) / RegionAlignment * RegionAlignment;
+
+    // Any pending reads of the previous storage are taken care of by the driver (orphaning).
+    for (GLsync& fence : fences_)
+    {
+        if (fence)
+            gl_.glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    gl_.glBufferData(GL_ARRAY_BUFFER, regionSize_ * RegionCount, nullptr, GL_STREAM_DRAW);
+    currentRegion_ = RegionCount - 1;
+}
+
+void StreamingBuffer::awaitRegion(int _region)
+{
+    GLsync& fence = fences_[static_cast<size_t>(_region)];
+    if (!fence)
+        return;
+
+    for (;;)
+    {
+        auto const result = gl_.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+        if (result != GL_TIMEOUT_EXPIRED)
+            break;
+    }
+
+    gl_.glDeleteSync(fence);
+    fence = nullptr;
+}
+
+} // end namespace
@@ -0,0 +1,60 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <array>
+
+namespace terminal::renderer::opengl {
+
+/// Vertex buffer for streaming per-frame data to the GPU without implicit synchronization.
+///
+/// The buffer is split into RegionCount equally sized regions that are written round-robin,
+/// one per frame, through an unsynchronized mapping. This neither reallocates the buffer's
+/// storage each frame (as glBufferData would), nor makes the driver wait for the GPU to finish
+/// reading the previous frame's data. Instead, a fence is placed after the draw calls reading
+/// a region, which is only waited for when that region is about to be written again.
+class StreamingBuffer {
+  public:
+    static constexpr int RegionCount = 3;
+
+    explicit StreamingBuffer(QOpenGLExtraFunctions& _gl) : gl_{_gl} {}
+    ~StreamingBuffer();
+
+    StreamingBuffer(StreamingBuffer const&) = delete;
+    StreamingBuffer& operator=(StreamingBuffer const&) = delete;
+
+    /// Copies @p _size bytes of @p _data into the next region and leaves the buffer bound to GL_ARRAY_BUFFER.
+    ///
+    /// @returns the buffer offset the data has been written to.
+    GLintptr write(void const* _data, GLsizeiptr _size);
+
+    /// Guards the region last written to from being overwritten until all GPU commands issued so far have completed.
+    ///
+    /// Must be called after the draw calls reading the data that has been passed to write().
+    void fence();
+
+  private:
+    void reserve(GLsizeiptr _regionSize);
+    void awaitRegion(int _region);
+
+    QOpenGLExtraFunctions& gl_;
+    GLuint buffer_{};
+    GLsizeiptr regionSize_ = 0;
+    int currentRegion_ = RegionCount - 1;
+    std::array<GLsync, RegionCount> fences_{};
+};
+
+} // end namespace
@@ -1,11 +1,20 @@
 uniform mat4 u_projection;
-layout (location = 0) in mediump vec3 vs_vertex;    // target vertex coordinates
+
+// Per-instance attributes, each instance being one rectangle to fill.
+layout (location = 0) in mediump vec4 vs_rect;      // target rectangle (x, y, width, height)
 layout (location = 1) in mediump vec4 vs_colors;    // custom foreground colors
 
 out mediump vec4 fs_textColor;
 
+// Corners of the two triangles forming the rectangle, relative to its bottom left.
+const vec2 corners[6] = vec2[6](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), // left top, left bottom, right bottom
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)  // left top, right bottom, right top
+);
+
 void main()
 {
-    gl_Position = u_projection * vec4(vs_vertex.xyz, 1.0);
+    vec2 corner = corners[gl_VertexID];
+    gl_Position = u_projection * vec4(vs_rect.xy + corner * vs_rect.zw, 0.0, 1.0);
     fs_textColor = vs_colors;
 }
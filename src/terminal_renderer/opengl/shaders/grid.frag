@@ -0,0 +1,77 @@
+// Cell data is unpacked bitwise, which requires 32-bit integers.
+precision highp int;
+precision highp float;
+
+uniform vec2 u_cellSize;
+uniform vec2 u_underline;                       // position (center, relative to the cell's bottom) and thickness
+uniform highp usampler2D u_cells;               // two RGBA32UI texels per cell, top row first
+uniform sampler2DArray u_monochromeTextures;    // R
+uniform sampler2DArray u_lcdTextures;           // RGB
+
+in vec2 fs_position;
+out vec4 fragColor;
+
+// Flags of a cell, see GridCell::Flags.
+const uint Glyph = 1u;
+const uint LcdGlyph = 2u;
+const uint Underline = 4u;
+
+vec4 unpackColor(uint _value)
+{
+    return vec4(float(_value & 0xFFu),
+                float((_value >> 8u) & 0xFFu),
+                float((_value >> 16u) & 0xFFu),
+                float(_value >> 24u)) / 255.0;
+}
+
+ivec2 unpackPair(uint _value)
+{
+    return ivec2(int(_value & 0xFFFFu), int(_value >> 16u));
+}
+
+ivec2 unpackSignedPair(uint _value)
+{
+    ivec2 pair = unpackPair(_value);
+    return pair - ivec2(greaterThanEqual(pair, ivec2(0x8000))) * 0x10000;
+}
+
+// Draws the foreground color with the given (per channel) coverage on top of the given background.
+vec4 blend(vec4 _background, vec4 _foreground, vec3 _coverage)
+{
+    vec3 alpha = _coverage * _foreground.a;
+    float coverage = max(max(alpha.r, alpha.g), alpha.b);
+    return vec4(mix(_background.rgb, _foreground.rgb, alpha), max(_background.a, coverage));
+}
+
+void main()
+{
+    ivec2 cell = ivec2(fs_position / u_cellSize);
+    vec2 inner = fs_position - vec2(cell) * u_cellSize; // relative to the cell's bottom left
+
+    int row = textureSize(u_cells, 0).y - 1 - cell.y;
+    uvec4 colors = texelFetch(u_cells, ivec2(2 * cell.x, row), 0);    // background, foreground, decoration, flags
+    uvec4 glyph = texelFetch(u_cells, ivec2(2 * cell.x + 1, row), 0); // position, layer, size, offset
+    uint flags = colors.w;
+
+    vec4 color = unpackColor(colors.x);
+
+    if ((flags & Glyph) != 0u)
+    {
+        // Glyphs are clipped to their cell.
+        vec2 position = inner - vec2(unpackSignedPair(glyph.w));
+        if (all(greaterThanEqual(position, vec2(0.0))) && all(lessThan(position, vec2(unpackPair(glyph.z)))))
+        {
+            ivec3 texel = ivec3(unpackPair(glyph.x) + ivec2(position), int(glyph.y));
+            vec4 foreground = unpackColor(colors.y);
+            if ((flags & LcdGlyph) != 0u)
+                color = blend(color, foreground, texelFetch(u_lcdTextures, texel, 0).rgb);
+            else
+                color = blend(color, foreground, vec3(texelFetch(u_monochromeTextures, texel, 0).r));
+        }
+    }
+
+    if ((flags & Underline) != 0u && abs(inner.y - u_underline.x) < max(u_underline.y, 1.0) / 2.0)
+        color = blend(color, unpackColor(colors.z), vec3(1.0));
+
+    fragColor = color;
+}
@@ -0,0 +1,16 @@
+uniform mat4 u_projection;
+uniform vec4 u_page;            // page rectangle (x, y, width, height)
+
+out vec2 fs_position;           // position relative to the page's bottom left
+
+// Corners of the two triangles covering the page, relative to its bottom left.
+const vec2 corners[6] = vec2[6](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), // left top, left bottom, right bottom
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)  // left top, right bottom, right top
+);
+
+void main()
+{
+    fs_position = corners[gl_VertexID] * u_page.zw;
+    gl_Position = u_projection * vec4(u_page.xy + fs_position, 0.0, 1.0);
+}
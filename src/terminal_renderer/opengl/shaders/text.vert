@@ -1,16 +1,26 @@
 uniform mat4 vs_projection;                 // projection matrix (flips around the coordinate system)
 
-layout (location = 0) in vec3 vs_vertex;    // target vertex coordinates
-layout (location = 1) in vec4 vs_texCoords; // 3D-atlas texture coordinates
-layout (location = 2) in vec4 vs_colors;    // custom foreground colors
+// Per-instance attributes, each instance being one texture to render.
+layout (location = 0) in vec4 vs_rect;      // target rectangle (x, y, width, height)
+layout (location = 1) in vec4 vs_texRect;   // relative atlas rectangle (x, y, width, height)
+layout (location = 2) in vec2 vs_texLayer;  // atlas layer and texture selector
+layout (location = 3) in vec4 vs_colors;    // custom foreground colors
 
 out vec4 fs_TexCoord;
 out vec4 fs_textColor;
 
+// Corners of the two triangles forming the texture's quad, relative to its bottom left.
+const vec2 corners[6] = vec2[6](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0), // left top, left bottom, right bottom
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)  // left top, right bottom, right top
+);
+
 void main()
 {
-    gl_Position = vs_projection * vec4(vs_vertex.xyz, 1.0);
+    vec2 corner = corners[gl_VertexID];
+
+    gl_Position = vs_projection * vec4(vs_rect.xy + corner * vs_rect.zw, 0.0, 1.0);
 
-    fs_TexCoord = vs_texCoords;
+    fs_TexCoord = vec4(vs_texRect.xy + corner * vs_texRect.zw, vs_texLayer);
     fs_textColor = vs_colors;
 }
@@ -191,9 +191,9 @@ namespace std { // {{{
             auto const f = _key.font.value;
             auto const i = _key.index.value;
             auto const s = int(_key.size.pt * 10.0);
-            return std::size_t(((size_t(f) << 32) & 0xFFFF)
-                             | ((i << 16) & 0xFFFF)
-                             |  (s & 0xFF));
+            return std::size_t(((size_t(f) & 0xFFFF) << 48)
+                             | ((size_t(s) & 0xFFFF) << 32)
+                             |  size_t(i));
         }
     };
 
@@ -28,14 +28,23 @@
 #include <fontconfig/fontconfig.h>
 #include <harfbuzz/hb.h>
 #include <harfbuzz/hb-ft.h>
+#include <harfbuzz/hb-ot.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
 
+using std::array;
+using std::make_unique;
 using std::max;
 using std::move;
 using std::nullopt;
@@ -472,6 +481,35 @@ namespace // {{{ helper
         return optional<FtFacePtr>{FtFacePtr(ftFace, [](FT_Face p) { FT_Done_Face(p); })};
     }
 
+    /// Tests whether the given font substitutes glyphs depending on their neighbours by default,
+    /// such as by ligatures or contextual alternates.
+    bool hasContextualSubstitutions(hb_font_t* _hbFont)
+    {
+        constexpr hb_tag_t ContextualFeatures[] = {
+            HB_TAG('l', 'i', 'g', 'a'), // standard ligatures
+            HB_TAG('c', 'l', 'i', 'g'), // contextual ligatures
+            HB_TAG('c', 'a', 'l', 't'), // contextual alternates
+            HB_TAG('r', 'l', 'i', 'g'), // required ligatures
+        };
+
+        hb_face_t* face = hb_font_get_face(_hbFont);
+        auto tags = array<hb_tag_t, 32>{};
+        unsigned offset = 0;
+        for (;;)
+        {
+            auto count = static_cast<unsigned>(tags.size());
+            hb_ot_layout_table_get_feature_tags(face, HB_OT_TAG_GSUB, offset, &count, tags.data());
+            for (unsigned i = 0; i < count; ++i)
+                if (std::find(std::begin(ContextualFeatures), std::end(ContextualFeatures), tags[i]) != std::end(ContextualFeatures))
+                    return true;
+
+            if (count < tags.size())
+                return false;
+
+            offset += count;
+        }
+    }
+
     void replaceMissingGlyphs(FT_Face _ftFace, shape_result& _result)
     {
         auto const missingGlyph = FT_Get_Char_Index(_ftFace, MissingGlyphId);
@@ -485,6 +523,10 @@ namespace // {{{ helper
     }
 } // }}}
 
+/// Glyph indices of 256 consecutive codepoints, see open_shaper::find_glyph().
+using GlyphPage = array<unsigned, 256>;
+constexpr unsigned UnmappedGlyph = ~0u; // codepoint has not been looked up yet
+
 struct FontInfo
 {
     string path;
@@ -493,7 +535,297 @@ struct FontInfo
     HbFontPtr hbFont;
     font_description description{};
     vector<string> fallbackFonts{};
+
+    optional<bool> directMapping{};             // whether glyphs can be looked up without shaping, determined lazily
+    array<unique_ptr<GlyphPage>, 256> glyphPages{}; // pages of the Basic Multilingual Plane, allocated lazily
+};
+
+/// Rasterizes the given glyph of the given face, which must not be used by any other thread meanwhile.
+optional<rasterized_glyph> rasterizeGlyph(FT_Library _ft, FT_Face _ftFace, glyph_index _glyphIndex, render_mode _mode)
+{
+    FT_Int32 const flags = ftRenderFlag(_mode) | (FT_HAS_COLOR(_ftFace) ? FT_LOAD_COLOR : 0);
+
+    FT_Error ec = FT_Load_Glyph(_ftFace, _glyphIndex.value, flags);
+    if (ec != FT_Err_Ok)
+    {
+        auto const missingGlyph = FT_Get_Char_Index(_ftFace, MissingGlyphId);
+
+        if (missingGlyph)
+            ec = FT_Load_Glyph(_ftFace, missingGlyph, flags);
+
+        if (ec != FT_Err_Ok)
+        {
+            if (crispy::logging_sink::for_debug().enabled())
+            {
+                debuglog(FontFallbackTag).write(
+                    "Error loading glyph index {} for font {} {}. {}",
+                    _glyphIndex.value,
+                    _ftFace->family_name,
+                    _ftFace->style_name,
+                    ftErrorStr(ec)
+                );
+            }
+            return nullopt;
+        }
+    }
+
+    // NB: colored fonts are bitmap fonts, they do not need rendering
+    if (!FT_HAS_COLOR(_ftFace))
+    {
+        if (FT_Render_Glyph(_ftFace->glyph, ftRenderMode(_mode)) != FT_Err_Ok)
+            return nullopt;
+    }
+
+    rasterized_glyph output{};
+    output.width = static_cast<int>(_ftFace->glyph->bitmap.width);
+    output.height = static_cast<int>(_ftFace->glyph->bitmap.rows);
+    output.left = _ftFace->glyph->bitmap_left;
+    output.top = _ftFace->glyph->bitmap_top;
+
+    switch (_ftFace->glyph->bitmap.pixel_mode)
+    {
+        case FT_PIXEL_MODE_MONO:
+        {
+            auto const width = output.width;
+            auto const height = output.height;
+
+            // convert mono to gray
+            FT_Bitmap ftBitmap;
+            FT_Bitmap_Init(&ftBitmap);
+
+            auto const ec = FT_Bitmap_Convert(_ft, &_ftFace->glyph->bitmap, &ftBitmap, 1);
+            if (ec != FT_Err_Ok)
+                return nullopt;
+
+            ftBitmap.num_grays = 256;
+
+            output.format = bitmap_format::alpha_mask;
+            output.bitmap.resize(height * width); // 8-bit channel (with values 0 or 255)
+
+            auto const pitch = abs(ftBitmap.pitch);
+            for (auto i = 0; i < int(ftBitmap.rows); ++i)
+                for (auto j = 0; j < int(ftBitmap.width); ++j)
+                    output.bitmap[i * width + j] = ftBitmap.buffer[(height - 1 - i) * pitch + j] * 255;
+
+            FT_Bitmap_Done(_ft, &ftBitmap);
+            break;
+        }
+        case FT_PIXEL_MODE_GRAY:
+        {
+            output.format = bitmap_format::alpha_mask;
+            output.bitmap.resize(output.height * output.width);
+
+            auto const pitch = _ftFace->glyph->bitmap.pitch;
+            auto const s = _ftFace->glyph->bitmap.buffer;
+            for (auto i = 0; i < output.height; ++i)
+                for (auto j = 0; j < output.width; ++j)
+                    output.bitmap[i * output.width + j] = s[(output.height - 1 - i) * pitch + j];
+            break;
+        }
+        case FT_PIXEL_MODE_LCD:
+        {
+            auto const width = _ftFace->glyph->bitmap.width;
+            auto const height = _ftFace->glyph->bitmap.rows;
+
+            output.format = bitmap_format::rgb; // LCD
+            output.bitmap.resize(width * height);
+            output.width /= 3;
+
+            auto const pitch = _ftFace->glyph->bitmap.pitch;
+            auto s = _ftFace->glyph->bitmap.buffer;
+            for (auto const i : crispy::times(_ftFace->glyph->bitmap.rows))
+                for (auto const j : crispy::times(_ftFace->glyph->bitmap.width))
+                    output.bitmap[i * width + j] = s[(height - 1 - i) * pitch + j];
+            break;
+        }
+        case FT_PIXEL_MODE_BGRA:
+        {
+            auto const width = output.width;
+            auto const height = output.height;
+
+            output.format = bitmap_format::rgba;
+            output.bitmap.resize(height * width * 4);
+            auto t = output.bitmap.begin();
+
+            auto const pitch = _ftFace->glyph->bitmap.pitch;
+            for (auto const i : crispy::times(height))
+            {
+                for (auto const j : crispy::times(width))
+                {
+                    auto const s = &_ftFace->glyph->bitmap.buffer[(height - i - 1) * pitch + j * 4];
+
+                    // BGRA -> RGBA
+                    *t++ = s[2];
+                    *t++ = s[1];
+                    *t++ = s[0];
+                    *t++ = s[3];
+                }
+            }
+            break;
+        }
+        default:
+            debuglog(GlyphRenderTag).write("Glyph requested that has an unsupported pixel_mode:{}", _ftFace->glyph->bitmap.pixel_mode);
+            return nullopt;
+    }
+
+    return output;
+}
+
+// {{{ background rasterization
+/// Number of threads rasterizing glyphs in the background.
+unsigned RasterizerThreadCount() noexcept
+{
+    return std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+}
+
+struct RasterizerJob
+{
+    glyph_key glyph;
+    render_mode mode;
+    string path;        // of the glyph's font, so workers can load their own face of it
+};
+
+struct RasterizerResult
+{
+    glyph_key glyph;
+    render_mode mode;
+    optional<rasterized_glyph> bitmap;
+};
+
+/// Pool of threads rasterizing glyphs in the background.
+///
+/// FreeType objects must not be used by multiple threads at once, so each worker loads its own
+/// faces of the fonts it is asked for, within its own FreeType library instance.
+class Rasterizer
+{
+  public:
+    Rasterizer(vec2 _dpi, unsigned _threadCount) :
+        dpi_{ _dpi }
+    {
+        for (unsigned i = 0; i < _threadCount; ++i)
+            threads_.emplace_back([this]() { work(); });
+    }
+
+    ~Rasterizer()
+    {
+        {
+            auto const _l = std::scoped_lock{lock_};
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+
+        for (std::thread& thread : threads_)
+            thread.join();
+    }
+
+    void request(RasterizerJob _job)
+    {
+        {
+            auto const _l = std::scoped_lock{lock_};
+            jobs_.emplace_back(move(_job));
+        }
+        wakeup_.notify_one();
+    }
+
+    void collect(shaper::rasterized_callback const& _callback)
+    {
+        {
+            auto const _l = std::scoped_lock{lock_};
+            swap(results_, collected_);
+        }
+
+        for (RasterizerResult& result : collected_)
+            _callback(result.glyph, result.mode, move(result.bitmap));
+        collected_.clear();
+    }
+
+    /// Drops all pending jobs and uncollected results, and makes the workers release their faces.
+    void discard()
+    {
+        {
+            auto const _l = std::scoped_lock{lock_};
+            jobs_.clear();
+            results_.clear();
+            ++generation_;
+        }
+        wakeup_.notify_all();
+    }
+
+  private:
+    void work()
+    {
+        FT_Library ft{};
+        if (FT_Init_FreeType(&ft) != FT_Err_Ok)
+            return;
+
+#if defined(FT_LCD_FILTER_DEFAULT)
+        FT_Library_SetLcdFilter(ft, FT_LCD_FILTER_DEFAULT);
+#endif
+
+        // loaded lazily, and nullptr if loading failed
+        auto faces = std::unordered_map<font_key, FT_Face>{};
+        auto generation = uint64_t{0}; // see discard()
+
+        auto const releaseFaces = [&]() {
+            for (auto const& face : faces)
+                if (face.second)
+                    FT_Done_Face(face.second);
+            faces.clear();
+        };
+
+        for (;;)
+        {
+            auto _l = std::unique_lock{lock_};
+            wakeup_.wait(_l, [&]() { return stopping_ || !jobs_.empty() || generation != generation_; });
+            if (stopping_)
+                break;
+
+            if (generation != generation_)
+            {
+                // The fonts may not be needed anymore (e.g. after zooming), they are loaded again on demand.
+                generation = generation_;
+                _l.unlock();
+                releaseFaces();
+                continue;
+            }
+
+            RasterizerJob job = move(jobs_.front());
+            jobs_.pop_front();
+            _l.unlock();
+
+            auto face = faces.find(job.glyph.font);
+            if (face == faces.end())
+            {
+                auto loaded = loadFace(job.path, job.glyph.size, dpi_, ft);
+                face = faces.emplace(job.glyph.font, loaded.has_value() ? loaded.value().release() : nullptr).first;
+            }
+
+            auto bitmap = face->second ? rasterizeGlyph(ft, face->second, job.glyph.index, job.mode)
+                                       : nullopt;
+
+            _l.lock();
+            if (generation == generation_)
+                results_.emplace_back(RasterizerResult{job.glyph, job.mode, move(bitmap)});
+        }
+
+        releaseFaces();
+        FT_Done_FreeType(ft);
+    }
+
+    vec2 const dpi_;
+
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::deque<RasterizerJob> jobs_;
+    std::vector<RasterizerResult> results_;
+    uint64_t generation_ = 0;   // incremented by discard(), results of jobs taken before are dropped
+    bool stopping_ = false;
+
+    std::vector<RasterizerResult> collected_;   // only accessed by collect(), to reuse its storage
+
+    std::vector<std::thread> threads_;
 };
+// }}}
 
 struct open_shaper::Private // {{{
 {
@@ -509,6 +841,8 @@ struct open_shaper::Private // {{{
     HbBufferPtr hb_buf_;
     font_key nextFontKey_;
 
+    unique_ptr<Rasterizer> rasterizer_;             // created on first use
+
     font_key create_font_key()
     {
         auto result = nextFontKey_;
@@ -577,6 +911,8 @@ struct open_shaper::Private // {{{
 
     ~Private()
     {
+        rasterizer_.reset();
+
         FT_Done_FreeType(ft_);
 
         FcFini();
@@ -714,137 +1050,76 @@ void open_shaper::shape(font_key _font,
     replaceMissingGlyphs(fontInfo.ftFace.get(), _result);
 }
 
-optional<rasterized_glyph> open_shaper::rasterize(glyph_key _glyph, render_mode _mode)
+optional<glyph_position> open_shaper::map_codepoint(font_key _font, char32_t _codepoint)
 {
-    auto const font = _glyph.font;
-    auto ftFace = d->fonts_.at(font).ftFace.get();
-    auto const glyphIndex = _glyph.index;
-    FT_Int32 const flags = ftRenderFlag(_mode) | (has_color(font) ? FT_LOAD_COLOR : 0);
-
-    FT_Error ec = FT_Load_Glyph(ftFace, glyphIndex.value, flags);
-    if (ec != FT_Err_Ok)
-    {
-        auto const missingGlyph = FT_Get_Char_Index(ftFace, MissingGlyphId);
-
-        if (missingGlyph)
-            ec = FT_Load_Glyph(ftFace, missingGlyph, flags);
-
-        if (ec != FT_Err_Ok)
-        {
-            if (crispy::logging_sink::for_debug().enabled())
-            {
-                debuglog(FontFallbackTag).write(
-                    "Error loading glyph index {} for font {} {}. {}",
-                    glyphIndex.value,
-                    ftFace->family_name,
-                    ftFace->style_name,
-                    ftErrorStr(ec)
-                );
-            }
-            return nullopt;
-        }
-    }
-
-    // NB: colored fonts are bitmap fonts, they do not need rendering
-    if (!FT_HAS_COLOR(ftFace))
-    {
-        if (FT_Render_Glyph(ftFace->glyph, ftRenderMode(_mode)) != FT_Err_Ok)
-            return nullopt;
-    }
-
-    rasterized_glyph output{};
-    output.width = static_cast<int>(ftFace->glyph->bitmap.width);
-    output.height = static_cast<int>(ftFace->glyph->bitmap.rows);
-    output.left = ftFace->glyph->bitmap_left;
-    output.top = ftFace->glyph->bitmap_top;
+    if (_codepoint > 0xFFFF)
+        return nullopt;
 
-    switch (ftFace->glyph->bitmap.pixel_mode)
-    {
-        case FT_PIXEL_MODE_MONO:
-        {
-            auto const width = output.width;
-            auto const height = output.height;
+    FontInfo& fontInfo = d->fonts_.at(_font);
+    if (!fontInfo.directMapping.has_value())
+        fontInfo.directMapping = !hasContextualSubstitutions(fontInfo.hbFont.get());
 
-            // convert mono to gray
-            FT_Bitmap ftBitmap;
-            FT_Bitmap_Init(&ftBitmap);
+    if (!fontInfo.directMapping.value())
+        return nullopt;
 
-            auto const ec = FT_Bitmap_Convert(d->ft_, &ftFace->glyph->bitmap, &ftBitmap, 1);
-            if (ec != FT_Err_Ok)
-                return nullopt;
+    auto const glyph = find_glyph(_font, _codepoint);
+    if (!glyph.has_value())
+        return nullopt;
 
-            ftBitmap.num_grays = 256;
+    return glyph_position{glyph.value(), 0, 0};
+}
 
-            output.format = bitmap_format::alpha_mask;
-            output.bitmap.resize(height * width); // 8-bit channel (with values 0 or 255)
+optional<glyph_key> open_shaper::find_glyph(font_key _font, char32_t _codepoint)
+{
+    FontInfo& fontInfo = d->fonts_.at(_font);
 
-            auto const pitch = abs(ftBitmap.pitch);
-            for (auto i = 0; i < int(ftBitmap.rows); ++i)
-                for (auto j = 0; j < int(ftBitmap.width); ++j)
-                    output.bitmap[i * width + j] = ftBitmap.buffer[(height - 1 - i) * pitch + j] * 255;
+    auto const glyph = [&]() -> unsigned {
+        if (_codepoint > 0xFFFF)
+            return FT_Get_Char_Index(fontInfo.ftFace.get(), _codepoint);
 
-            FT_Bitmap_Done(d->ft_, &ftBitmap);
-            break;
-        }
-        case FT_PIXEL_MODE_GRAY:
+        auto& page = fontInfo.glyphPages[_codepoint >> 8];
+        if (!page)
         {
-            output.format = bitmap_format::alpha_mask;
-            output.bitmap.resize(output.height * output.width);
-
-            auto const pitch = ftFace->glyph->bitmap.pitch;
-            auto const s = ftFace->glyph->bitmap.buffer;
-            for (auto i = 0; i < output.height; ++i)
-                for (auto j = 0; j < output.width; ++j)
-                    output.bitmap[i * output.width + j] = s[(output.height - 1 - i) * pitch + j];
-            break;
+            page = make_unique<GlyphPage>();
+            page->fill(UnmappedGlyph);
         }
-        case FT_PIXEL_MODE_LCD:
-        {
-            auto const width = ftFace->glyph->bitmap.width;
-            auto const height = ftFace->glyph->bitmap.rows;
 
-            output.format = bitmap_format::rgb; // LCD
-            output.bitmap.resize(width * height);
-            output.width /= 3;
+        auto& cached = (*page)[_codepoint & 0xFF];
+        if (cached == UnmappedGlyph)
+            cached = FT_Get_Char_Index(fontInfo.ftFace.get(), _codepoint);
+        return cached;
+    }();
 
-            auto const pitch = ftFace->glyph->bitmap.pitch;
-            auto s = ftFace->glyph->bitmap.buffer;
-            for (auto const i : crispy::times(ftFace->glyph->bitmap.rows))
-                for (auto const j : crispy::times(ftFace->glyph->bitmap.width))
-                    output.bitmap[i * width + j] = s[(height - 1 - i) * pitch + j];
-            break;
-        }
-        case FT_PIXEL_MODE_BGRA:
-        {
-            auto const width = output.width;
-            auto const height = output.height;
+    if (!glyph)
+        return nullopt;
 
-            output.format = bitmap_format::rgba;
-            output.bitmap.resize(height * width * 4);
-            auto t = output.bitmap.begin();
+    return glyph_key{_font, fontInfo.size, glyph_index{glyph}};
+}
 
-            auto const pitch = ftFace->glyph->bitmap.pitch;
-            for (auto const i : crispy::times(height))
-            {
-                for (auto const j : crispy::times(width))
-                {
-                    auto const s = &ftFace->glyph->bitmap.buffer[(height - i - 1) * pitch + j * 4];
+optional<rasterized_glyph> open_shaper::rasterize(glyph_key _glyph, render_mode _mode)
+{
+    return rasterizeGlyph(d->ft_, d->fonts_.at(_glyph.font).ftFace.get(), _glyph.index, _mode);
+}
 
-                    // BGRA -> RGBA
-                    *t++ = s[2];
-                    *t++ = s[1];
-                    *t++ = s[0];
-                    *t++ = s[3];
-                }
-            }
-            break;
-        }
-        default:
-            debuglog(GlyphRenderTag).write("Glyph requested that has an unsupported pixel_mode:{}", ftFace->glyph->bitmap.pixel_mode);
-            return nullopt;
-    }
+bool open_shaper::rasterize_async(glyph_key _glyph, render_mode _mode)
+{
+    if (!d->rasterizer_)
+        d->rasterizer_ = make_unique<Rasterizer>(d->dpi_, RasterizerThreadCount());
 
-    return output;
+    d->rasterizer_->request(RasterizerJob{_glyph, _mode, d->fonts_.at(_glyph.font).path});
+    return true;
+}
+
+void open_shaper::collect_rasterized(rasterized_callback const& _callback)
+{
+    if (d->rasterizer_)
+        d->rasterizer_->collect(_callback);
+}
+
+void open_shaper::discard_rasterized()
+{
+    if (d->rasterizer_)
+        d->rasterizer_->discard();
 }
 
 } // end namespace
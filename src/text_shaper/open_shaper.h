@@ -38,8 +38,18 @@ class open_shaper : public shaper {
                unicode::Script _script,
                shape_result& _result) override;
 
+    std::optional<glyph_position> map_codepoint(font_key _font, char32_t _codepoint) override;
+
+    std::optional<glyph_key> find_glyph(font_key _font, char32_t _codepoint) override;
+
     std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) override;
 
+    bool rasterize_async(glyph_key _glyph, render_mode _mode) override;
+
+    void collect_rasterized(rasterized_callback const& _callback) override;
+
+    void discard_rasterized() override;
+
     bool has_color(font_key _font) const override;
 
   private:
@@ -108,6 +108,31 @@ class shaper {
                        unicode::Script _script,
                        shape_result& _result) = 0;
 
+    /**
+     * Looks up the glyph of a single codepoint directly from the font's character map,
+     * bypassing text shaping.
+     *
+     * This is only possible for fonts that do not substitute glyphs depending on their
+     * neighbours by default (such as ligatures or contextual alternates), and for codepoints
+     * that are neither part of a complex script nor combining, which the caller must ensure.
+     *
+     * @returns the glyph, positioned just like shape() would, or std::nullopt if the codepoint
+     *          must be shaped instead, which includes the font lacking a glyph for it (so that
+     *          font fallback applies).
+     */
+    virtual std::optional<glyph_position> map_codepoint(font_key _font, char32_t _codepoint) = 0;
+
+    /**
+     * Looks up the glyph of a single codepoint in the font's character map,
+     * without text shaping nor font fallback.
+     *
+     * Unlike map_codepoint(), this works for any font, but the glyph is not necessarily
+     * the one that shape() results in, e.g. due to ligatures.
+     *
+     * @returns the glyph, or std::nullopt if the font lacks a glyph for the given codepoint.
+     */
+    virtual std::optional<glyph_key> find_glyph(font_key _font, char32_t _codepoint) = 0;
+
     /**
      * Rasterizes (renders) the glyph using the given render mode.
      *
@@ -116,6 +141,31 @@ class shaper {
      */
     virtual std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) = 0;
 
+    using rasterized_callback = std::function<void(glyph_key, render_mode, std::optional<rasterized_glyph>)>;
+
+    /**
+     * Requests the glyph to be rasterized in the background, to be picked up via collect_rasterized().
+     *
+     * @param _glyph glyph identifier.
+     * @param _mode  render technique to use.
+     *
+     * @returns false if rasterizing in the background is not supported, in which case rasterize()
+     *          must be used instead.
+     */
+    virtual bool rasterize_async(glyph_key _glyph, render_mode _mode) = 0;
+
+    /**
+     * Invokes @p _callback for each glyph that has been rasterized in the background
+     * since the last call.
+     */
+    virtual void collect_rasterized(rasterized_callback const& _callback) = 0;
+
+    /**
+     * Discards all glyphs requested via rasterize_async() that have not been collected yet,
+     * along with any font resources held for rasterizing glyphs in the background.
+     */
+    virtual void discard_rasterized() = 0;
+
     virtual bool has_color(font_key _font) const = 0;
 };
 